@@ -18,14 +18,16 @@
 #include "../vse/output/WasapiOutputDevice.h"
 
 #include "../vse/loader/WaveFileLoader.h"
+#include "../vse/processing/FusedProcessorChain.h"
 #include "../vse/processing/HardLimiter.h"
 #include "../vse/processing/WaveFormatConverter.h"
 #include "../vse/processing/WaveSourceWithProcessing.h"
-#include "../vse/processing/DirectSoundAudioEffectDsp.h"
+#include "../vse/processing/AudioEffectDsp.h"
 #include "../vse/pipeline/VolumeCalculation.h"
 #include "../vse/pipeline/SimpleVoice.h"
 #include "../vse/pipeline/StereoWaveMixer.h"
 #include "../vse/pipeline/SourceSwitcher.h"
+#include "../vse/pipeline/WaveSourceTee.h"
 
 #include "./utils/BmsFile.h"
 #include "./utils/BmsEvent.h"
@@ -80,18 +82,27 @@ int wmain(int argc, const wchar_t* argv[])
         std::shared_ptr<vse::IWaveSource> mixer_block_out = limiter;
 
         // effector block
-        std::shared_ptr<vse::IWaveSource> effector_in = mixer_block_out;
-        std::shared_ptr<vse::IWaveSource> s0 = effector_in;
-        std::shared_ptr<vse::IWaveSourceWithProcessing> s1 = vse::CreateSourceWithProcessing(effector_in, vse::CreateEchoEffector(effector_in->GetFormat()));
-        std::shared_ptr<vse::IWaveSourceWithProcessing> s2 = vse::CreateSourceWithProcessing(effector_in, vse::CreateGargleEffector(effector_in->GetFormat()));
-        std::shared_ptr<vse::IWaveSourceWithProcessing> s3 = vse::CreateSourceWithProcessing(effector_in, vse::CreateDistortionEffector(effector_in->GetFormat()));
-        std::shared_ptr<vse::IWaveSourceWithProcessing> s4 = vse::CreateSourceWithProcessing(effector_in, vse::CreateWavesReverbEffector(effector_in->GetFormat()));
-        std::shared_ptr<vse::IWaveSourceWithProcessing> s5 = vse::CreateSourceWithProcessing(effector_in, vse::CreateChorusEffector(effector_in->GetFormat()));
-        std::shared_ptr<vse::IWaveSourceWithProcessing> s6 = vse::CreateSourceWithProcessing(effector_in, vse::CreateFlangerEffector(effector_in->GetFormat()));
-        std::shared_ptr<vse::ISourceSwitcher> effector_switch = vse::CreateSourceSwitcher(s0);
-        std::shared_ptr<vse::IWaveSourceWithProcessing> post_limiter = vse::CreateSourceWithProcessing(effector_switch, vse::CreateHardLimiter(effector_switch->GetFormat(), {vse::DecibelToLinear(-0.0f), vse::DecibelToLinear(-0.1f)}));
-        std::shared_ptr<vse::IWaveSource> effector_out = post_limiter;
-        std::shared_ptr<vse::IWaveSource> device_source_in = vse::CreateSourceWithProcessing(effector_out, vse::CreateFormatConverter(effector_out->GetFormat(), device->GetFormat()));
+        // each branch reads its own tee output, so the mixer is rendered once for any number of branches.
+        std::shared_ptr<vse::IWaveSourceTee> effector_in = vse::CreateWaveSourceTee(mixer_block_out);
+        std::shared_ptr<vse::IWaveSource> s0 = effector_in->CreateOutput();
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s1 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateEchoEffect(effector_in->GetFormat()));
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s2 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateGargleEffect(effector_in->GetFormat()));
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s3 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateDistortionEffect(effector_in->GetFormat()));
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s4 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateReverbEffect(effector_in->GetFormat()));
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s5 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateChorusEffect(effector_in->GetFormat()));
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s6 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateFlangerEffect(effector_in->GetFormat()));
+        std::shared_ptr<vse::IWaveSourceWithProcessing> s7 = vse::CreateSourceWithProcessing(effector_in->CreateOutput(), vse::CreateFusedProcessorChain({
+            vse::CreateChorusEffect(effector_in->GetFormat()),
+            vse::CreateEchoEffect(effector_in->GetFormat()),
+        })); // planar effects in a row: run on planar tiles, deinterleaved once for both.
+        std::shared_ptr<vse::ISourceSwitcher> effector_switch = vse::CreateSourceSwitcher(s0, 20.0f);
+        std::shared_ptr<vse::IWaveSource> effector_out = effector_switch;
+
+        // post limiter and device format conversion (fused into one pass if only bit-depth differs)
+        std::shared_ptr<vse::IWaveSource> device_source_in = vse::CreateSourceWithProcessing(effector_out, vse::CreateFusedProcessorChain({
+            vse::CreateHardLimiter(effector_out->GetFormat(), {vse::DecibelToLinear(-0.0f), vse::DecibelToLinear(-0.1f)}),
+            vse::CreateFormatConverter(effector_out->GetFormat(), device->GetFormat()),
+        }));
 
         // Loading seq file
         auto loading_start_timestamp = std::chrono::high_resolution_clock::now();
@@ -360,6 +371,7 @@ int wmain(int argc, const wchar_t* argv[])
             if (::GetAsyncKeyState('4') & 1) { effector_switch->Assign(s4), s4->GetAttachedProcessor()->Discontinuity(), std::clog << "\x1b[K Effector is switched to REVERB." << "\n"; }
             if (::GetAsyncKeyState('5') & 1) { effector_switch->Assign(s5), s5->GetAttachedProcessor()->Discontinuity(), std::clog << "\x1b[K Effector is switched to CHORUS." << "\n"; }
             if (::GetAsyncKeyState('6') & 1) { effector_switch->Assign(s6), s6->GetAttachedProcessor()->Discontinuity(), std::clog << "\x1b[K Effector is switched to FLANGER." << "\n"; }
+            if (::GetAsyncKeyState('7') & 1) { effector_switch->Assign(s7), s7->GetAttachedProcessor()->Discontinuity(), std::clog << "\x1b[K Effector is switched to CHORUS + ECHO." << "\n"; }
 
             // Input: key on. // TODO: from input thread
             if (::GetAsyncKeyState('Q') & 1) { manual_play ^= true; }
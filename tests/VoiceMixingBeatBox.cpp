@@ -15,6 +15,7 @@
 #include "../vse/processing/WaveFormatConverter.h"
 #include "../vse/processing/WaveSourceWithProcessing.h"
 #include "../vse/processing/DirectSoundAudioEffectDsp.h"
+#include "../vse/processing/DynamicsProcessor.h"
 #include "../vse/processing/HardLimiter.h"
 #include "../vse/pipeline/VolumeCalculation.h"
 #include "../vse/pipeline/SimpleVoice.h"
@@ -112,7 +113,7 @@ int main()
         auto master_mixer = CreateStereoWaveMixer(processing_format);
         master_mixer->RegisterSource(reverb_effector);
         master_mixer->RegisterSource(cmpres_effector);
-        auto master_compressor = CreateSourceWithProcessing(master_mixer, CreateCompressorEffector(processing_format, {-4.0f, 10.0f, 50.0f, -24.0f, 4.0f, 0.0f}));
+        auto master_compressor = CreateSourceWithProcessing(master_mixer, CreateDynamicsProcessor(processing_format, {vse::DynamicsMode::Compressor, -24.0f, 4.0f, 0.0f, 10.0f, 50.0f, -4.0f, true}));
         auto master_limiter = CreateSourceWithProcessing(master_compressor, CreateHardLimiter(processing_format, {1.0f, 0.98f}));
         auto master_output = vse::ConvertWaveFormat(master_limiter, device_format_pcm);
 
@@ -9,9 +9,19 @@
 
 #include "Interface.h"
 #include "WaveFormat.h"
+#include "PlanarBlock.h"
 
 namespace vse
 {
+    /// Describes how a WaveProcessor uses buffers.
+    struct WaveProcessorCapabilities
+    {
+        bool in_place = false;     ///< reads the source into destination_buffer and processes it there, without staging samples in its own buffer.
+        bool same_format = false;  ///< the input format is the same as the output format.
+        size_t latency_frames = 0; ///< delay of the output from the input in output frames.
+        double max_expansion = 1;  ///< the maximum ratio of output bytes to input bytes. the input fits in destination_buffer if >= 1.
+    };
+
     /// Represents a WaveProcessor
     class IWaveProcessor : protected virtual Interface
     {
@@ -22,6 +32,17 @@ namespace vse
         /// Gets Processor Output format
         [[nodiscard]] virtual PcmWaveFormat GetOutputFormat() const = 0;
 
+        /// Gets the capabilities. The default is the conservative one: staged in its own buffer, no latency.
+        [[nodiscard]] virtual WaveProcessorCapabilities GetCapabilities() const
+        {
+            const PcmWaveFormat in = GetInputFormat();
+            const PcmWaveFormat out = GetOutputFormat();
+            WaveProcessorCapabilities caps{};
+            caps.same_format = in == out;
+            caps.max_expansion = in.AvgBytesPerSec() > 0 ? static_cast<double>(out.AvgBytesPerSec()) / in.AvgBytesPerSec() : 1.0;
+            return caps;
+        }
+
         /// Process wave data
         /// @param read_source Source reader callback
         /// @param context Source reader callback context
@@ -47,6 +68,24 @@ namespace vse
 
         /// Notify discontinuity
         virtual void Discontinuity() {}
+
+        /// Prepares for Process calls of up to max_output_frames frames of destination, before rendering.
+        /// Processors allocate their work buffers here, so that Process does not allocate in steady state.
+        /// Must not be called concurrently with Process.
+        /// @returns The maximum frames requested from read_source in one call.
+        virtual size_t Prepare(size_t max_output_frames) { return max_output_frames; }
+    };
+
+    /// Implemented by processors which prefer planar blocks: they access each channel contiguously.
+    /// A chain runner may call ProcessPlanar instead of Process on a run of such processors,
+    /// deinterleaving and interleaving only at the edges of the run (see CreateFusedProcessorChain).
+    /// The input and output formats must be the same F32 format.
+    class IPlanarWaveProcessor : protected virtual Interface
+    {
+    public:
+        /// Processes the block in place. block.channels is the channel count of the format.
+        /// Process and ProcessPlanar may be mixed; both continue the same stream.
+        virtual void ProcessPlanar(const PlanarBlock& block) = 0;
     };
 
     /// Represents a Parameter store
@@ -21,6 +21,11 @@ namespace vse
         /// @param buffer_length Destination buffer length in bytes.
         /// @returns The number of bytes read to the buffer.
         [[nodiscard]] virtual size_t Read(void* buffer, size_t buffer_length) = 0;
+
+        /// Prepares for reads of up to max_frames frames at once, before rendering.
+        /// Sources allocate their work buffers here and pass it on to their upstream, so that Read does not allocate in steady state.
+        /// Must not be called concurrently with Read. Calling again with a larger value grows the buffers.
+        virtual void Prepare([[maybe_unused]] size_t max_frames) {}
     };
 
     /// Represents a seekable readonly wave source
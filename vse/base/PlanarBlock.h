@@ -0,0 +1,30 @@
+/// @file
+/// @brief  Vse - Planar (non-interleaved) sample block
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <cstddef>
+
+#include "CommonTypes.h"
+
+namespace vse
+{
+    /// Non-interleaved F32 samples: the samples of each channel are contiguous, and each channel starts at a 64-byte boundary.
+    /// Sample i of channel c is at data[c * stride + i].
+    struct PlanarBlock
+    {
+        static constexpr size_t Alignment = 64;                    ///< in bytes
+        static constexpr size_t AlignmentSamples = Alignment / sizeof(F32);
+
+        F32* data{};       ///< the first channel. aligned to Alignment.
+        size_t stride{};   ///< samples from a channel to the next. a multiple of AlignmentSamples.
+        size_t channels{};
+        size_t frames{};
+
+        [[nodiscard]] F32* Channel(size_t c) const noexcept { return data + c * stride; }
+
+        /// Gets the stride for the frame count: rounded up to the alignment.
+        [[nodiscard]] static constexpr size_t StrideFor(size_t frames) noexcept { return (frames + AlignmentSamples - 1) / AlignmentSamples * AlignmentSamples; }
+    };
+}
@@ -5,6 +5,7 @@
 #include "RandomAccessWaveBuffer.h"
 
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <utility>
 #include <algorithm>
@@ -33,6 +34,51 @@ namespace vse
         return std::make_shared<RandomAccessWaveBufferImpl>(format);
     }
 
+    std::shared_ptr<IRandomAccessWaveBuffer> AttachWaveBuffer(std::shared_ptr<void> memory, size_t length, PcmWaveFormat format)
+    {
+        class AttachedWaveBufferImpl : public IRandomAccessWaveBuffer
+        {
+            PcmWaveFormat format_{};
+            std::shared_ptr<void> memory_{};
+            std::byte* data_{};
+            size_t capacity_{};
+            size_t size_{};
+
+        public:
+            AttachedWaveBufferImpl(std::shared_ptr<void> memory, size_t length, const PcmWaveFormat& format)
+                : format_(format)
+                , memory_(std::move(memory))
+                , data_(static_cast<std::byte*>(memory_.get()))
+                , capacity_(length)
+                , size_(length) {}
+
+            [[nodiscard]] PcmWaveFormat GetFormat() const override { return format_; }
+
+            [[nodiscard]] size_t Read(void* buffer, size_t cursor, size_t length) const noexcept override
+            {
+                if (cursor >= size_) return 0;
+                length = std::min(length, size_ - cursor);
+                std::memcpy(buffer, data_ + cursor, length);
+                return length;
+            }
+
+            [[nodiscard]] size_t Write(const void* buffer, size_t cursor, size_t length) noexcept override
+            {
+                // the attached memory can't grow.
+                if (cursor >= capacity_) return 0;
+                length = std::min(length, capacity_ - cursor);
+                std::memcpy(data_ + cursor, buffer, length);
+                size_ = std::max(size_, cursor + length);
+                return length;
+            }
+
+            [[nodiscard]] size_t Size() const override { return size_; }
+            [[nodiscard]] size_t Resize(size_t length) override { return size_ = std::min(length, capacity_); }
+        };
+
+        return std::make_shared<AttachedWaveBufferImpl>(std::move(memory), length, format);
+    }
+
     std::shared_ptr<IRandomAccessWaveBuffer> ReadOutToMemory(std::shared_ptr<IWaveSource> input)
     {
         if (!input) return nullptr;
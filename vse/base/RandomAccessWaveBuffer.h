@@ -11,6 +11,7 @@
 namespace vse
 {
     [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> AllocateWaveBuffer(PcmWaveFormat format);
+    [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> AttachWaveBuffer(std::shared_ptr<void> memory, size_t length, PcmWaveFormat format); // fixed capacity, no copy.
     [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> ReadOutToMemory(std::shared_ptr<IWaveSource> input);
     [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> DuplicateBuffer(std::shared_ptr<IRandomAccessWaveBuffer> source);
     [[nodiscard]] std::shared_ptr<ISeekableWaveSource> AllocateReadCursor(std::shared_ptr<IRandomAccessWaveBuffer> buffer);
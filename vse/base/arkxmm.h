@@ -199,6 +199,7 @@ namespace arkana::xmm
     template <class XMM> ARKXMM_API load_s(const void* src) -> enable::if_iXMM<XMM> { return XMM{_mm_stream_load_si128(&const_cast<XMM*>(static_cast<const XMM*>(src))->v)}; } // SSE4.1
     template <class XMM> ARKXMM_API load_s(const void* src) -> enable::if_f32x4<XMM> { return XMM{_mm_load_ps(static_cast<const vf32x4::element_t*>(src))}; }                  // SSE
     template <class XMM> ARKXMM_API load_s(const void* src) -> enable::if_f64x2<XMM> { return XMM{_mm_load_pd(static_cast<const vf64x2::element_t*>(src))}; }                  // SSE2
+    template <class XMM> ARKXMM_API load_lo64(const void* src) -> enable::if_f32x4<XMM> { return XMM{_mm_loadl_pi(_mm_setzero_ps(), static_cast<const __m64*>(src))}; }    // SSE  loads 2 floats into lower half, upper half is zero.
     template <class YMM> ARKXMM_API load_u(const void* src) -> enable::if_iYMM<YMM> { return YMM{_mm256_lddqu_si256(&static_cast<const YMM*>(src)->v)}; }                      // AVX
     template <class YMM> ARKXMM_API load_u(const void* src) -> enable::if_f32x8<YMM> { return YMM{_mm256_loadu_ps(static_cast<const vf32x4::element_t*>(src))}; }              // SSE
     template <class YMM> ARKXMM_API load_u(const void* src) -> enable::if_f64x4<YMM> { return YMM{_mm256_loadu_pd(static_cast<const vf64x2::element_t*>(src))}; }              // SSE2
@@ -211,6 +212,7 @@ namespace arkana::xmm
 
     template <class XMM> ARKXMM_API store_u(void* dst, const std::decay_t<XMM> v) -> enable::if_iXMM<XMM> { return _mm_storeu_si128(&static_cast<XMM*>(dst)->v, v.v), v; }            // SSE2
     template <class XMM> ARKXMM_API store_u(void* dst, const std::decay_t<XMM> v) -> enable::if_f32x4<XMM> { return _mm_storeu_ps(static_cast<vf32x4::element_t*>(dst), v.v), v; }    // SSE
+    template <class XMM> ARKXMM_API store_lo64(void* dst, const std::decay_t<XMM> v) -> enable::if_f32x4<XMM> { return _mm_storel_pi(static_cast<__m64*>(dst), v.v), v; }             // SSE  stores 2 floats of lower half.
     template <class XMM> ARKXMM_API store_u(void* dst, const std::decay_t<XMM> v) -> enable::if_f64x2<XMM> { return _mm_storeu_pd(static_cast<vf64x2::element_t*>(dst), v.v), v; }    // SSE2
     template <class XMM> ARKXMM_API store_a(void* dst, const std::decay_t<XMM> v) -> enable::if_iXMM<XMM> { return _mm_store_si128(&static_cast<XMM*>(dst)->v, v.v), v; }             // SSE2
     template <class XMM> ARKXMM_API store_a(void* dst, const std::decay_t<XMM> v) -> enable::if_f32x4<XMM> { return _mm_store_ps(static_cast<vf32x4::element_t*>(dst), v.v), v; }     // SSE
@@ -529,6 +531,9 @@ namespace arkana::xmm
     ARKXMM_API abs(vf64x2 a) -> vf64x2 { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }        // SSE2
     ARKXMM_API abs(vf64x4 a) -> vf64x4 { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }  // AVX
 
+    ARKXMM_API round(vf32x4 a) -> vf32x4 { return {_mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }    // SSE4.1 to nearest even
+    ARKXMM_API round(vf32x8 a) -> vf32x8 { return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; } // AVX to nearest even
+
     ARKXMM_API operator +(vi8x16 a, vi8x16 b) -> vi8x16 { return {_mm_add_epi8(a.v, b.v)}; }        // SSE2
     ARKXMM_API operator +(vu8x16 a, vu8x16 b) -> vu8x16 { return {_mm_add_epi8(a.v, b.v)}; }        // SSE2
     ARKXMM_API operator +(vi8x32 a, vi8x32 b) -> vi8x32 { return {_mm256_add_epi8(a.v, b.v)}; }     // SSE2
@@ -897,6 +902,10 @@ namespace arkana::xmm
     template <class YMM> ARKXMM_API unpack_hi(YMM l, YMM h) -> enable::if_32x8<YMM> { return unpack32_hi(l, h); }  // AVX2 {l0... l3| l4... l7}, {h0... h3| h4... h7} -> {l2,h2,l3,h3 | l6,h6,l7,h7}
     template <class XMM> ARKXMM_API unpack_hi(XMM l, XMM h) -> enable::if_64x2<XMM> { return unpack64_hi(l, h); }  // SSE2 {l0... l1}, {h0... h1} -> {l1,h1}
     template <class YMM> ARKXMM_API unpack_hi(YMM l, YMM h) -> enable::if_64x4<YMM> { return unpack64_hi(l, h); }  // AVX2 {l0... l1| l2... l3}, {h0... h1| h2... h3} -> {l1,h1 | l3,h3}
+    template <class XMM> ARKXMM_API unpack_lo(XMM l, XMM h) -> enable::if_f32x4<XMM> { return {_mm_unpacklo_ps(l.v, h.v)}; }    // SSE {l0... l3}, {h0... h3} -> {l0,h0,l1,h1}
+    template <class YMM> ARKXMM_API unpack_lo(YMM l, YMM h) -> enable::if_f32x8<YMM> { return {_mm256_unpacklo_ps(l.v, h.v)}; } // AVX {l0... l3| l4... l7}, {h0... h3| h4... h7} -> {l0,h0,l1,h1 | l4,h4,l5,h5}
+    template <class XMM> ARKXMM_API unpack_hi(XMM l, XMM h) -> enable::if_f32x4<XMM> { return {_mm_unpackhi_ps(l.v, h.v)}; }    // SSE {l0... l3}, {h0... h3} -> {l2,h2,l3,h3}
+    template <class YMM> ARKXMM_API unpack_hi(YMM l, YMM h) -> enable::if_f32x8<YMM> { return {_mm256_unpackhi_ps(l.v, h.v)}; } // AVX {l0... l3| l4... l7}, {h0... h3| h4... h7} -> {l2,h2,l3,h3 | l6,h6,l7,h7}
 
     // avx2 permute
     template <class YMM> ARKXMM_API permute32(YMM v, vi32x8 idx) -> enable::if_iYMM<YMM> { return {_mm256_permutevar8x32_epi32(v.v, idx.v)}; }                                                                                                 // AVX2  idx = 0..7
@@ -1023,6 +1032,79 @@ namespace arkana::xmm
     template <class NMM> ARKXMM_API max(NMM a, typename NMM::element_t b) -> enable::if_iNMM<NMM> { return max(a, xmm::broadcast<NMM>(b)); }
     template <class NMM> ARKXMM_API min(NMM a, typename NMM::element_t b) -> enable::if_iNMM<NMM> { return min(a, xmm::broadcast<NMM>(b)); }
 
+    /// AVX-512 __m512i
+    template <class T>
+    struct alignas(64) ZMM
+    {
+        using vector_t = __m512i;
+        using element_t = T;
+        static constexpr inline size_t element_bits = sizeof(element_t) * 8;
+        static constexpr inline size_t size = sizeof(vector_t) / sizeof(element_t);
+        using array_t = std::array<element_t, size>;
+        vector_t v;
+    };
+
+    /// AVX-512 __m512
+    template <>
+    struct alignas(64) ZMM<float32_t>
+    {
+        using vector_t = __m512;
+        using element_t = float32_t;
+        static constexpr inline size_t element_bits = sizeof(element_t) * 8;
+        static constexpr inline size_t size = sizeof(vector_t) / sizeof(element_t);
+        using array_t = std::array<element_t, size>;
+        vector_t v;
+    };
+
+    using vi8x64 = ZMM<int8_t>;
+    using vu8x64 = ZMM<uint8_t>;
+    using vi16x32 = ZMM<int16_t>;
+    using vu16x32 = ZMM<uint16_t>;
+    using vi32x16 = ZMM<int32_t>;
+    using vu32x16 = ZMM<uint32_t>;
+    using vf32x16 = ZMM<float32_t>;
+    using vi64x8 = ZMM<int64_t>;
+    using vu64x8 = ZMM<uint64_t>;
+
+    namespace enable
+    {
+        template <class ZMM, class T = ZMM> using if_iZMM = std::enable_if_t<!std::is_floating_point_v<typename ZMM::element_t> && ZMM::element_bits * ZMM::size == 512, T>;
+        template <class ZMM, class T = ZMM> using if_f32x16 = std::enable_if_t<std::is_floating_point_v<typename ZMM::element_t> && ZMM::element_bits * ZMM::size == 512 && ZMM::element_bits == 32, T>;
+    }
+
+    // ZMM load/store
+    template <class ZMM> ARKXMM_API load_u(const void* src) -> enable::if_iZMM<ZMM> { return ZMM{_mm512_loadu_si512(src)}; }                                                               // AVX512F
+    template <class ZMM> ARKXMM_API load_u(const void* src) -> enable::if_f32x16<ZMM> { return ZMM{_mm512_loadu_ps(src)}; }                                                                 // AVX512F
+    template <class ZMM> ARKXMM_API load_u_masked(const void* src, uint64_t byte_mask) -> enable::if_iZMM<ZMM> { return ZMM{_mm512_maskz_loadu_epi8(byte_mask, src)}; }                    // AVX512BW masked-out bytes are zero, and never fault.
+    template <class ZMM> ARKXMM_API store_u(void* dst, const std::decay_t<ZMM> v) -> enable::if_iZMM<ZMM> { return _mm512_storeu_si512(dst, v.v), v; }                                     // AVX512F
+    template <class ZMM> ARKXMM_API store_u(void* dst, const std::decay_t<ZMM> v) -> enable::if_f32x16<ZMM> { return _mm512_storeu_ps(dst, v.v), v; }                                      // AVX512F
+    template <class ZMM> ARKXMM_API store_u_masked(void* dst, const std::decay_t<ZMM> v, uint64_t byte_mask) -> enable::if_iZMM<ZMM> { return _mm512_mask_storeu_epi8(dst, byte_mask, v.v), v; } // AVX512BW
+    template <class To, class T> ARKXMM_API reinterpret(ZMM<T> v) -> enable::if_iZMM<To> { return To{v.v}; } // cast ZMM to another ZMM
+
+    // ZMM broadcast/from_values
+    ARKXMM_API i8x64(vi8x16 v) -> vi8x64 { return {_mm512_broadcast_i32x4(v.v)}; }  // AVX512F
+    ARKXMM_API i32x16(int32_t v) -> vi32x16 { return {_mm512_set1_epi32(v)}; }      // AVX512F
+    ARKXMM_API f32x16(float32_t v) -> vf32x16 { return {_mm512_set1_ps(v)}; }       // AVX512F
+    ARKXMM_API i32x16(int32_t x0, int32_t x1, int32_t x2, int32_t x3, int32_t x4, int32_t x5, int32_t x6, int32_t x7, int32_t x8, int32_t x9, int32_t xA, int32_t xB, int32_t xC, int32_t xD, int32_t xE, int32_t xF) -> vi32x16 { return {_mm512_setr_epi32(x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, xA, xB, xC, xD, xE, xF)}; } // AVX512F
+
+    // ZMM arithmetic
+    ARKXMM_API operator +(vf32x16 a, vf32x16 b) -> vf32x16 { return {_mm512_add_ps(a.v, b.v)}; }       // AVX512F
+    ARKXMM_API operator *(vf32x16 a, vf32x16 b) -> vf32x16 { return {_mm512_mul_ps(a.v, b.v)}; }       // AVX512F
+    ARKXMM_API min(vf32x16 a, vf32x16 b) -> vf32x16 { return {_mm512_min_ps(a.v, b.v)}; }              // AVX512F
+    ARKXMM_API max(vf32x16 a, vf32x16 b) -> vf32x16 { return {_mm512_max_ps(a.v, b.v)}; }              // AVX512F
+    ARKXMM_API operator <<(vi32x16 a, int i) -> vi32x16 { return {_mm512_slli_epi32(a.v, static_cast<unsigned>(i))}; } // AVX512F
+    ARKXMM_API operator >>(vi32x16 a, int i) -> vi32x16 { return {_mm512_srai_epi32(a.v, static_cast<unsigned>(i))}; } // AVX512F
+
+    // ZMM shuffle
+    template <class T> ARKXMM_API byte_shuffle_128(ZMM<T> val, ZMM<int8_t> index) -> ZMM<T> { return {_mm512_shuffle_epi8(val.v, index.v)}; }   // AVX512BW
+    template <class ZMM> ARKXMM_API permute32(ZMM v, vi32x16 idx) -> enable::if_iZMM<ZMM> { return {_mm512_permutexvar_epi32(idx.v, v.v)}; }    // AVX512F idx = 0..15
+
+    // ZMM type conversion
+    template <class To> ARKXMM_API convert_cast(vi16x16 i16x16) -> enable::if_<To, vi32x16> { return {_mm512_cvtepi16_epi32(i16x16.v)}; }   // AVX512F
+    template <class To> ARKXMM_API convert_cast(vi32x16 i32x16) -> enable::if_<To, vi16x16> { return {_mm512_cvtepi32_epi16(i32x16.v)}; }   // AVX512F truncates each element to 16 bits
+    template <class To> ARKXMM_API convert_cast(vi32x16 i32x16) -> enable::if_<To, vf32x16> { return {_mm512_cvtepi32_ps(i32x16.v)}; }      // AVX512F
+    template <class To> ARKXMM_API convert_cast(vf32x16 f32x16) -> enable::if_<To, vi32x16> { return {_mm512_cvttps_epi32(f32x16.v)}; }     // AVX512F
+
     // operator extensions
     template <class T, class U> ARKXMM_API operator &=(T& lhs, U rhs) -> ARKXMM_DEFINE_EXTENSION(lhs = lhs & rhs);
     template <class T, class U> ARKXMM_API operator |=(T& lhs, U rhs) -> ARKXMM_DEFINE_EXTENSION(lhs = lhs | rhs);
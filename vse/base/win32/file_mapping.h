@@ -0,0 +1,84 @@
+/// @file
+/// @brief  win32 file mapping
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <Windows.h>
+
+#include <cstddef>
+#include <memory>
+#include <filesystem>
+#include <stdexcept>
+
+#include "./unique_handle.h"
+
+namespace vse::win32
+{
+    /// Maps an entire file into the address space.
+    class mapped_file final
+    {
+        struct view_unmapper
+        {
+            void operator()(void* p) const noexcept { if (p) ::UnmapViewOfFile(p); }
+        };
+
+        std::unique_ptr<void, view_unmapper> view_{};
+        size_t size_{};
+
+    public:
+        mapped_file() = default;
+
+        /// Maps the file.
+        /// @param path File path.
+        /// @param copy_on_write If true, maps pages as copy-on-write: writes to the view are private and never reach the file.
+        explicit mapped_file(const std::filesystem::path& path, bool copy_on_write = false)
+        {
+            unique_handle file{::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+            if (file.get() == INVALID_HANDLE_VALUE)
+            {
+                (void)file.release();
+                throw std::runtime_error("File can't be open.");
+            }
+
+            LARGE_INTEGER size{};
+            if (!::GetFileSizeEx(file.get(), &size))
+                throw std::runtime_error("GetFileSizeEx failed.");
+
+            if (size.QuadPart == 0) return; // empty file can't be mapped.
+            if (static_cast<ULONGLONG>(size.QuadPart) > static_cast<ULONGLONG>(SIZE_MAX))
+                throw std::runtime_error("File too large.");
+
+            unique_handle mapping{::CreateFileMappingW(file.get(), nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr)};
+            if (!mapping)
+                throw std::runtime_error("CreateFileMapping failed.");
+
+            view_.reset(::MapViewOfFile(mapping.get(), copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+            if (!view_)
+                throw std::runtime_error("MapViewOfFile failed.");
+
+            // the view holds its own reference to the section; both handles may be closed here.
+            size_ = static_cast<size_t>(size.QuadPart);
+        }
+
+        mapped_file(const mapped_file& other) = delete;
+        mapped_file(mapped_file&& other) noexcept = default;
+        mapped_file& operator=(const mapped_file& other) = delete;
+        mapped_file& operator=(mapped_file&& other) noexcept = default;
+        ~mapped_file() = default;
+
+        [[nodiscard]] const void* data() const noexcept { return view_.get(); }
+        [[nodiscard]] void* data() noexcept { return view_.get(); } // writable only if mapped as copy-on-write.
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+        explicit operator bool() const noexcept { return static_cast<bool>(view_); }
+    };
+
+    /// Maps an entire file read-only and shares the view.
+    [[nodiscard]] static inline std::shared_ptr<const void> map_file_shared(const std::filesystem::path& path, size_t* size)
+    {
+        auto file = std::make_shared<mapped_file>(path);
+        if (size) *size = file->size();
+        const void* p = file->data();
+        return std::shared_ptr<const void>(std::move(file), p);
+    }
+}
@@ -0,0 +1,47 @@
+/// @file
+/// @brief  xtl::fnv1a_hash
+/// @author ttsuki
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace vse::xtl
+{
+    /// FNV-1a 64-bit hash.
+    class fnv1a_hash final
+    {
+        static inline constexpr uint64_t offset_basis_ = 14695981039346656037ull;
+        static inline constexpr uint64_t prime_ = 1099511628211ull;
+
+        uint64_t value_ = offset_basis_;
+
+    public:
+        constexpr fnv1a_hash() = default;
+
+        fnv1a_hash& update(const void* data, size_t length) noexcept
+        {
+            const auto* p = static_cast<const unsigned char*>(data);
+            uint64_t h = value_;
+            for (size_t i = 0; i < length; i++)
+                h = (h ^ p[i]) * prime_;
+            value_ = h;
+            return *this;
+        }
+
+        template <class T, std::enable_if_t<std::is_trivially_copyable_v<T>>* = nullptr>
+        fnv1a_hash& update(const T& value) noexcept
+        {
+            return update(&value, sizeof(T));
+        }
+
+        [[nodiscard]] constexpr uint64_t value() const noexcept { return value_; }
+
+        [[nodiscard]] static uint64_t compute(const void* data, size_t length) noexcept
+        {
+            return fnv1a_hash().update(data, length).value();
+        }
+    };
+}
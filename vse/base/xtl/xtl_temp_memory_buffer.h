@@ -40,5 +40,12 @@ namespace vse::xtl
 
             return reinterpret_cast<T*>(ptr_.get() + before_);
         }
+
+        /// Allocates in advance so that get(n) for n <= count does not re-allocate.
+        template <class T = std::byte, std::enable_if_t<std::is_trivial_v<T>>* = nullptr>
+        void reserve(size_t count)
+        {
+            (void)get<T>(count);
+        }
     };
 }
@@ -0,0 +1,312 @@
+/// @file
+/// @brief  Vse - Async Audio File Loader
+/// @author (C) 2022 ttsuki
+
+#include "AsyncAudioFileLoader.h"
+
+#include <Windows.h>
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <vector>
+#include <future>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/win32/com_base.h"
+#include "../base/win32/unique_handle.h"
+#include "../base/win32/thread.h"
+
+#include "WaveFileLoader.h"
+
+namespace vse
+{
+    std::shared_ptr<IAsyncAudioFileLoader> CreateAsyncAudioFileLoader(size_t queue_depth, size_t decode_thread_count)
+    {
+        if (queue_depth == 0) throw std::invalid_argument("queue_depth");
+        if (decode_thread_count == 0) decode_thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+        class AsyncAudioFileLoaderImpl final : public IAsyncAudioFileLoader
+        {
+            struct LoadRequest
+            {
+                std::filesystem::path path{};
+                PcmWaveFormat desired_format{};
+                std::promise<std::shared_ptr<IRandomAccessWaveBuffer>> promise{};
+            };
+
+            // An in-flight file read. Owned by the I/O thread.
+            struct ReadOperation
+            {
+                OVERLAPPED overlapped{};
+                std::unique_ptr<LoadRequest> request{};
+                win32::unique_handle file{};
+                std::shared_ptr<std::byte> image{};
+                size_t length{};
+                size_t done{};
+            };
+
+            struct DecodeJob
+            {
+                std::unique_ptr<LoadRequest> request{};
+                std::shared_ptr<const void> image{};
+                size_t length{};
+            };
+
+            static constexpr ULONG_PTR CompletionKey_Read = 0;
+            static constexpr ULONG_PTR CompletionKey_Wake = 1;
+            static constexpr ULONG_PTR CompletionKey_Quit = 2;
+            static constexpr size_t MaxReadChunkSize = 64 * 1048576;
+
+            size_t queue_depth_{};
+
+            win32::unique_handle iocp_{};
+
+            std::mutex mutex_{};
+            std::condition_variable idle_cv_{};
+            std::deque<std::unique_ptr<LoadRequest>> pending_{}; // waiting for a read slot
+            size_t outstanding_{};                               // enqueued, not fulfilled yet
+
+            std::mutex decode_mutex_{};
+            std::condition_variable decode_cv_{};
+            std::deque<DecodeJob> decode_queue_{};
+            bool decode_running_{true};
+
+            win32::thread io_thread_{};
+            std::vector<win32::thread> decode_threads_{};
+
+        public:
+            AsyncAudioFileLoaderImpl(size_t queue_depth, size_t decode_thread_count)
+                : queue_depth_(queue_depth)
+            {
+                iocp_.reset(::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1));
+                if (!iocp_) throw std::runtime_error("CreateIoCompletionPort failed.");
+
+                io_thread_ = win32::thread([this] { IoThreadProc(); }, win32::thread::join_on_destructor);
+
+                decode_threads_.reserve(decode_thread_count);
+                for (size_t i = 0; i < decode_thread_count; i++)
+                    decode_threads_.emplace_back([this] { DecodeThreadProc(); }, win32::thread::join_on_destructor);
+            }
+
+            AsyncAudioFileLoaderImpl(const AsyncAudioFileLoaderImpl& other) = delete;
+            AsyncAudioFileLoaderImpl(AsyncAudioFileLoaderImpl&& other) noexcept = delete;
+            AsyncAudioFileLoaderImpl& operator=(const AsyncAudioFileLoaderImpl& other) = delete;
+            AsyncAudioFileLoaderImpl& operator=(AsyncAudioFileLoaderImpl&& other) noexcept = delete;
+
+            ~AsyncAudioFileLoaderImpl() override
+            {
+                // the I/O thread cancels in-flight reads and waits for them, since they still refer to their buffers.
+                ::PostQueuedCompletionStatus(iocp_.get(), 0, CompletionKey_Quit, nullptr);
+                io_thread_.join();
+
+                {
+                    std::lock_guard lock(decode_mutex_);
+                    decode_running_ = false;
+                }
+                decode_cv_.notify_all();
+                for (auto& t : decode_threads_) t.join();
+            }
+
+            [[nodiscard]] std::future<std::shared_ptr<IRandomAccessWaveBuffer>> Enqueue(const std::filesystem::path& path, PcmWaveFormat desired_format) override
+            {
+                auto request = std::make_unique<LoadRequest>();
+                request->path = path;
+                request->desired_format = desired_format;
+                auto future = request->promise.get_future();
+
+                {
+                    std::lock_guard lock(mutex_);
+                    pending_.emplace_back(std::move(request));
+                    outstanding_++;
+                }
+
+                ::PostQueuedCompletionStatus(iocp_.get(), 0, CompletionKey_Wake, nullptr);
+                return future;
+            }
+
+            void WaitAll() override
+            {
+                std::unique_lock lock(mutex_);
+                idle_cv_.wait(lock, [this] { return outstanding_ == 0; });
+            }
+
+        private:
+            void Fulfilled()
+            {
+                {
+                    std::lock_guard lock(mutex_);
+                    outstanding_--;
+                }
+                idle_cv_.notify_all();
+            }
+
+            void Fail(std::unique_ptr<LoadRequest> request, const char* message)
+            {
+                request->promise.set_exception(std::make_exception_ptr(std::runtime_error(message)));
+                Fulfilled();
+            }
+
+            void IoThreadProc()
+            {
+                std::list<std::unique_ptr<ReadOperation>> in_flight;
+                bool quitting = false;
+
+                while (true)
+                {
+                    // issues reads up to the queue depth.
+                    while (!quitting && in_flight.size() < queue_depth_)
+                    {
+                        std::unique_ptr<LoadRequest> request;
+                        {
+                            std::lock_guard lock(mutex_);
+                            if (pending_.empty()) break;
+                            request = std::move(pending_.front());
+                            pending_.pop_front();
+                        }
+
+                        if (auto op = StartRead(std::move(request)))
+                            in_flight.emplace_back(std::move(op));
+                    }
+
+                    if (quitting && in_flight.empty())
+                        break;
+
+                    DWORD transferred{};
+                    ULONG_PTR key{};
+                    OVERLAPPED* overlapped{};
+                    BOOL ok = ::GetQueuedCompletionStatus(iocp_.get(), &transferred, &key, &overlapped, INFINITE);
+
+                    if (!overlapped)
+                    {
+                        if (key == CompletionKey_Quit && !quitting)
+                        {
+                            quitting = true;
+                            for (auto& op : in_flight) ::CancelIoEx(op->file.get(), &op->overlapped);
+                        }
+                        continue;
+                    }
+
+                    // only reads carry an OVERLAPPED, and an operation leaves in_flight after its last read is completed.
+                    auto it = std::find_if(in_flight.begin(), in_flight.end(), [overlapped](const auto& op) { return &op->overlapped == overlapped; });
+                    assert(it != in_flight.end());
+
+                    if (OnReadCompleted(**it, ok && !quitting, transferred))
+                        in_flight.erase(it);
+                }
+            }
+
+            // Opens the file and issues the first read. Returns nullptr if the request is already finished (failed or empty).
+            std::unique_ptr<ReadOperation> StartRead(std::unique_ptr<LoadRequest> request)
+            {
+                auto op = std::make_unique<ReadOperation>();
+                op->file.reset(::CreateFileW(request->path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+                if (op->file.get() == INVALID_HANDLE_VALUE)
+                {
+                    (void)op->file.release();
+                    return Fail(std::move(request), "File can't be open."), nullptr;
+                }
+
+                LARGE_INTEGER size{};
+                if (!::GetFileSizeEx(op->file.get(), &size) || static_cast<ULONGLONG>(size.QuadPart) > static_cast<ULONGLONG>(SIZE_MAX))
+                    return Fail(std::move(request), "File size can't be read."), nullptr;
+
+                op->request = std::move(request);
+                op->length = static_cast<size_t>(size.QuadPart);
+                op->image = std::shared_ptr<std::byte>(new std::byte[std::max<size_t>(op->length, 1)], std::default_delete<std::byte[]>());
+
+                if (op->length == 0)
+                    return SubmitDecode(*op), nullptr;
+
+                if (!::CreateIoCompletionPort(op->file.get(), iocp_.get(), CompletionKey_Read, 0))
+                    return Fail(std::move(op->request), "CreateIoCompletionPort failed."), nullptr;
+
+                if (!IssueRead(*op))
+                    return Fail(std::move(op->request), "ReadFile failed."), nullptr;
+
+                return op;
+            }
+
+            static bool IssueRead(ReadOperation& op)
+            {
+                const auto offset = static_cast<ULONGLONG>(op.done);
+                op.overlapped = OVERLAPPED{};
+                op.overlapped.Offset = static_cast<DWORD>(offset);
+                op.overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+                const DWORD chunk = static_cast<DWORD>(std::min(op.length - op.done, MaxReadChunkSize));
+                if (::ReadFile(op.file.get(), op.image.get() + op.done, chunk, nullptr, &op.overlapped)) return true; // completion is still queued.
+                return ::GetLastError() == ERROR_IO_PENDING;
+            }
+
+            // Returns true if the operation is finished.
+            bool OnReadCompleted(ReadOperation& op, bool ok, DWORD transferred)
+            {
+                if (!ok || transferred == 0)
+                    return Fail(std::move(op.request), "ReadFile failed."), true;
+
+                op.done += transferred;
+                if (op.done < op.length)
+                {
+                    if (IssueRead(op)) return false;
+                    return Fail(std::move(op.request), "ReadFile failed."), true;
+                }
+
+                op.file.reset(); // closes early
+                SubmitDecode(op);
+                return true;
+            }
+
+            void SubmitDecode(ReadOperation& op)
+            {
+                {
+                    std::lock_guard lock(decode_mutex_);
+                    decode_queue_.push_back(DecodeJob{std::move(op.request), std::move(op.image), op.length});
+                }
+                decode_cv_.notify_one();
+            }
+
+            void DecodeThreadProc()
+            {
+                win32::CoInitializeMTA(); // for media foundation decoders
+
+                while (true)
+                {
+                    DecodeJob job;
+                    {
+                        std::unique_lock lock(decode_mutex_);
+                        decode_cv_.wait(lock, [this] { return !decode_running_ || !decode_queue_.empty(); });
+                        if (!decode_running_) break; // abandons queued jobs
+                        job = std::move(decode_queue_.front());
+                        decode_queue_.pop_front();
+                    }
+
+                    try
+                    {
+                        auto& r = *job.request;
+                        r.promise.set_value(
+                            r.desired_format
+                                ? LoadAudioFile(std::move(job.image), job.length, r.desired_format)
+                                : LoadAudioFile(std::move(job.image), job.length));
+                    }
+                    catch (...)
+                    {
+                        job.request->promise.set_exception(std::current_exception());
+                    }
+
+                    Fulfilled();
+                }
+
+                win32::CoUninitialize();
+            }
+        };
+
+        return std::make_shared<AsyncAudioFileLoaderImpl>(queue_depth, decode_thread_count);
+    }
+}
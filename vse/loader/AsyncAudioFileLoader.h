@@ -0,0 +1,38 @@
+/// @file
+/// @brief  Vse - Async Audio File Loader
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include "../base/Interface.h"
+#include "../base/IWaveSource.h"
+#include "../base/RandomAccessWaveBuffer.h"
+
+#include <memory>
+#include <future>
+#include <filesystem>
+
+namespace vse
+{
+    /// Loads many audio files concurrently.
+    /// File reads are issued as overlapped I/O, up to the queue depth at a time,
+    /// and each completed file image is handed to a decode worker pool, so that I/O and decoding overlap.
+    class IAsyncAudioFileLoader : public virtual Interface
+    {
+    public:
+        /// Enqueues a file to load.
+        /// @param path File path.
+        /// @param desired_format Output format. If empty, the decoder's native format is used.
+        /// @returns the future of the decoded buffer. it holds the exception if reading or decoding failed.
+        [[nodiscard]] virtual std::future<std::shared_ptr<IRandomAccessWaveBuffer>> Enqueue(const std::filesystem::path& path, PcmWaveFormat desired_format = {}) = 0;
+
+        /// Waits for all enqueued files to be loaded.
+        virtual void WaitAll() = 0;
+    };
+
+    /// Creates an async audio file loader.
+    /// Requests which are not started yet when the loader is destroyed are abandoned (their futures get broken_promise).
+    /// @param queue_depth Maximum number of reads in flight.
+    /// @param decode_thread_count Number of decode worker threads. If 0, hardware_concurrency is used.
+    [[nodiscard]] std::shared_ptr<IAsyncAudioFileLoader> CreateAsyncAudioFileLoader(size_t queue_depth = 16, size_t decode_thread_count = 0);
+}
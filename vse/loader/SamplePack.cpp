@@ -0,0 +1,290 @@
+/// @file
+/// @brief  Vse - Sample Pack
+/// @author (C) 2022 ttsuki
+
+#include "SamplePack.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "../base/win32/file_mapping.h"
+#include "../base/xtl/xtl_fnv1a_hash.h"
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "WaveFileLoader.h"
+
+namespace vse
+{
+    namespace
+    {
+        struct SamplePackHeader
+        {
+            static constexpr uint32_t Magic = 0x4b505356; // "VSPK"
+            static constexpr uint32_t Version = 1;
+            static constexpr uint64_t PageSize = 4096;
+
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entry_count;
+            uint32_t reserved;
+            uint64_t index_offset;
+            uint64_t names_offset;
+            uint64_t names_length;
+        };
+
+        struct SamplePackIndexEntry
+        {
+            uint64_t offset;
+            uint64_t length;
+            uint64_t hash;
+            uint32_t name_offset;
+            uint32_t name_length;
+            uint32_t sample_type; // 0 if the payload is a file image.
+            uint32_t channel_mask;
+            int32_t frequency;
+            uint32_t reserved;
+        };
+
+        [[nodiscard]] constexpr uint64_t RoundUpToPage(uint64_t v) noexcept
+        {
+            return (v + SamplePackHeader::PageSize - 1) / SamplePackHeader::PageSize * SamplePackHeader::PageSize;
+        }
+
+        class SamplePackImpl final : public ISamplePack
+        {
+            std::shared_ptr<win32::mapped_file> file_{};
+            const std::byte* base_{};
+            const SamplePackIndexEntry* index_{};
+            const char* names_{};
+            size_t entry_count_{};
+            std::unique_ptr<std::atomic<bool>[]> verified_{}; // payload hash checked once per entry.
+
+        public:
+            explicit SamplePackImpl(std::shared_ptr<win32::mapped_file> file)
+                : file_(std::move(file))
+                , base_(static_cast<const std::byte*>(file_->data()))
+            {
+                const size_t file_size = file_->size();
+                if (file_size < sizeof(SamplePackHeader))
+                    throw std::runtime_error("OpenSamplePack: not a sample pack.");
+
+                SamplePackHeader header{};
+                std::memcpy(&header, base_, sizeof(header));
+                if (header.magic != SamplePackHeader::Magic || header.version != SamplePackHeader::Version)
+                    throw std::runtime_error("OpenSamplePack: not a sample pack.");
+
+                auto in_file = [file_size](uint64_t offset, uint64_t length) { return offset <= file_size && length <= file_size - offset; };
+
+                if (header.index_offset % alignof(SamplePackIndexEntry) != 0
+                    || !in_file(header.index_offset, uint64_t{header.entry_count} * sizeof(SamplePackIndexEntry))
+                    || !in_file(header.names_offset, header.names_length))
+                    throw std::runtime_error("OpenSamplePack: broken header.");
+
+                index_ = reinterpret_cast<const SamplePackIndexEntry*>(base_ + header.index_offset);
+                names_ = reinterpret_cast<const char*>(base_ + header.names_offset);
+                entry_count_ = header.entry_count;
+                verified_ = std::make_unique<std::atomic<bool>[]>(entry_count_);
+
+                // validates all entries once, so that accessors don't need to.
+                for (size_t i = 0; i < entry_count_; i++)
+                {
+                    const SamplePackIndexEntry& e = index_[i];
+                    if (!in_file(e.offset, e.length) || uint64_t{e.name_offset} + e.name_length > header.names_length)
+                        throw std::runtime_error("OpenSamplePack: broken index.");
+                }
+            }
+
+            [[nodiscard]] size_t GetEntryCount() const override { return entry_count_; }
+
+            [[nodiscard]] SamplePackEntryInfo GetEntryInfo(size_t index) const override
+            {
+                const SamplePackIndexEntry& e = index_[CheckIndex(index)];
+                return SamplePackEntryInfo{GetName(e), static_cast<size_t>(e.length), GetFormat(e), e.hash};
+            }
+
+            [[nodiscard]] std::optional<size_t> FindEntry(std::string_view name) const override
+            {
+                // the index is sorted by name.
+                const auto* end = index_ + entry_count_;
+                const auto* it = std::lower_bound(index_, end, name, [this](const SamplePackIndexEntry& e, std::string_view n) { return GetName(e) < n; });
+                if (it != end && GetName(*it) == name) return static_cast<size_t>(it - index_);
+                return std::nullopt;
+            }
+
+            [[nodiscard]] std::shared_ptr<ISeekableByteStream> OpenEntry(size_t index) const override
+            {
+                const SamplePackIndexEntry& e = index_[CheckIndex(index)];
+                return OpenFile(std::shared_ptr<const void>(file_, base_ + e.offset), static_cast<size_t>(e.length));
+            }
+
+            [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> LoadEntry(size_t index, PcmWaveFormat desired_format) const override
+            {
+                const SamplePackIndexEntry& e = index_[CheckIndex(index)];
+                const PcmWaveFormat format = GetFormat(e);
+                const std::byte* payload = base_ + e.offset;
+                const size_t length = static_cast<size_t>(e.length);
+
+                // the mapping is read-only to the pack, so a payload verified once stays valid.
+                if (!verified_[index].load(std::memory_order_acquire))
+                {
+                    if (xtl::fnv1a_hash::compute(payload, length) != e.hash)
+                        throw std::runtime_error("ISamplePack: payload hash mismatch.");
+                    verified_[index].store(true, std::memory_order_release);
+                }
+
+                if (!format) // file image
+                {
+                    auto image = std::shared_ptr<const void>(file_, payload);
+                    return desired_format
+                               ? LoadAudioFile(std::move(image), length, desired_format)
+                               : LoadAudioFile(std::move(image), length);
+                }
+
+                // raw pcm: each load gets its own copy, so that writes to a loaded buffer don't leak to other loads.
+                if (!desired_format || desired_format == format)
+                {
+                    auto buffer = AllocateWaveBuffer(format);
+                    (void)buffer->Resize(length);
+                    (void)buffer->Write(payload, 0, length);
+                    return buffer;
+                }
+
+                // converts from a private view of the mapping, which is only read.
+                auto view = AttachWaveBuffer(std::shared_ptr<void>(file_, const_cast<std::byte*>(payload)), length, format);
+                return ReadOutToMemory(ConvertWaveFormat(AllocateReadCursor(std::move(view)), desired_format));
+            }
+
+        private:
+            [[nodiscard]] size_t CheckIndex(size_t index) const
+            {
+                if (index >= entry_count_) throw std::out_of_range("ISamplePack: index out of range.");
+                return index;
+            }
+
+            [[nodiscard]] std::string_view GetName(const SamplePackIndexEntry& e) const noexcept
+            {
+                return std::string_view(names_ + e.name_offset, e.name_length);
+            }
+
+            [[nodiscard]] static PcmWaveFormat GetFormat(const SamplePackIndexEntry& e) noexcept
+            {
+                if (e.sample_type == 0) return {};
+                return PcmWaveFormat(static_cast<SampleType>(e.sample_type), static_cast<SpeakerBit>(e.channel_mask), e.frequency);
+            }
+        };
+    }
+
+    std::shared_ptr<ISamplePack> OpenSamplePack(const std::filesystem::path& path)
+    {
+        return std::make_shared<SamplePackImpl>(std::make_shared<win32::mapped_file>(path, true));
+    }
+
+    void WriteSamplePack(const std::filesystem::path& path, const std::vector<SamplePackSource>& sources)
+    {
+        // sorts by name for binary search.
+        std::vector<const SamplePackSource*> sorted;
+        sorted.reserve(sources.size());
+        for (const auto& s : sources)
+        {
+            if (!s.file == !s.wave) throw std::invalid_argument("WriteSamplePack: each source needs either file or wave.");
+            sorted.push_back(&s);
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [](const SamplePackSource* a, const SamplePackSource* b) { return a->name < b->name; });
+        if (std::adjacent_find(sorted.begin(), sorted.end(), [](const SamplePackSource* a, const SamplePackSource* b) { return a->name == b->name; }) != sorted.end())
+            throw std::invalid_argument("WriteSamplePack: duplicated name.");
+
+        // layout
+        SamplePackHeader header{};
+        header.magic = SamplePackHeader::Magic;
+        header.version = SamplePackHeader::Version;
+        header.entry_count = static_cast<uint32_t>(sorted.size());
+        header.index_offset = sizeof(SamplePackHeader);
+        header.names_offset = header.index_offset + sorted.size() * sizeof(SamplePackIndexEntry);
+
+        std::vector<SamplePackIndexEntry> index(sorted.size());
+        std::string names;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const SamplePackSource& s = *sorted[i];
+            SamplePackIndexEntry& e = index[i];
+            e.name_offset = static_cast<uint32_t>(names.size());
+            e.name_length = static_cast<uint32_t>(s.name.size());
+            names += s.name;
+
+            if (s.wave)
+            {
+                const PcmWaveFormat format = s.wave->GetFormat();
+                e.sample_type = static_cast<uint32_t>(format.SampleType());
+                e.channel_mask = +format.ChannelMask();
+                e.frequency = format.SamplingFrequency();
+                e.length = s.wave->Size();
+            }
+            else
+            {
+                e.length = s.file->Size();
+            }
+        }
+        header.names_length = names.size();
+
+        uint64_t cursor = RoundUpToPage(header.names_offset + header.names_length);
+        for (auto& e : index)
+        {
+            e.offset = cursor;
+            cursor = RoundUpToPage(cursor + e.length);
+        }
+
+        std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream) throw std::runtime_error("WriteSamplePack: file can't be open.");
+
+        // payloads first: hashes are computed while copying, then the index is written.
+        auto temp_buffer = xtl::temp_memory_buffer();
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            const SamplePackSource& s = *sorted[i];
+            SamplePackIndexEntry& e = index[i];
+
+            stream.seekp(static_cast<std::streamoff>(e.offset));
+            if (s.file) (void)s.file->Seek(0);
+
+            xtl::fnv1a_hash hash{};
+            for (uint64_t done = 0; done < e.length;)
+            {
+                constexpr size_t buf_size = 65536;
+                void* p = temp_buffer.get(buf_size);
+                const size_t want = static_cast<size_t>(std::min<uint64_t>(e.length - done, buf_size));
+                const size_t sz = s.wave ? s.wave->Read(p, static_cast<size_t>(done), want) : s.file->Read(p, want);
+                if (sz == 0) throw std::runtime_error("WriteSamplePack: source is shorter than its size.");
+                hash.update(p, sz);
+                stream.write(static_cast<const char*>(p), static_cast<std::streamsize>(sz));
+                done += sz;
+            }
+            e.hash = hash.value();
+        }
+
+        // pads the last payload to a page boundary.
+        if (cursor > static_cast<uint64_t>(stream.tellp()))
+        {
+            stream.seekp(static_cast<std::streamoff>(cursor - 1));
+            stream.put('\0');
+        }
+
+        stream.seekp(0);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(SamplePackIndexEntry)));
+        stream.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+        if (!stream.flush())
+            throw std::runtime_error("WriteSamplePack: write failed.");
+    }
+}
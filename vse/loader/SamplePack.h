@@ -0,0 +1,73 @@
+/// @file
+/// @brief  Vse - Sample Pack
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include "../base/Interface.h"
+#include "../base/IByteStream.h"
+#include "../base/IWaveSource.h"
+#include "../base/RandomAccessWaveBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <filesystem>
+
+namespace vse
+{
+    /// Sample pack: a single file holding many samples.
+    ///
+    /// Layout:
+    ///   header, index (sorted by name), name table, then page-aligned payloads.
+    /// A payload is either a file image (decoded on load), or raw PCM samples in the entry's format (copied on load).
+    struct SamplePackEntryInfo
+    {
+        std::string_view name{}; ///< UTF-8 name, valid while the pack is alive.
+        size_t length{};         ///< Payload length in bytes.
+        PcmWaveFormat format{};  ///< PCM format if the payload is raw PCM, otherwise empty.
+        uint64_t hash{};         ///< FNV-1a hash of the payload.
+    };
+
+    /// Represents an opened sample pack.
+    class ISamplePack : public virtual Interface
+    {
+    public:
+        /// Gets the number of entries.
+        [[nodiscard]] virtual size_t GetEntryCount() const = 0;
+
+        /// Gets the entry information.
+        [[nodiscard]] virtual SamplePackEntryInfo GetEntryInfo(size_t index) const = 0;
+
+        /// Finds an entry by name.
+        /// @returns the entry index, or nullopt if not found.
+        [[nodiscard]] virtual std::optional<size_t> FindEntry(std::string_view name) const = 0;
+
+        /// Opens the entry payload as a byte stream, without copying.
+        [[nodiscard]] virtual std::shared_ptr<ISeekableByteStream> OpenEntry(size_t index) const = 0;
+
+        /// Loads the entry as PCM.
+        /// Raw PCM payloads are copied out of the mapping (and converted only if desired_format differs), file images are decoded.
+        /// The payload hash is verified on the first load of each entry.
+        /// @param desired_format Output format. If empty, the payload's own format is used.
+        /// @throw std::runtime_error The payload is broken.
+        [[nodiscard]] virtual std::shared_ptr<IRandomAccessWaveBuffer> LoadEntry(size_t index, PcmWaveFormat desired_format = {}) const = 0;
+    };
+
+    /// Opens a sample pack. The pack file is mapped, not read.
+    [[nodiscard]] std::shared_ptr<ISamplePack> OpenSamplePack(const std::filesystem::path& path);
+
+    /// Source entry to build a sample pack.
+    struct SamplePackSource
+    {
+        std::string name{};                              ///< UTF-8 name.
+        std::shared_ptr<ISeekableByteStream> file{};     ///< File image to be stored as is,
+        std::shared_ptr<IRandomAccessWaveBuffer> wave{}; ///< or PCM samples to be stored raw.
+    };
+
+    /// Writes a sample pack.
+    void WriteSamplePack(const std::filesystem::path& path, const std::vector<SamplePackSource>& sources);
+}
@@ -0,0 +1,229 @@
+/// @file
+/// @brief  Vse - Decoded Wave Cache
+/// @author (C) 2022 ttsuki
+
+#include "WaveCache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <functional>
+
+#include "../base/win32/file_mapping.h"
+#include "../base/xtl/xtl_fnv1a_hash.h"
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "WaveFileLoader.h"
+
+namespace vse
+{
+    namespace
+    {
+        // Cache file layout:
+        //   [0, sizeof(WaveCacheFileHeader))   header
+        //   [data_offset, +data_length)        PCM samples in `format`, page aligned.
+        struct WaveCacheFileHeader
+        {
+            static constexpr uint32_t Magic = 0x43455356; // "VSEC"
+            static constexpr uint32_t Version = 1;
+            static constexpr uint64_t DataAlignment = 4096;
+
+            uint32_t magic;
+            uint32_t version;
+
+            // cache key
+            uint64_t source_hash;
+            uint64_t source_length;
+            uint32_t requested_sample_type;
+            uint32_t requested_channel_mask;
+            int32_t requested_frequency;
+
+            // payload
+            uint32_t sample_type;
+            uint32_t channel_mask;
+            int32_t frequency;
+            uint64_t data_offset;
+            uint64_t data_length;
+        };
+
+        [[nodiscard]] PcmWaveFormat GetPayloadFormat(const WaveCacheFileHeader& header)
+        {
+            return PcmWaveFormat(static_cast<SampleType>(header.sample_type), static_cast<SpeakerBit>(header.channel_mask), header.frequency);
+        }
+
+        [[nodiscard]] bool IsSameKey(const WaveCacheFileHeader& lhs, const WaveCacheFileHeader& rhs)
+        {
+            return lhs.source_hash == rhs.source_hash
+                && lhs.source_length == rhs.source_length
+                && lhs.requested_sample_type == rhs.requested_sample_type
+                && lhs.requested_channel_mask == rhs.requested_channel_mask
+                && lhs.requested_frequency == rhs.requested_frequency;
+        }
+
+        [[nodiscard]] WaveCacheFileHeader MakeCacheKey(const void* file_image, size_t length, PcmWaveFormat desired_format)
+        {
+            WaveCacheFileHeader key{};
+            key.magic = WaveCacheFileHeader::Magic;
+            key.version = WaveCacheFileHeader::Version;
+            key.source_hash = xtl::fnv1a_hash::compute(file_image, length);
+            key.source_length = length;
+            key.requested_sample_type = static_cast<uint32_t>(desired_format.SampleType());
+            key.requested_channel_mask = +desired_format.ChannelMask();
+            key.requested_frequency = desired_format.SamplingFrequency();
+            return key;
+        }
+
+        [[nodiscard]] std::filesystem::path GetCacheFilePath(const std::filesystem::path& cache_directory, const WaveCacheFileHeader& key)
+        {
+            const auto format_hash = xtl::fnv1a_hash()
+                                     .update(key.requested_sample_type)
+                                     .update(key.requested_channel_mask)
+                                     .update(key.requested_frequency)
+                                     .value();
+
+            char name[64]{};
+            std::snprintf(name, sizeof(name), "%016llx-%08llx-%08x.vsecache",
+                          static_cast<unsigned long long>(key.source_hash),
+                          static_cast<unsigned long long>(key.source_length),
+                          static_cast<uint32_t>(format_hash));
+
+            return cache_directory / name;
+        }
+
+        [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> MapCacheFile(const std::filesystem::path& cache_file, const WaveCacheFileHeader* expected_key)
+        {
+            auto file = std::make_shared<win32::mapped_file>(cache_file, true);
+            if (file->size() < sizeof(WaveCacheFileHeader))
+                return nullptr;
+
+            WaveCacheFileHeader header{};
+            std::memcpy(&header, file->data(), sizeof(header));
+
+            if (header.magic != WaveCacheFileHeader::Magic || header.version != WaveCacheFileHeader::Version)
+                return nullptr;
+
+            if (expected_key && !IsSameKey(header, *expected_key))
+                return nullptr;
+
+            if (header.data_offset > file->size() || header.data_length > file->size() - header.data_offset)
+                return nullptr; // truncated
+
+            const PcmWaveFormat format = GetPayloadFormat(header);
+            if (!format || format.BlockAlign() == 0 || header.data_length % format.BlockAlign() != 0)
+                return nullptr;
+
+            void* data = static_cast<std::byte*>(file->data()) + header.data_offset;
+            return AttachWaveBuffer(
+                std::shared_ptr<void>(std::move(file), data),
+                static_cast<size_t>(header.data_length),
+                format);
+        }
+
+        // Writes to a temporary file, then renames it, so that readers never see a partial file.
+        void WriteCacheFile(const std::filesystem::path& cache_file, WaveCacheFileHeader header, const IRandomAccessWaveBuffer& buffer)
+        {
+            const PcmWaveFormat format = buffer.GetFormat();
+            header.sample_type = static_cast<uint32_t>(format.SampleType());
+            header.channel_mask = +format.ChannelMask();
+            header.frequency = format.SamplingFrequency();
+            header.data_offset = WaveCacheFileHeader::DataAlignment;
+            header.data_length = buffer.Size();
+
+            std::filesystem::path temp_file = cache_file;
+            temp_file += ".tmp." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+            {
+                std::ofstream stream(temp_file, std::ios::out | std::ios::binary | std::ios::trunc);
+                if (!stream) return;
+
+                std::byte padding[WaveCacheFileHeader::DataAlignment]{};
+                std::memcpy(padding, &header, sizeof(header));
+                stream.write(reinterpret_cast<const char*>(padding), sizeof(padding));
+
+                auto temp_buffer = xtl::temp_memory_buffer();
+                for (size_t i = 0; i < buffer.Size();)
+                {
+                    constexpr size_t buf_size = 65536;
+                    void* p = temp_buffer.get(buf_size);
+                    size_t sz = buffer.Read(p, i, buf_size);
+                    if (sz == 0) break;
+                    stream.write(static_cast<const char*>(p), static_cast<std::streamsize>(sz));
+                    i += sz;
+                }
+
+                if (!stream.flush())
+                {
+                    stream.close();
+                    std::error_code ec{};
+                    std::filesystem::remove(temp_file, ec);
+                    return;
+                }
+            }
+
+            std::error_code ec{};
+            std::filesystem::rename(temp_file, cache_file, ec);
+            if (ec) std::filesystem::remove(temp_file, ec);
+        }
+    }
+
+    std::shared_ptr<IRandomAccessWaveBuffer> OpenWaveCacheFile(const std::filesystem::path& cache_file)
+    {
+        return MapCacheFile(cache_file, nullptr);
+    }
+
+    std::shared_ptr<IRandomAccessWaveBuffer> LoadAudioFileCached(const std::filesystem::path& cache_directory, std::shared_ptr<const void> file_image, size_t length, PcmWaveFormat desired_format)
+    {
+        auto decode = [&]
+        {
+            return desired_format
+                       ? LoadAudioFile(file_image, length, desired_format)
+                       : LoadAudioFile(file_image, length);
+        };
+
+        if (cache_directory.empty())
+            return decode();
+
+        const WaveCacheFileHeader key = MakeCacheKey(file_image.get(), length, desired_format);
+        const std::filesystem::path cache_file = GetCacheFilePath(cache_directory, key);
+
+        // hit
+        try
+        {
+            if (std::filesystem::is_regular_file(cache_file))
+                if (auto cached = MapCacheFile(cache_file, &key))
+                    return cached;
+        }
+        catch (const std::exception&)
+        {
+            // falls back to decoding.
+        }
+
+        // miss: decodes, then stores. a failure to store is not an error.
+        auto decoded = decode();
+        try
+        {
+            std::error_code ec{};
+            std::filesystem::create_directories(cache_directory, ec);
+            if (decoded) WriteCacheFile(cache_file, key, *decoded);
+        }
+        catch (const std::exception&)
+        {
+            // ignored
+        }
+
+        return decoded;
+    }
+
+    std::shared_ptr<IRandomAccessWaveBuffer> LoadAudioFileCached(const std::filesystem::path& cache_directory, const std::filesystem::path& path, PcmWaveFormat desired_format)
+    {
+        size_t length{};
+        auto file_image = win32::map_file_shared(path, &length);
+        return LoadAudioFileCached(cache_directory, std::move(file_image), length, desired_format);
+    }
+}
@@ -0,0 +1,27 @@
+/// @file
+/// @brief  Vse - Decoded Wave Cache
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include "../base/IWaveSource.h"
+#include "../base/RandomAccessWaveBuffer.h"
+
+#include <memory>
+#include <filesystem>
+
+namespace vse
+{
+    /// Maps a cache file written by LoadAudioFileCached.
+    /// The returned buffer is backed by a copy-on-write view: writes are private and never reach the file.
+    /// @returns nullptr if the file is not a valid cache file.
+    [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> OpenWaveCacheFile(const std::filesystem::path& cache_file);
+
+    /// Loads and decodes an audio file through the on-disk cache.
+    /// Decoded (and format-converted) PCM is stored in cache_directory, keyed by the hash of the file image and desired_format.
+    /// Later loads of the same file image map the cache file directly instead of decoding again.
+    /// @param cache_directory Cache directory. If empty, the cache is bypassed.
+    /// @param desired_format Output format. If empty, the decoder's native format is used.
+    [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> LoadAudioFileCached(const std::filesystem::path& cache_directory, std::shared_ptr<const void> file_image, size_t length, PcmWaveFormat desired_format = {});
+    [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> LoadAudioFileCached(const std::filesystem::path& cache_directory, const std::filesystem::path& path, PcmWaveFormat desired_format = {});
+}
@@ -114,7 +114,7 @@ namespace vse
         return destination;
     }
 
-    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceForFile(std::shared_ptr<ISeekableByteStream> file)
+    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceForFile(std::shared_ptr<ISeekableByteStream> file, SampleType preferred_sample_type)
     {
         DWORD four_cc{};
         if (file->Read(&four_cc, 4) != 4)
@@ -125,7 +125,13 @@ namespace vse
         if (!pcm_stream && four_cc == 0x5367674f)
         {
             (void)file->Seek(0);
-            pcm_stream = CreateWaveSourceOggVorbis(file);
+            pcm_stream = CreateWaveSourceOggVorbis(file, preferred_sample_type == SampleType::F32 ? SampleType::F32 : SampleType::S16);
+        }
+
+        if (!pcm_stream && four_cc == 0x43614c66)
+        {
+            (void)file->Seek(0);
+            pcm_stream = CreateWaveSourceFlac(file);
         }
 
         if (!pcm_stream)
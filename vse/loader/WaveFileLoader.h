@@ -20,16 +20,18 @@ namespace vse
     [[nodiscard]] inline std::shared_ptr<ISeekableByteStream> LoadFile(const std::filesystem::path& path) { return ReadOutToMemory(OpenFile(path)); }
 
     [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceMediaFoundation(std::shared_ptr<ISeekableByteStream> file);
-    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceOggVorbis(std::shared_ptr<ISeekableByteStream> file);
-    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceForFile(std::shared_ptr<ISeekableByteStream> file);
+    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceOggVorbis(std::shared_ptr<ISeekableByteStream> file, SampleType sample_type = SampleType::S16);
+    [[nodiscard]] std::shared_ptr<IRandomAccessWaveBuffer> DecodeOggVorbisParallel(std::shared_ptr<const void> file_image, size_t length, SampleType sample_type = SampleType::S16, size_t max_concurrency = 0);
+    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceFlac(std::shared_ptr<ISeekableByteStream> file);
+    [[nodiscard]] std::shared_ptr<IWaveSource> CreateWaveSourceForFile(std::shared_ptr<ISeekableByteStream> file, SampleType preferred_sample_type = SampleType::Unknown);
     [[nodiscard]] std::shared_ptr<IWaveSource> ConvertWaveFormat(std::shared_ptr<IWaveSource> source, PcmWaveFormat desired_format);
 
     [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(const std::filesystem::path& path) { return CreateWaveSourceForFile(OpenFile(path)); }
-    [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(const std::filesystem::path& path, PcmWaveFormat desired_format) { return ConvertWaveFormat(OpenAudioFile(path), desired_format); }
+    [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(const std::filesystem::path& path, PcmWaveFormat desired_format) { return ConvertWaveFormat(CreateWaveSourceForFile(OpenFile(path), desired_format.SampleType()), desired_format); }
     [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(std::shared_ptr<const void> file_image, size_t length) { return CreateWaveSourceForFile(OpenFile(std::move(file_image), length)); }
-    [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(std::shared_ptr<const void> file_image, size_t length, PcmWaveFormat desired_format) { return ConvertWaveFormat(OpenAudioFile(std::move(file_image), length), desired_format); }
+    [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(std::shared_ptr<const void> file_image, size_t length, PcmWaveFormat desired_format) { return ConvertWaveFormat(CreateWaveSourceForFile(OpenFile(std::move(file_image), length), desired_format.SampleType()), desired_format); }
     [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(std::shared_ptr<ISeekableByteStream> file) { return CreateWaveSourceForFile(std::move(file)); }
-    [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(std::shared_ptr<ISeekableByteStream> file, PcmWaveFormat desired_format) { return ConvertWaveFormat(OpenAudioFile(std::move(file)), desired_format); }
+    [[nodiscard]] inline std::shared_ptr<IWaveSource> OpenAudioFile(std::shared_ptr<ISeekableByteStream> file, PcmWaveFormat desired_format) { return ConvertWaveFormat(CreateWaveSourceForFile(std::move(file), desired_format.SampleType()), desired_format); }
 
     [[nodiscard]] inline std::shared_ptr<IRandomAccessWaveBuffer> LoadAudioFile(const std::filesystem::path& path) { return ReadOutToMemory(OpenAudioFile(path)); }
     [[nodiscard]] inline std::shared_ptr<IRandomAccessWaveBuffer> LoadAudioFile(const std::filesystem::path& path, PcmWaveFormat desired_format) { return ReadOutToMemory(OpenAudioFile(path, desired_format)); }
@@ -0,0 +1,718 @@
+/// @file
+/// @brief  Vse - Wave Decoder (FLAC)
+/// @author (C) 2022 ttsuki
+///
+/// A native implementation of FLAC decoder.
+/// https://xiph.org/flac/format.html
+
+#include "WaveFileLoader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "../base/IByteStream.h"
+#include "../base/IWaveSource.h"
+
+namespace vse
+{
+    namespace
+    {
+        static inline int CountLeadingZeros64(uint64_t v) noexcept
+        {
+#if defined(_MSC_VER)
+            unsigned long index{};
+            return _BitScanReverse64(&index, v) ? 63 - static_cast<int>(index) : 64;
+#else
+            return v ? __builtin_clzll(v) : 64;
+#endif
+        }
+
+        /// Invalid or corrupt data. The decoder skips to the next frame.
+        class FlacFormatError final : public std::runtime_error
+        {
+        public:
+            using std::runtime_error::runtime_error;
+        };
+
+        /// CRC-8 (x^8 + x^2 + x + 1) of frame header.
+        static inline uint8_t FlacCrc8(const uint8_t* data, size_t length, uint8_t crc = 0) noexcept
+        {
+            static constexpr auto table = []
+            {
+                std::array<uint8_t, 256> t{};
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++) c = c & 0x80 ? (c << 1) ^ 0x07 : c << 1;
+                    t[i] = static_cast<uint8_t>(c);
+                }
+                return t;
+            }();
+
+            for (size_t i = 0; i < length; i++) crc = table[crc ^ data[i]];
+            return crc;
+        }
+
+        /// CRC-16 (x^16 + x^15 + x^2 + 1) of whole frame.
+        static inline uint16_t FlacCrc16(const uint8_t* data, size_t length, uint16_t crc = 0) noexcept
+        {
+            static constexpr auto table = []
+            {
+                std::array<uint16_t, 256> t{};
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    uint32_t c = i << 8;
+                    for (int k = 0; k < 8; k++) c = c & 0x8000 ? (c << 1) ^ 0x8005 : c << 1;
+                    t[i] = static_cast<uint16_t>(c);
+                }
+                return t;
+            }();
+
+            for (size_t i = 0; i < length; i++) crc = static_cast<uint16_t>(crc << 8 ^ table[(crc >> 8) ^ data[i]]);
+            return crc;
+        }
+
+        /// Buffered MSB-first bit reader over ISeekableByteStream.
+        class FlacBitReader final
+        {
+            std::shared_ptr<ISeekableByteStream> stream_{};
+            std::vector<uint8_t> buffer_ = std::vector<uint8_t>(65536);
+            size_t buffer_position_{}; // stream position of buffer_[0]
+            size_t buffer_cursor_{};
+            size_t buffer_length_{};
+            uint64_t cache_{}; // left aligned
+            int cache_bits_{};
+            bool capturing_{};
+            std::vector<uint8_t> captured_{}; // bytes loaded into cache_ since BeginCapture, for CRC.
+
+            bool Fill()
+            {
+                while (cache_bits_ <= 56)
+                {
+                    if (buffer_cursor_ == buffer_length_)
+                    {
+                        buffer_position_ += buffer_length_;
+                        buffer_cursor_ = 0;
+                        buffer_length_ = stream_->Read(buffer_.data(), buffer_.size());
+                        if (buffer_length_ == 0) break;
+                    }
+
+                    if (capturing_) captured_.push_back(buffer_[buffer_cursor_]);
+                    cache_ |= static_cast<uint64_t>(buffer_[buffer_cursor_++]) << (56 - cache_bits_);
+                    cache_bits_ += 8;
+                }
+                return cache_bits_ != 0;
+            }
+
+        public:
+            explicit FlacBitReader(std::shared_ptr<ISeekableByteStream> stream) : stream_(std::move(stream)) { Seek(0); }
+
+            /// Gets the byte position. (valid only on byte boundary)
+            [[nodiscard]] size_t Tell() const noexcept { return buffer_position_ + buffer_cursor_ - cache_bits_ / 8; }
+            [[nodiscard]] size_t Size() const noexcept { return stream_->Size(); }
+
+            void Seek(size_t position)
+            {
+                buffer_position_ = stream_->Seek(position);
+                buffer_cursor_ = 0;
+                buffer_length_ = 0;
+                cache_ = 0;
+                cache_bits_ = 0;
+                capturing_ = false;
+            }
+
+            /// Starts keeping the bytes read from here. (on byte boundary)
+            void BeginCapture()
+            {
+                captured_.clear();
+                for (int i = 0; i < cache_bits_ / 8; i++)
+                    captured_.push_back(static_cast<uint8_t>(cache_ >> (56 - i * 8)));
+                capturing_ = true;
+            }
+
+            void EndCapture() noexcept { capturing_ = false; }
+
+            /// Gets the bytes read since BeginCapture. (valid only on byte boundary)
+            [[nodiscard]] const uint8_t* Captured(size_t* length) const noexcept
+            {
+                *length = captured_.size() - static_cast<size_t>(cache_bits_ / 8);
+                return captured_.data();
+            }
+
+            [[nodiscard]] bool IsEndOfStream()
+            {
+                return cache_bits_ == 0 && !Fill();
+            }
+
+            void AlignToByte() noexcept
+            {
+                int n = cache_bits_ % 8;
+                cache_ <<= n;
+                cache_bits_ -= n;
+            }
+
+            /// Reads n (<= 32) bits.
+            [[nodiscard]] uint32_t Read(int n)
+            {
+                if (n == 0) return 0;
+                if (cache_bits_ < n && (Fill(), cache_bits_ < n))
+                    throw FlacFormatError("FLAC: unexpected end of stream.");
+
+                auto value = static_cast<uint32_t>(cache_ >> (64 - n));
+                cache_ <<= n;
+                cache_bits_ -= n;
+                return value;
+            }
+
+            /// Reads n (<= 32) bits as signed integer.
+            [[nodiscard]] int32_t ReadSigned(int n)
+            {
+                if (n == 0) return 0;
+                return static_cast<int32_t>(Read(n) << (32 - n)) >> (32 - n);
+            }
+
+            /// Reads unary coded number. (count of 0s followed by 1)
+            [[nodiscard]] uint32_t ReadUnary()
+            {
+                uint32_t count = 0;
+                while (true)
+                {
+                    if (cache_bits_ == 0 && !Fill())
+                        throw FlacFormatError("FLAC: unexpected end of stream.");
+
+                    int zeros = CountLeadingZeros64(cache_);
+                    if (zeros < cache_bits_)
+                    {
+                        cache_ = zeros < 63 ? cache_ << (zeros + 1) : 0;
+                        cache_bits_ -= zeros + 1;
+                        return count + zeros;
+                    }
+
+                    count += cache_bits_;
+                    cache_ = 0;
+                    cache_bits_ = 0;
+                }
+            }
+
+            /// Reads UTF-8 like coded number in frame header.
+            [[nodiscard]] uint64_t ReadUtf8Number()
+            {
+                uint32_t head = Read(8);
+                if (head < 0x80) return head;
+
+                int extra = 0;
+                while (head & (0x40u >> extra)) extra++;
+                if (extra == 0 || extra > 6) throw FlacFormatError("FLAC: invalid frame number.");
+
+                uint64_t value = head & (0x3Fu >> extra);
+                for (int i = 0; i < extra; i++)
+                {
+                    uint32_t c = Read(8);
+                    if ((c & 0xC0) != 0x80) throw FlacFormatError("FLAC: invalid frame number.");
+                    value = value << 6 | (c & 0x3F);
+                }
+                return value;
+            }
+        };
+
+        struct FlacStreamInfo
+        {
+            uint32_t min_block_size{};
+            uint32_t max_block_size{};
+            uint32_t sample_rate{};
+            uint32_t channels{};
+            uint32_t bits_per_sample{};
+            uint64_t total_samples{};
+        };
+
+        struct FlacSeekPoint
+        {
+            uint64_t sample_number{};
+            uint64_t stream_offset{}; // from the first frame header
+        };
+
+        /// FLAC channel assignment -> WAVEFORMATEXTENSIBLE channel mask. (FLAC channel order is the same as Windows's)
+        static constexpr SpeakerBit FlacChannelMask(uint32_t channel_count)
+        {
+            switch (channel_count)
+            {
+            case 1: return SpeakerBit::SpeakerSet_1_0ch;
+            case 2: return SpeakerBit::SpeakerSet_2_0ch;
+            case 3: return SpeakerBit::FrontPair | SpeakerBit::FrontCenter;
+            case 4: return SpeakerBit::SpeakerSet_4_0ch;
+            case 5: return SpeakerBit::FrontPair | SpeakerBit::FrontCenter | SpeakerBit::BackPair;
+            case 6: return SpeakerBit::SpeakerSet_5_1ch;
+            case 7: return SpeakerBit::FrontPair | SpeakerBit::CenterPair | SpeakerBit::BackCenter | SpeakerBit::SidePair;
+            case 8: return SpeakerBit::SpeakerSet_7_1ch;
+            default: return SpeakerBit::None;
+            }
+        }
+
+        class FlacWaveSourceImpl final : public ISeekableWaveSource
+        {
+            FlacBitReader reader_;
+            FlacStreamInfo info_{};
+            std::vector<FlacSeekPoint> seek_table_{};
+            size_t first_frame_offset_{};
+
+            PcmWaveFormat format_{};
+            int output_shift_{};
+
+            // current decoded frame
+            std::array<std::vector<int32_t>, 8> channel_{};
+            uint64_t block_first_sample_{};
+            size_t block_length_{};
+            size_t block_cursor_{};
+
+        public:
+            FlacWaveSourceImpl(std::shared_ptr<ISeekableByteStream> file, FlacStreamInfo info, std::vector<FlacSeekPoint> seek_table, size_t first_frame_offset)
+                : reader_(std::move(file))
+                , info_(info)
+                , seek_table_(std::move(seek_table))
+                , first_frame_offset_(first_frame_offset)
+            {
+                SampleType type =
+                    info_.bits_per_sample <= 16 ? SampleType::S16 :
+                    info_.bits_per_sample <= 24 ? SampleType::S24 :
+                    SampleType::S32;
+
+                format_ = PcmWaveFormat{type, FlacChannelMask(info_.channels), static_cast<int>(info_.sample_rate)};
+                output_shift_ = format_.BitsPerSample() - static_cast<int>(info_.bits_per_sample);
+
+                for (uint32_t i = 0; i < info_.channels; i++)
+                    channel_[i].resize(std::max<size_t>(info_.max_block_size, 16));
+
+                reader_.Seek(first_frame_offset_);
+            }
+
+            [[nodiscard]] PcmWaveFormat GetFormat() const override { return format_; }
+
+            [[nodiscard]] size_t Read(void* buffer, size_t buffer_length) override
+            {
+                const size_t block_align = format_.BlockAlign();
+                const size_t count = buffer_length / block_align;
+
+                size_t wrote = 0;
+                while (wrote < count)
+                {
+                    if (block_cursor_ == block_length_ && !DecodeNextFrame())
+                        break;
+
+                    size_t n = std::min(count - wrote, block_length_ - block_cursor_);
+                    void* dst = static_cast<std::byte*>(buffer) + wrote * block_align;
+
+                    if (format_.SampleType() == SampleType::S16) InterleaveTo(static_cast<S16*>(dst), n);
+                    if (format_.SampleType() == SampleType::S24) InterleaveTo(static_cast<S24*>(dst), n);
+                    if (format_.SampleType() == SampleType::S32) InterleaveTo(static_cast<S32*>(dst), n);
+
+                    block_cursor_ += n;
+                    wrote += n;
+                }
+
+                return wrote * block_align;
+            }
+
+            [[nodiscard]] size_t GetTotalSampleCount() const override { return static_cast<size_t>(info_.total_samples); }
+            [[nodiscard]] size_t GetSampleCursor() const override { return static_cast<size_t>(block_first_sample_ + block_cursor_); }
+
+            size_t SetSampleCursor(size_t new_position) override
+            {
+                const uint64_t target = info_.total_samples ? std::min<uint64_t>(new_position, info_.total_samples) : new_position;
+
+                // in current block
+                if (target >= block_first_sample_ && target < block_first_sample_ + block_length_)
+                {
+                    block_cursor_ = static_cast<size_t>(target - block_first_sample_);
+                    return GetSampleCursor();
+                }
+
+                // seek to the nearest preceding seek point (or go forward from the current frame)
+                auto it = std::upper_bound(
+                    seek_table_.begin(), seek_table_.end(), target,
+                    [](uint64_t t, const FlacSeekPoint& p) { return t < p.sample_number; });
+
+                const uint64_t seek_point_sample = it != seek_table_.begin() ? std::prev(it)->sample_number : 0;
+                const uint64_t seek_point_offset = it != seek_table_.begin() ? std::prev(it)->stream_offset : 0;
+                if (!(target >= block_first_sample_ + block_length_ && block_first_sample_ + block_length_ >= seek_point_sample))
+                {
+                    reader_.Seek(first_frame_offset_ + static_cast<size_t>(seek_point_offset));
+                    block_first_sample_ = seek_point_sample;
+                    block_length_ = 0;
+                    block_cursor_ = 0;
+                }
+
+                // decode frames until the frame which contains target
+                while (true)
+                {
+                    if (!DecodeNextFrame()) break;
+                    if (target < block_first_sample_ + block_length_)
+                    {
+                        block_cursor_ = static_cast<size_t>(target - std::min(target, block_first_sample_));
+                        break;
+                    }
+                }
+
+                return GetSampleCursor();
+            }
+
+        private:
+            template <class T>
+            void InterleaveTo(T* dst, size_t count) const noexcept
+            {
+                const size_t channels = info_.channels;
+                const int shift = output_shift_;
+                for (size_t c = 0; c < channels; c++)
+                {
+                    const int32_t* src = channel_[c].data() + block_cursor_;
+                    for (size_t i = 0; i < count; i++)
+                        dst[i * channels + c] = static_cast<T>(src[i] << shift);
+                }
+            }
+
+            /// Decodes the next frame. Corrupt frames are skipped and replaced with silence.
+            /// @returns false at the end of stream.
+            /// @throw std::runtime_error The stream ends before the total sample count in STREAMINFO.
+            bool DecodeNextFrame()
+            {
+                const uint64_t expected = block_first_sample_ + block_length_;
+                block_first_sample_ = expected;
+                block_length_ = 0;
+                block_cursor_ = 0;
+
+                for (bool skipped = false;;)
+                {
+                    // sync code: 0b11111111111110
+                    uint8_t sync[2]{};
+                    for (uint32_t previous = 0;;)
+                    {
+                        if (reader_.IsEndOfStream())
+                        {
+                            if (info_.total_samples && expected < info_.total_samples)
+                                throw std::runtime_error("FLAC: unexpected end of stream.");
+                            return false;
+                        }
+
+                        uint32_t b = reader_.Read(8);
+                        if (previous == 0xFF && (b & 0xFE) == 0xF8)
+                        {
+                            sync[0] = 0xFF;
+                            sync[1] = static_cast<uint8_t>(b);
+                            break;
+                        }
+                        previous = b;
+                    }
+
+                    const size_t frame_position = reader_.Tell() - 2;
+                    try
+                    {
+                        DecodeFrame(sync);
+                    }
+                    catch (const FlacFormatError&)
+                    {
+                        // resyncs: searches the next sync code from the byte after this one.
+                        reader_.Seek(frame_position + 1);
+                        skipped = true;
+                        continue;
+                    }
+
+                    // fills the samples of skipped frames with silence to keep the timeline.
+                    if (skipped && block_first_sample_ > expected)
+                    {
+                        const size_t gap = static_cast<size_t>(block_first_sample_ - expected);
+                        for (size_t c = 0; c < info_.channels; c++)
+                            channel_[c].insert(channel_[c].begin(), gap, 0);
+                        block_first_sample_ = expected;
+                        block_length_ += gap;
+                    }
+
+                    return block_length_ != 0;
+                }
+            }
+
+            /// Decodes a frame following the sync code.
+            /// @throw FlacFormatError corrupt frame
+            void DecodeFrame(const uint8_t (&sync)[2])
+            {
+                const bool variable_block_size = sync[1] & 1;
+                reader_.BeginCapture();
+
+                // frame header
+                const uint32_t block_size_code = reader_.Read(4);
+                const uint32_t sample_rate_code = reader_.Read(4);
+                const uint32_t channel_assignment = reader_.Read(4);
+                const uint32_t sample_size_code = reader_.Read(3);
+                (void)reader_.Read(1);
+                const uint64_t number = reader_.ReadUtf8Number();
+
+                uint32_t block_size{};
+                if (block_size_code == 1) block_size = 192;
+                else if (block_size_code >= 2 && block_size_code <= 5) block_size = 576u << (block_size_code - 2);
+                else if (block_size_code == 6) block_size = reader_.Read(8) + 1;
+                else if (block_size_code == 7) block_size = reader_.Read(16) + 1;
+                else if (block_size_code >= 8) block_size = 256u << (block_size_code - 8);
+                else throw FlacFormatError("FLAC: invalid block size.");
+
+                if (sample_rate_code == 12) (void)reader_.Read(8);
+                else if (sample_rate_code == 13 || sample_rate_code == 14) (void)reader_.Read(16);
+                else if (sample_rate_code == 15) throw FlacFormatError("FLAC: invalid sample rate.");
+
+                static constexpr uint32_t sample_size_table[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+                const uint32_t bps = sample_size_code ? sample_size_table[sample_size_code] : info_.bits_per_sample;
+                if (bps == 0 || bps != info_.bits_per_sample) throw FlacFormatError("FLAC: invalid sample size.");
+
+                size_t length{};
+                const uint8_t* header = reader_.Captured(&length);
+                if (reader_.Read(8) != FlacCrc8(header, length, FlacCrc8(sync, 2)))
+                    throw FlacFormatError("FLAC: frame header CRC mismatch.");
+
+                const uint32_t channels = channel_assignment < 8 ? channel_assignment + 1 : 2;
+                if (channels != info_.channels || channel_assignment > 10) throw FlacFormatError("FLAC: invalid channel assignment.");
+                if (block_size > channel_[0].size())
+                    for (uint32_t c = 0; c < channels; c++)
+                        channel_[c].resize(block_size);
+
+                // subframes
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    uint32_t subframe_bps = bps;
+                    if ((channel_assignment == 8 && c == 1) || (channel_assignment == 9 && c == 0) || (channel_assignment == 10 && c == 1))
+                        subframe_bps++; // side channel
+
+                    if (subframe_bps > 32) throw FlacFormatError("FLAC: not supported sample size.");
+                    DecodeSubframe(channel_[c].data(), block_size, subframe_bps);
+                }
+
+                // stereo decorrelation
+                int32_t* l = channel_[0].data();
+                int32_t* r = channel_[1].data();
+                switch (channel_assignment)
+                {
+                case 8: for (uint32_t i = 0; i < block_size; i++) r[i] = l[i] - r[i];
+                    break;
+                case 9: for (uint32_t i = 0; i < block_size; i++) l[i] += r[i];
+                    break;
+                case 10: for (uint32_t i = 0; i < block_size; i++)
+                    {
+                        int32_t side = r[i];
+                        int32_t mid = static_cast<int32_t>(static_cast<uint32_t>(l[i]) << 1) | (side & 1);
+                        l[i] = (mid + side) >> 1;
+                        r[i] = (mid - side) >> 1;
+                    }
+                    break;
+                default: break;
+                }
+
+                // frame footer
+                reader_.AlignToByte();
+                const uint8_t* frame = reader_.Captured(&length);
+                const uint16_t crc = FlacCrc16(frame, length, FlacCrc16(sync, 2));
+                if (reader_.Read(16) != crc)
+                    throw FlacFormatError("FLAC: frame CRC mismatch.");
+                reader_.EndCapture();
+
+                block_first_sample_ = variable_block_size ? number : number * info_.max_block_size;
+                block_length_ = block_size;
+
+                if (info_.total_samples && block_first_sample_ + block_length_ > info_.total_samples)
+                    block_length_ = static_cast<size_t>(info_.total_samples - std::min(info_.total_samples, block_first_sample_));
+            }
+
+            void DecodeSubframe(int32_t* out, uint32_t block_size, uint32_t bps)
+            {
+                if (reader_.Read(1) != 0) throw FlacFormatError("FLAC: invalid subframe.");
+                const uint32_t type = reader_.Read(6);
+
+                uint32_t wasted_bits = 0;
+                if (reader_.Read(1)) wasted_bits = reader_.ReadUnary() + 1;
+                if (wasted_bits >= bps) throw FlacFormatError("FLAC: invalid subframe.");
+                bps -= wasted_bits;
+
+                if (type == 0) // CONSTANT
+                {
+                    std::fill_n(out, block_size, reader_.ReadSigned(static_cast<int>(bps)));
+                }
+                else if (type == 1) // VERBATIM
+                {
+                    for (uint32_t i = 0; i < block_size; i++)
+                        out[i] = reader_.ReadSigned(static_cast<int>(bps));
+                }
+                else if (type >= 8 && type <= 12) // FIXED
+                {
+                    const uint32_t order = type - 8;
+                    if (order > block_size) throw FlacFormatError("FLAC: invalid subframe.");
+                    for (uint32_t i = 0; i < order; i++)
+                        out[i] = reader_.ReadSigned(static_cast<int>(bps));
+
+                    DecodeResidual(out, block_size, order);
+                    RestoreFixedPrediction(out, block_size, order);
+                }
+                else if (type >= 32) // LPC
+                {
+                    const uint32_t order = type - 31;
+                    if (order > block_size) throw FlacFormatError("FLAC: invalid subframe.");
+                    for (uint32_t i = 0; i < order; i++)
+                        out[i] = reader_.ReadSigned(static_cast<int>(bps));
+
+                    const uint32_t precision = reader_.Read(4) + 1;
+                    if (precision == 16) throw FlacFormatError("FLAC: invalid LPC precision.");
+                    const int32_t shift = reader_.ReadSigned(5);
+                    if (shift < 0) throw FlacFormatError("FLAC: invalid LPC shift.");
+
+                    int32_t coefficients[32]{};
+                    for (uint32_t i = 0; i < order; i++)
+                        coefficients[i] = reader_.ReadSigned(static_cast<int>(precision));
+
+                    DecodeResidual(out, block_size, order);
+                    RestoreLpcPrediction(out, block_size, order, coefficients, shift);
+                }
+                else
+                {
+                    throw FlacFormatError("FLAC: invalid subframe type.");
+                }
+
+                if (wasted_bits)
+                    for (uint32_t i = 0; i < block_size; i++)
+                        out[i] = static_cast<int32_t>(static_cast<uint32_t>(out[i]) << wasted_bits);
+            }
+
+            void DecodeResidual(int32_t* out, uint32_t block_size, uint32_t predictor_order)
+            {
+                const uint32_t method = reader_.Read(2);
+                if (method > 1) throw FlacFormatError("FLAC: invalid residual coding method.");
+
+                const int parameter_bits = method == 0 ? 4 : 5;
+                const uint32_t escape_code = method == 0 ? 15 : 31;
+                const uint32_t partition_order = reader_.Read(4);
+                const uint32_t partition_count = 1u << partition_order;
+                const uint32_t partition_size = block_size >> partition_order;
+                if (partition_size < predictor_order || (partition_size << partition_order) != block_size)
+                    throw FlacFormatError("FLAC: invalid residual partition.");
+
+                uint32_t i = predictor_order;
+                for (uint32_t p = 0; p < partition_count; p++)
+                {
+                    const uint32_t end = (p + 1) * partition_size;
+                    const uint32_t parameter = reader_.Read(parameter_bits);
+                    if (parameter == escape_code)
+                    {
+                        const int bits = static_cast<int>(reader_.Read(5));
+                        for (; i < end; i++) out[i] = reader_.ReadSigned(bits);
+                    }
+                    else
+                    {
+                        for (; i < end; i++)
+                        {
+                            uint32_t q = reader_.ReadUnary();
+                            uint32_t v = q << parameter | reader_.Read(static_cast<int>(parameter));
+                            out[i] = static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+                        }
+                    }
+                }
+            }
+
+            static void RestoreFixedPrediction(int32_t* s, uint32_t block_size, uint32_t order) noexcept
+            {
+                switch (order)
+                {
+                case 0: break;
+                case 1: for (uint32_t i = 1; i < block_size; i++) s[i] += s[i - 1];
+                    break;
+                case 2: for (uint32_t i = 2; i < block_size; i++) s[i] += 2 * s[i - 1] - s[i - 2];
+                    break;
+                case 3: for (uint32_t i = 3; i < block_size; i++) s[i] += 3 * s[i - 1] - 3 * s[i - 2] + s[i - 3];
+                    break;
+                case 4: for (uint32_t i = 4; i < block_size; i++) s[i] += 4 * s[i - 1] - 6 * s[i - 2] + 4 * s[i - 3] - s[i - 4];
+                    break;
+                default: break;
+                }
+            }
+
+            static void RestoreLpcPrediction(int32_t* s, uint32_t block_size, uint32_t order, const int32_t* coefficients, int32_t shift) noexcept
+            {
+                for (uint32_t i = order; i < block_size; i++)
+                {
+                    int64_t sum = 0;
+                    for (uint32_t j = 0; j < order; j++)
+                        sum += static_cast<int64_t>(coefficients[j]) * s[i - 1 - j];
+                    s[i] += static_cast<int32_t>(sum >> shift);
+                }
+            }
+        };
+    }
+
+    std::shared_ptr<IWaveSource> CreateWaveSourceFlac(std::shared_ptr<ISeekableByteStream> file)
+    {
+        // the high part first: the evaluation order of operands is unspecified.
+        const auto ReadUInt64 = [](FlacBitReader& r)
+        {
+            const uint64_t high = r.Read(32);
+            const uint64_t low = r.Read(32);
+            return high << 32 | low;
+        };
+
+        FlacBitReader reader(file);
+        if (reader.IsEndOfStream() || reader.Read(32) != 0x664C6143) // "fLaC"
+            return nullptr;
+
+        FlacStreamInfo info{};
+        std::vector<FlacSeekPoint> seek_table{};
+        bool has_stream_info = false;
+
+        // metadata blocks
+        for (bool last = false; !last;)
+        {
+            last = reader.Read(1) != 0;
+            const uint32_t type = reader.Read(7);
+            const uint32_t length = reader.Read(24);
+            const size_t next = reader.Tell() + length;
+
+            if (type == 0 && length >= 34) // STREAMINFO
+            {
+                info.min_block_size = reader.Read(16);
+                info.max_block_size = reader.Read(16);
+                (void)reader.Read(24); // min frame size
+                (void)reader.Read(24); // max frame size
+                info.sample_rate = reader.Read(20);
+                info.channels = reader.Read(3) + 1;
+                info.bits_per_sample = reader.Read(5) + 1;
+                const uint64_t total_samples_high = reader.Read(4);
+                const uint64_t total_samples_low = reader.Read(32);
+                info.total_samples = total_samples_high << 32 | total_samples_low;
+                has_stream_info = true;
+            }
+            else if (type == 3) // SEEKTABLE
+            {
+                for (uint32_t i = 0; i < length / 18; i++)
+                {
+                    FlacSeekPoint point{};
+                    point.sample_number = ReadUInt64(reader);
+                    point.stream_offset = ReadUInt64(reader);
+                    (void)reader.Read(16); // frame samples
+                    if (point.sample_number != ~uint64_t{}) // placeholder
+                        seek_table.push_back(point);
+                }
+            }
+            else if (type == 127)
+            {
+                return nullptr; // invalid
+            }
+
+            reader.Seek(next);
+        }
+
+        if (!has_stream_info || info.sample_rate == 0 || info.bits_per_sample < 4 || info.max_block_size < 16 || info.min_block_size < 16)
+            return nullptr;
+
+        std::sort(seek_table.begin(), seek_table.end(), [](const FlacSeekPoint& a, const FlacSeekPoint& b) { return a.sample_number < b.sample_number; });
+        return std::make_shared<FlacWaveSourceImpl>(std::move(file), info, std::move(seek_table), reader.Tell());
+    }
+}
@@ -11,15 +11,68 @@
 #pragma comment(lib, "vorbis.lib")
 #pragma comment(lib, "vorbisfile.lib")
 
+#include <array>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include <stdexcept>
+#include <future>
+#include <thread>
+
 #include "../base/IByteStream.h"
 #include "../base/IWaveSource.h"
+#include "../base/RandomAccessWaveBuffer.h"
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+#include "../processing/WaveformProcessing.h"
 
 #include "../base/win32/debug.h"
 
 namespace vse
 {
-    std::shared_ptr<IWaveSource> CreateWaveSourceOggVorbis(std::shared_ptr<ISeekableByteStream> file)
+    namespace
     {
+        /// Vorbis I channel order -> Windows (WAVEFORMATEXTENSIBLE) channel order.
+        ///
+        /// Vorbis I defines channel order as follows:
+        /// - one channel - the stream is monophonic
+        /// - two channels - the stream is stereo. channel order: left, right
+        /// - three channels - the stream is a 1d - surround encoding. channel order: left, center, right
+        /// - four channels - the stream is quadraphonic surround. channel order: front left, front right, rear left, rear right
+        /// - five channels - the stream is five - channel surround. channel order: front left, center, front right, rear left, rear right
+        /// - six channels - the stream is 5.1 surround. channel order: front left, center, front right, rear left, rear right, LFE
+        /// - seven channels - the stream is 6.1 surround. channel order: front left, center, front right, side left, side right, rear center, LFE
+        /// - eight channels - the stream is 7.1 surround. channel order: front left, center, front right, side left, side right, rear left, rear right, LFE
+        /// - greater than eight channels - channel use and order is undefined
+        /// Windows assumes channel order as: left, right, center, LFE, rear left, rear right, side left, side right
+        struct VorbisChannelLayout
+        {
+            SpeakerBit mask{};
+            std::array<int, 8> map{0, 1, 2, 3, 4, 5, 6, 7}; // output channel -> stream channel
+            bool is_identity{true};
+        };
+
+        static VorbisChannelLayout GetVorbisChannelLayout(int channel_count)
+        {
+            switch (channel_count)
+            {
+            case 1: return {SpeakerBit::SpeakerSet_1_0ch, {0}, true};
+            case 2: return {SpeakerBit::SpeakerSet_2_0ch, {0, 1}, true};
+            case 3: return {SpeakerBit::FrontPair | SpeakerBit::FrontCenter, {0, 2, 1}, false};
+            case 4: return {SpeakerBit::SpeakerSet_4_0ch, {0, 1, 2, 3}, true};
+            case 5: return {SpeakerBit::FrontPair | SpeakerBit::FrontCenter | SpeakerBit::BackPair, {0, 2, 1, 3, 4}, false};
+            case 6: return {SpeakerBit::SpeakerSet_5_1ch, {0, 2, 1, 5, 3, 4}, false};
+            case 7: return {SpeakerBit::FrontPair | SpeakerBit::CenterPair | SpeakerBit::BackCenter | SpeakerBit::SidePair, {0, 2, 1, 6, 5, 3, 4}, false};
+            case 8: return {SpeakerBit::SpeakerSet_7_1ch, {0, 2, 1, 7, 5, 6, 3, 4}, false};
+            default: return {DefaultChannelMask(channel_count), {0, 1, 2, 3, 4, 5, 6, 7}, true};
+            }
+        }
+    }
+
+    std::shared_ptr<IWaveSource> CreateWaveSourceOggVorbis(std::shared_ptr<ISeekableByteStream> file, SampleType sample_type)
+    {
+        if (sample_type != SampleType::S16 && sample_type != SampleType::F32)
+            throw std::invalid_argument("not supported sample type.");
+
         using SrcStream = ISeekableByteStream;
         static constexpr ov_callbacks callback
         {
@@ -57,13 +110,18 @@ namespace vse
         }
 
         vorbis_info* info = ov_info(ovf.get(), -1);
-        PcmWaveFormat format = PcmWaveFormat{SampleType::S16, DefaultChannelMask(info->channels), static_cast<int>(info->rate)};
+        if (info->channels > 8)
+            throw std::runtime_error("not supported channel count.");
+
+        const VorbisChannelLayout layout = GetVorbisChannelLayout(info->channels);
+        PcmWaveFormat format = PcmWaveFormat{sample_type, layout.mask, static_cast<int>(info->rate)};
 
         class OggVorbisWaveSourceImpl final : public ISeekableWaveSource
         {
             std::shared_ptr<SrcStream> file_{};
             std::shared_ptr<OggVorbis_File> vf_{};
             PcmWaveFormat format_{};
+            VorbisChannelLayout layout_{};
 
             int curSection_{};
 
@@ -71,37 +129,56 @@ namespace vse
             OggVorbisWaveSourceImpl(
                 std::shared_ptr<SrcStream> file,
                 std::shared_ptr<OggVorbis_File> vf,
-                PcmWaveFormat format)
-                : file_(file), vf_(vf), format_(format) { }
+                PcmWaveFormat format,
+                VorbisChannelLayout layout)
+                : file_(file), vf_(vf), format_(format), layout_(layout) { }
 
             [[nodiscard]] PcmWaveFormat GetFormat() const override { return format_; }
 
             [[nodiscard]] size_t Read(void* buffer, size_t buffer_length) override
             {
+                return format_.SampleType() == SampleType::F32
+                           ? ReadF32(static_cast<F32*>(buffer), buffer_length)
+                           : ReadS16(static_cast<S16*>(buffer), buffer_length);
+            }
+
+            [[nodiscard]] size_t GetTotalSampleCount() const override { return static_cast<size_t>(ov_pcm_total(vf_.get(), -1)); }
+            [[nodiscard]] size_t GetSampleCursor() const override { return static_cast<size_t>(ov_pcm_tell(vf_.get())); }
+            [[nodiscard]] size_t SetSampleCursor(size_t newPosition) override { return ov_pcm_seek(vf_.get(), static_cast<ogg_int64_t>(newPosition)), GetSampleCursor(); }
+
+        private:
+            size_t ReadS16(S16* buffer, size_t buffer_length)
+            {
+                const size_t channels = static_cast<size_t>(format_.ChannelCount());
+                const size_t block_align = format_.BlockAlign();
+                buffer_length = buffer_length / block_align * block_align;
+
                 size_t wrote = 0;
                 while (buffer_length - wrote)
                 {
-                    // TODO: Correct channel order more than two.
-                    /// The output channels are in stream order and not remapped. Vorbis I defines channel order as follows:
-                    /// - one channel - the stream is monophonic
-                    /// - two channels - the stream is stereo. channel order: left, right
-                    /// - three channels - the stream is a 1d - surround encoding. channel order: left, center, right
-                    /// - four channels - the stream is quadraphonic surround. channel order: front left, front right, rear left, rear right
-                    /// - five channels - the stream is five - channel surround. channel order: front left, center, front right, rear left, rear right
-                    /// - six channels - the stream is 5.1 surround. channel order: front left, center, front right, rear left, rear right, LFE
-                    /// - seven channels - the stream is 6.1 surround. channel order: front left, center, front right, side left, side right, rear center, LFE
-                    /// - eight channels - the stream is 7.1 surround. channel order: front left, center, front right, side left, side right, rear left, rear right, LFE
-                    /// - greater than eight channels - channel use and order is undefined
-                    // Windows assumes channel order as: left, right, center, LFE, rear left, rear right, side left, side right
-
                     long ret = ov_read(
                         vf_.get(),
-                        static_cast<char*>(buffer) + wrote,
-                        static_cast<int>(buffer_length - wrote),
+                        reinterpret_cast<char*>(buffer) + wrote,
+                        static_cast<int>(std::min<size_t>(buffer_length - wrote, INT_MAX)),
                         0, 2, 1,
                         &curSection_);
 
-                    if (ret > 0) { wrote += ret; }
+                    if (ret > 0)
+                    {
+                        // ov_read returns samples in stream order.
+                        if (!layout_.is_identity)
+                        {
+                            S16* p = buffer + wrote / sizeof(S16);
+                            S16 frame[8];
+                            for (size_t i = 0; i < static_cast<size_t>(ret) / block_align; i++, p += channels)
+                            {
+                                for (size_t c = 0; c < channels; c++) frame[c] = p[layout_.map[c]];
+                                for (size_t c = 0; c < channels; c++) p[c] = frame[c];
+                            }
+                        }
+
+                        wrote += ret;
+                    }
 
                     if (ret == 0)
                     {
@@ -112,11 +189,105 @@ namespace vse
                 return wrote;
             }
 
-            [[nodiscard]] size_t GetTotalSampleCount() const override { return static_cast<size_t>(ov_pcm_total(vf_.get(), -1)); }
-            [[nodiscard]] size_t GetSampleCursor() const override { return static_cast<size_t>(ov_pcm_tell(vf_.get())); }
-            [[nodiscard]] size_t SetSampleCursor(size_t newPosition) override { return ov_pcm_seek(vf_.get(), static_cast<ogg_int64_t>(newPosition)), GetSampleCursor(); }
+            size_t ReadF32(F32* buffer, size_t buffer_length)
+            {
+                const size_t channels = static_cast<size_t>(format_.ChannelCount());
+                const size_t count = buffer_length / format_.BlockAlign();
+
+                size_t wrote = 0;
+                while (count - wrote)
+                {
+                    float** pcm{};
+                    long ret = ov_read_float(
+                        vf_.get(),
+                        &pcm,
+                        static_cast<int>(std::min<size_t>(count - wrote, INT_MAX)),
+                        &curSection_);
+
+                    if (ret > 0)
+                    {
+                        // remaps and interleaves channels in one pass.
+                        const F32* src[8]{};
+                        for (size_t c = 0; c < channels; c++) src[c] = pcm[layout_.map[c]];
+                        processing::InterleaveCopy(buffer + wrote * channels, src, channels, static_cast<size_t>(ret));
+                        wrote += ret;
+                    }
+
+                    if (ret == 0)
+                    {
+                        break;
+                    }
+                }
+
+                return wrote * format_.BlockAlign();
+            }
+        };
+
+        return std::make_shared<OggVorbisWaveSourceImpl>(file, ovf, format, layout);
+    }
+
+    std::shared_ptr<IRandomAccessWaveBuffer> DecodeOggVorbisParallel(std::shared_ptr<const void> file_image, size_t length, SampleType sample_type, size_t max_concurrency)
+    {
+        auto open = [&]() -> std::shared_ptr<ISeekableWaveSource>
+        {
+            return std::dynamic_pointer_cast<ISeekableWaveSource>(CreateWaveSourceOggVorbis(OpenFile(file_image, length), sample_type));
         };
 
-        return std::make_shared<OggVorbisWaveSourceImpl>(file, ovf, format);
+        auto first = open();
+        if (!first) return nullptr;
+
+        const PcmWaveFormat format = first->GetFormat();
+        const size_t block_align = format.BlockAlign();
+        const size_t total = first->GetTotalSampleCount();
+
+        // a segment shorter than this is not worth its own stream handle (header parsing, seek bisection).
+        const size_t min_segment_length = static_cast<size_t>(format.SamplingFrequency()) * 10;
+
+        if (max_concurrency == 0)
+            max_concurrency = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+        const size_t segment_count = std::clamp<size_t>(total / std::max<size_t>(min_segment_length, 1), 1, max_concurrency);
+
+        auto destination = AllocateWaveBuffer(format);
+        (void)destination->Resize(total * block_align);
+
+        // Each segment decodes [begin, end) on its own OggVorbis_File.
+        // ov_pcm_seek is sample accurate: it decodes the preceding packet to prime the overlap-add window,
+        // so the segments join without discontinuity.
+        auto decode_segment = [&destination, block_align](const std::shared_ptr<ISeekableWaveSource>& source, size_t begin, size_t end)
+        {
+            if (source->SetSampleCursor(begin) != begin)
+                throw std::runtime_error("DecodeOggVorbisParallel: seek failed.");
+
+            auto temp_buffer = xtl::temp_memory_buffer();
+            size_t cursor = begin * block_align;
+            const size_t cursor_end = end * block_align;
+            while (cursor < cursor_end)
+            {
+                constexpr size_t buf_size = 65536;
+                const size_t sz = std::min(cursor_end - cursor, buf_size / block_align * block_align);
+                void* p = temp_buffer.get(sz);
+                const size_t rd = source->Read(p, sz);
+                (void)destination->Write(p, cursor, rd);
+                cursor += rd;
+                if (rd == 0) break; // unexpected eof
+            }
+        };
+
+        std::vector<std::future<void>> workers;
+        workers.reserve(segment_count);
+        for (size_t i = 1; i < segment_count; i++)
+        {
+            workers.emplace_back(std::async(std::launch::async, [&, i]
+            {
+                decode_segment(open(), total * i / segment_count, total * (i + 1) / segment_count);
+            }));
+        }
+
+        // the calling thread decodes the first segment with the already opened stream.
+        decode_segment(first, 0, total / segment_count);
+
+        for (auto& w : workers) w.get(); // rethrows worker's exception
+        return destination;
     }
 }
@@ -183,6 +183,11 @@ namespace vse
             return local_buffer_size_;
         }
 
+        int GetMaxBufferSize() const override
+        {
+            return local_buffer_size_;
+        }
+
         bool Start() override
         {
             if (!driver_) return DEBUG_BREAK(), false;
@@ -48,6 +48,11 @@ namespace vse
             {
                 if (thread_.joinable()) throw std::logic_error("thread is already started.");
 
+                // negotiates the render quantum: the pipeline allocates for the largest device buffer here, not on the audio thread.
+                if (input_)
+                    if (const int block_align = output_->GetFormat().Format.nBlockAlign)
+                        input_->Prepare(static_cast<size_t>(output_->GetMaxBufferSize() / block_align));
+
                 running_.test_and_set();
                 thread_ = win32::thread([this] { this->AudioRenderThreadProc(); }, 8 * 1048576);
             }
@@ -156,6 +156,11 @@ namespace vse
             return static_cast<int>(buffer_length_);
         }
 
+        int GetMaxBufferSize() const override
+        {
+            return static_cast<int>(buffer_length_);
+        }
+
         bool Start() override
         {
             if (!buffer_) return DEBUG_BREAK(), false;
@@ -25,6 +25,10 @@ namespace vse
         /// @returns the next output buffer size.
         [[nodiscard]] virtual int GetBufferSize() const = 0;
 
+        /// Gets the maximum output buffer size GetBufferSize returns.
+        /// @returns the maximum output buffer size in bytes.
+        [[nodiscard]] virtual int GetMaxBufferSize() const = 0;
+
         /// Starts the device.
         /// @returns true if the device is started successfully.
         [[nodiscard]] virtual bool Start() = 0;
@@ -304,6 +304,15 @@ namespace vse
             return (frames - padding) * device_format_.Format.nBlockAlign;
         }
 
+        int GetMaxBufferSize() const override
+        {
+            if (!audio_client_) return DEBUG_BREAK(), 0; // not initialized
+
+            UINT32 frames = 0;
+            EXPECT_SUCCESS audio_client_->GetBufferSize(&frames);
+            return frames * device_format_.Format.nBlockAlign;
+        }
+
         void* LockBuffer(int buffer_size) override
         {
             if (!audio_client_) return DEBUG_BREAK(), nullptr; // not initialized
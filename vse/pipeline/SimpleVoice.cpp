@@ -154,6 +154,12 @@ namespace vse
                 CalculateStereoVolume(volume_, pan_, lch_mix, rch_mix);
                 return ret;
             }
+
+            void Prepare(size_t max_frames) override
+            {
+                xtl::lock_guard lock(mutex_);
+                (void)format_converter_->Prepare(max_frames);
+            }
         };
 
         return std::make_shared<SimpleVoiceImpl>(std::move(source_buffer), std::move(target_mixer));
@@ -4,52 +4,215 @@
 
 #include "SourceSwitcher.h"
 
+#include <cstddef>
+#include <cstring>
+#include <cmath>
 #include <memory>
 #include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
 
 #include "../base/WaveFormat.h"
 #include "../base/IWaveSource.h"
 
 #include "../base/xtl/xtl_spin_lock_mutex.h"
+#include "../base/xtl/xtl_temp_memory_buffer.h"
 
 namespace vse
 {
-    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(PcmWaveFormat format)
+    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(PcmWaveFormat format, float crossfade_milliseconds)
     {
+        if (crossfade_milliseconds < 0.0f)
+            throw std::invalid_argument("crossfade_milliseconds");
+
+        if (crossfade_milliseconds > 0.0f && format.SampleType() != SampleType::F32)
+            throw std::invalid_argument("crossfade is not supported for the format.");
+
         class SourceSwitcherImpl : public ISourceSwitcher
         {
-            xtl::spin_lock_mutex mutex_{};
+            /// A source passed from Assign to Read by a pointer exchange.
+            struct Slot
+            {
+                std::shared_ptr<IWaveSource> source{};
+                Slot* next{}; // in retired list
+            };
+
             PcmWaveFormat format_{};
-            std::shared_ptr<IWaveSource> current_{};
+            size_t crossfade_frames_{};
+
+            // control side
+            xtl::spin_lock_mutex mutex_{};
+            std::shared_ptr<IWaveSource> assigned_{};
+            std::vector<std::weak_ptr<IWaveSource>> prepared_sources_{}; // assigned ever: the reader may be reading them.
+            size_t prepared_frames_{};
+
+            // control -> reader
+            std::atomic<Slot*> pending_{};
+
+            // reader -> control: slots no longer used by the reader, released by Assign.
+            std::atomic<Slot*> retired_{};
+
+            // reader side
+            Slot* current_{};
+            Slot* outgoing_{}; // fading out
+            size_t crossfade_position_{};
+            xtl::temp_memory_buffer outgoing_buffer_{};
+
         public:
-            explicit SourceSwitcherImpl(PcmWaveFormat format) : format_(std::move(format)) {}
+            SourceSwitcherImpl(PcmWaveFormat format, float crossfade_milliseconds)
+                : format_(std::move(format))
+                , crossfade_frames_(static_cast<size_t>(static_cast<double>(crossfade_milliseconds) * format_.SamplingFrequency() / 1000.0))
+            {
+            }
+
+            SourceSwitcherImpl(const SourceSwitcherImpl& other) = delete;
+            SourceSwitcherImpl(SourceSwitcherImpl&& other) = delete;
+            SourceSwitcherImpl& operator =(const SourceSwitcherImpl& other) = delete;
+            SourceSwitcherImpl& operator =(SourceSwitcherImpl&& other) = delete;
+
+            ~SourceSwitcherImpl() override
+            {
+                delete pending_.exchange(nullptr, std::memory_order_acquire);
+                delete current_;
+                delete outgoing_;
+                ReleaseRetired();
+            }
 
             [[nodiscard]] PcmWaveFormat GetFormat() const override { return format_; }
 
             [[nodiscard]] size_t Read(void* buffer, size_t buffer_length) override
             {
-                xtl::lock_guard lock(mutex_);
-                return current_ ? current_->Read(buffer, buffer_length) : 0;
+                // picks up the latest assignment, unless crossfading.
+                if (!outgoing_)
+                {
+                    if (Slot* next = pending_.exchange(nullptr, std::memory_order_acq_rel))
+                    {
+                        if (crossfade_frames_ && current_)
+                        {
+                            outgoing_ = current_;
+                            crossfade_position_ = 0;
+                        }
+                        else if (current_)
+                        {
+                            Retire(current_);
+                        }
+                        current_ = next;
+                    }
+                }
+
+                if (!outgoing_)
+                    return current_ && current_->source ? current_->source->Read(buffer, buffer_length) : 0;
+
+                // the rest after the crossfade completes is read from the new source.
+                const size_t read = ReadCrossfading(buffer, buffer_length);
+                if (outgoing_ || !current_->source) return read;
+                return read + current_->source->Read(static_cast<std::byte*>(buffer) + read, buffer_length - read);
             }
 
             std::shared_ptr<IWaveSource> Current() override
             {
-                return current_;
+                xtl::lock_guard lock(mutex_);
+                return assigned_;
+            }
+
+            void Prepare(size_t max_frames) override
+            {
+                xtl::lock_guard lock(mutex_);
+                prepared_frames_ = std::max(prepared_frames_, max_frames);
+                if (crossfade_frames_)
+                    outgoing_buffer_.reserve<F32>(prepared_frames_ * static_cast<size_t>(format_.ChannelCount()));
+
+                for (auto& w : prepared_sources_)
+                    if (auto s = w.lock())
+                        s->Prepare(prepared_frames_);
             }
 
             void Assign(std::shared_ptr<IWaveSource> source) override
             {
                 xtl::lock_guard lock(mutex_);
-                current_ = source;
+                assigned_ = source;
+
+                // a new source can be prepared here, since the reader has never seen it.
+                if (source)
+                {
+                    prepared_sources_.erase(std::remove_if(prepared_sources_.begin(), prepared_sources_.end(), [](auto& w) { return w.expired(); }), prepared_sources_.end());
+                    if (std::none_of(prepared_sources_.begin(), prepared_sources_.end(), [&](auto& w) { return w.lock() == source; }))
+                    {
+                        if (prepared_frames_) source->Prepare(prepared_frames_);
+                        prepared_sources_.emplace_back(source);
+                    }
+                }
+
+                // an assignment not picked up yet is overwritten.
+                delete pending_.exchange(new Slot{std::move(source)}, std::memory_order_acq_rel);
+                ReleaseRetired();
+            }
+
+        private:
+            [[nodiscard]] size_t ReadCrossfading(void* buffer, size_t buffer_length)
+            {
+                const size_t block_align = static_cast<size_t>(format_.BlockAlign());
+                const size_t channels = static_cast<size_t>(format_.ChannelCount());
+                const size_t frames = std::min(buffer_length / block_align, crossfade_frames_ - crossfade_position_);
+                const size_t length = frames * block_align;
+
+                auto* in = static_cast<F32*>(buffer);
+                auto* out = outgoing_buffer_.get<F32>(frames * channels);
+                const size_t in_read = current_->source ? current_->source->Read(in, length) : 0;
+                const size_t out_read = outgoing_->source ? outgoing_->source->Read(out, length) : 0;
+                const size_t read = std::max(in_read, out_read);
+                std::memset(reinterpret_cast<std::byte*>(in) + in_read, 0, read - in_read);
+                std::memset(reinterpret_cast<std::byte*>(out) + out_read, 0, read - out_read);
+
+                // equal-power: in = sin(theta), out = cos(theta), theta = 0 -> pi/2
+                const size_t read_frames = read / block_align;
+                const double step = 1.5707963267948966 / static_cast<double>(crossfade_frames_);
+                for (size_t i = 0; i < read_frames; i++)
+                {
+                    const double theta = static_cast<double>(crossfade_position_ + i) * step;
+                    const auto gain_in = static_cast<float>(std::sin(theta));
+                    const auto gain_out = static_cast<float>(std::cos(theta));
+                    for (size_t c = 0; c < channels; c++)
+                        in[i * channels + c] = in[i * channels + c] * gain_in + out[i * channels + c] * gain_out;
+                }
+
+                crossfade_position_ += frames;
+                if (crossfade_position_ >= crossfade_frames_ || read < length)
+                {
+                    Retire(outgoing_);
+                    outgoing_ = nullptr;
+                }
+
+                return read;
+            }
+
+            // called by the reader
+            void Retire(Slot* slot)
+            {
+                slot->next = retired_.load(std::memory_order_relaxed);
+                while (!retired_.compare_exchange_weak(slot->next, slot, std::memory_order_release, std::memory_order_relaxed)) {}
+            }
+
+            // called by the control side. takes the whole list at once.
+            void ReleaseRetired()
+            {
+                Slot* slot = retired_.exchange(nullptr, std::memory_order_acquire);
+                while (slot)
+                {
+                    Slot* next = slot->next;
+                    delete slot;
+                    slot = next;
+                }
             }
         };
 
-        return std::make_shared<SourceSwitcherImpl>(format);
+        return std::make_shared<SourceSwitcherImpl>(format, crossfade_milliseconds);
     }
 
-    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(std::shared_ptr<IWaveSource> initial_source)
+    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(std::shared_ptr<IWaveSource> initial_source, float crossfade_milliseconds)
     {
-        auto sw = CreateSourceSwitcher(initial_source->GetFormat());
+        auto sw = CreateSourceSwitcher(initial_source->GetFormat(), crossfade_milliseconds);
         sw->Assign(initial_source);
         return sw;
     }
@@ -14,10 +14,19 @@ namespace vse
     class ISourceSwitcher : public IWaveSource
     {
     public:
+        /// Gets the source assigned last.
         virtual std::shared_ptr<IWaveSource> Current() = 0;
+
+        /// Assigns the source. It is picked up on the next Read, without waiting for the current Read.
+        /// The previous source is released on the thread calling Assign (or the destructor), not on the reading thread.
         virtual void Assign(std::shared_ptr<IWaveSource> source) = 0;
     };
 
-    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(PcmWaveFormat format );
-    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(std::shared_ptr<IWaveSource> initial_source);
+    /// Creates a source switcher.
+    /// @param format source format
+    /// @param crossfade_milliseconds equal-power crossfade length on switching. 0 for hard cut. F32 format only if not 0.
+    ///        While crossfading, both sources are read, and a newer assignment waits until it completes.
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(PcmWaveFormat format, float crossfade_milliseconds = 0.0f);
+    std::shared_ptr<ISourceSwitcher> CreateSourceSwitcher(std::shared_ptr<IWaveSource> initial_source, float crossfade_milliseconds = 0.0f);
 }
@@ -21,11 +21,15 @@ namespace vse
     template <class TSample>
     class StereoWaveMixerImpl : public virtual IStereoWaveMixer
     {
+        using SourceSet = std::set<std::shared_ptr<IWaveSource>>;
+
         xtl::spin_lock_mutex mutex_{};
         PcmWaveFormat format_{};
-        std::vector<std::shared_ptr<IWaveSource>> incoming_{};
+        std::vector<SourceSet::node_type> incoming_{}; // nodes are allocated by RegisterSource, and linked by Read.
         std::vector<std::shared_ptr<IWaveSource>> outgoing_{};
-        std::set<std::shared_ptr<IWaveSource>> running_{};
+        std::vector<SourceSet::node_type> retired_{}; // nodes unlinked by Read, released by RegisterSource.
+        SourceSet running_{};
+        size_t prepared_frames_{}; // sources registered later are prepared for this.
         xtl::temp_memory_buffer source_buffer_{};
         xtl::temp_memory_buffer mixing_buffer_{};
 
@@ -42,8 +46,13 @@ namespace vse
         {
             if (std::unique_lock lock(mutex_, std::try_to_lock); lock.owns_lock())
             {
-                for (auto& i : outgoing_) running_.erase(i);
-                for (auto& i : incoming_) running_.emplace(std::move(i));
+                // no allocation nor release here: the vectors have the capacity reserved by RegisterSource.
+                for (auto& i : outgoing_)
+                    if (auto node = running_.extract(i))
+                        retired_.emplace_back(std::move(node));
+                for (auto& i : incoming_)
+                    if (auto result = running_.insert(std::move(i)); !result.inserted)
+                        retired_.emplace_back(std::move(result.node));
                 incoming_.clear();
                 outgoing_.clear();
             }
@@ -70,23 +79,52 @@ namespace vse
             return buffer_length;
         }
 
+        void Prepare(size_t max_frames) override
+        {
+            xtl::lock_guard lock(mutex_);
+            prepared_frames_ = std::max(prepared_frames_, max_frames);
+            source_buffer_.reserve<TSample>(prepared_frames_);
+            mixing_buffer_.reserve<TSample>(prepared_frames_);
+            for (auto& i : incoming_) i.value()->Prepare(prepared_frames_);
+            for (auto& i : running_) i->Prepare(prepared_frames_);
+        }
+
         void RegisterSource(std::shared_ptr<IWaveSource> source) override
         {
             if (source->GetFormat() != format_)
                 throw std::runtime_error("invalid format");
 
-            xtl::lock_guard lock(mutex_);
-            incoming_.emplace_back(std::move(source));
+            SourceSet node_holder{};
+            node_holder.emplace(std::move(source));
+            auto node = node_holder.extract(node_holder.begin());
+
+            std::vector<SourceSet::node_type> released{};
+            {
+                xtl::lock_guard lock(mutex_);
+                if (prepared_frames_) node.value()->Prepare(prepared_frames_);
+                incoming_.emplace_back(std::move(node));
+                released.swap(retired_);
+
+                // every source the reader may unlink is running or incoming, and each is deregistered at most once.
+                const size_t unlinkable = running_.size() + incoming_.size();
+                outgoing_.reserve(unlinkable);
+                retired_.reserve(unlinkable);
+            }
+            // released sources are destroyed here, out of the lock.
         }
 
         void DeregisterSource(std::shared_ptr<IWaveSource> source) override
         {
             xtl::lock_guard lock(mutex_);
 
-            if (auto it = std::find(incoming_.begin(), incoming_.end(), source); it != incoming_.end())
+            // may be called by a source in Read, on the rendering thread: this never allocates nor releases a source.
+            if (auto it = std::find_if(incoming_.begin(), incoming_.end(), [&](auto& node) { return node.value() == source; }); it != incoming_.end())
+            {
+                retired_.emplace_back(std::move(*it));
                 incoming_.erase(it);
+            }
 
-            if (auto it = running_.find(source); it != running_.end())
+            if (auto it = running_.find(source); it != running_.end() && std::find(outgoing_.begin(), outgoing_.end(), source) == outgoing_.end())
                 outgoing_.emplace_back(std::move(source));
         }
     };
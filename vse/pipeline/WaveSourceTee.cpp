@@ -0,0 +1,146 @@
+/// @file
+/// @brief  Vse - Wave Source Tee
+/// @author (C) 2022 ttsuki
+
+#include "WaveSourceTee.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_spin_lock_mutex.h"
+
+namespace vse
+{
+    std::shared_ptr<IWaveSourceTee> CreateWaveSourceTee(std::shared_ptr<IWaveSource> upstream, size_t buffer_frames)
+    {
+        if (!upstream) throw std::invalid_argument("upstream");
+        if (buffer_frames == 0) throw std::invalid_argument("buffer_frames");
+
+        class WaveSourceTeeImpl final : public IWaveSourceTee, public std::enable_shared_from_this<WaveSourceTeeImpl>
+        {
+            // mutex_ guards the ring and head_ for short copies. pull_mutex_ serializes reads of the upstream,
+            // which may take a whole render: waiting outputs block instead of spinning.
+            xtl::spin_lock_mutex mutex_{};
+            std::mutex pull_mutex_{};
+            std::shared_ptr<IWaveSource> upstream_{};
+            PcmWaveFormat format_{};
+            size_t block_align_{};
+            size_t capacity_{}; // frames
+            std::vector<std::byte> ring_{};
+            std::vector<std::byte> pull_buffer_{}; // the upstream is read here, out of mutex_, then committed to the ring.
+            uint64_t head_{}; // frames read from the upstream so far
+            size_t prepared_frames_{};
+
+            class OutputImpl final : public IWaveSource
+            {
+                std::shared_ptr<WaveSourceTeeImpl> tee_{};
+                uint64_t cursor_{};
+
+            public:
+                OutputImpl(std::shared_ptr<WaveSourceTeeImpl> tee, uint64_t cursor) : tee_(std::move(tee)), cursor_(cursor) {}
+                [[nodiscard]] PcmWaveFormat GetFormat() const override { return tee_->format_; }
+                [[nodiscard]] size_t Read(void* buffer, size_t buffer_length) override { return tee_->ReadFor(cursor_, buffer, buffer_length); }
+                void Prepare(size_t max_frames) override { tee_->PrepareFor(max_frames); }
+            };
+
+        public:
+            WaveSourceTeeImpl(std::shared_ptr<IWaveSource> upstream, size_t buffer_frames)
+                : upstream_(std::move(upstream))
+                , format_(upstream_->GetFormat())
+                , block_align_(static_cast<size_t>(format_.BlockAlign()))
+                , capacity_(buffer_frames)
+                , ring_(buffer_frames * block_align_)
+                , pull_buffer_(buffer_frames * block_align_)
+            {
+            }
+
+            [[nodiscard]] PcmWaveFormat GetFormat() const override { return format_; }
+
+            [[nodiscard]] std::shared_ptr<IWaveSource> CreateOutput() override
+            {
+                xtl::lock_guard lock(mutex_);
+                return std::make_shared<OutputImpl>(shared_from_this(), head_);
+            }
+
+        private:
+            void PrepareFor(size_t max_frames)
+            {
+                std::lock_guard lock(pull_mutex_);
+
+                // the upstream is read by at most capacity frames.
+                if (const size_t frames = std::min(max_frames, capacity_); frames > prepared_frames_)
+                {
+                    prepared_frames_ = frames;
+                    upstream_->Prepare(frames);
+                }
+            }
+
+            size_t ReadFor(uint64_t& cursor, void* buffer, size_t buffer_length)
+            {
+                auto* dst = static_cast<std::byte*>(buffer);
+                size_t remains = buffer_length / block_align_;
+                size_t total = 0;
+                while (remains)
+                {
+                    const size_t copied = CopyOut(cursor, dst + total * block_align_, remains);
+                    total += copied;
+                    remains -= copied;
+                    if (remains == 0) break;
+
+                    // caught up with the head: pulls, unless another output has pulled while this one waited.
+                    std::lock_guard pull_lock(pull_mutex_);
+                    if (Head() == cursor && Pull(std::min(remains, capacity_)) == 0)
+                        break; // end of upstream
+                }
+
+                return total * block_align_;
+            }
+
+            [[nodiscard]] uint64_t Head()
+            {
+                xtl::lock_guard lock(mutex_);
+                return head_;
+            }
+
+            // reads frames from the upstream and appends them to the ring. call with pull_mutex_ held.
+            size_t Pull(size_t frames)
+            {
+                const size_t read = upstream_->Read(pull_buffer_.data(), frames * block_align_) / block_align_;
+
+                xtl::lock_guard lock(mutex_);
+                const size_t position = static_cast<size_t>(head_ % capacity_);
+                const size_t first = std::min(read, capacity_ - position);
+                std::memcpy(&ring_[position * block_align_], pull_buffer_.data(), first * block_align_);
+                std::memcpy(&ring_[0], pull_buffer_.data() + first * block_align_, (read - first) * block_align_);
+                head_ += read;
+                return read;
+            }
+
+            // copies the frames at cursor, up to the head. returns the frame count copied.
+            size_t CopyOut(uint64_t& cursor, std::byte* dst, size_t frames)
+            {
+                xtl::lock_guard lock(mutex_);
+
+                // left behind: the samples have been overwritten.
+                if (cursor + capacity_ < head_)
+                    cursor = head_;
+
+                frames = std::min<size_t>(frames, static_cast<size_t>(head_ - cursor));
+                const size_t position = static_cast<size_t>(cursor % capacity_);
+                const size_t first = std::min(frames, capacity_ - position);
+                std::memcpy(dst, &ring_[position * block_align_], first * block_align_);
+                std::memcpy(dst + first * block_align_, &ring_[0], (frames - first) * block_align_);
+                cursor += frames;
+                return frames;
+            }
+        };
+
+        return std::make_shared<WaveSourceTeeImpl>(std::move(upstream), buffer_frames);
+    }
+}
@@ -0,0 +1,34 @@
+/// @file
+/// @brief  Vse - Wave Source Tee
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "../base/Interface.h"
+#include "../base/WaveFormat.h"
+#include "../base/IWaveSource.h"
+
+namespace vse
+{
+    /// Fan-out node: reads the upstream once and serves the same samples to many outputs.
+    class IWaveSourceTee : public virtual Interface
+    {
+    public:
+        [[nodiscard]] virtual PcmWaveFormat GetFormat() const = 0;
+
+        /// Creates a new output. It starts at the latest position of the upstream.
+        [[nodiscard]] virtual std::shared_ptr<IWaveSource> CreateOutput() = 0;
+    };
+
+    /// Creates a tee.
+    /// Only the last buffer_frames frames read from the upstream are kept in a ring buffer.
+    /// A faster output overwrites frames a slower one hasn't read yet: an output that falls behind by more than buffer_frames
+    /// (e.g. a slow tap, or an unselected branch of a switch) skips to the latest position on its next read.
+    /// The upstream is read by one output at a time. The other outputs keep reading the buffered frames meanwhile.
+    /// @param upstream source
+    /// @param buffer_frames ring buffer length in frames.
+    [[nodiscard]] std::shared_ptr<IWaveSourceTee> CreateWaveSourceTee(std::shared_ptr<IWaveSource> upstream, size_t buffer_frames = 16384);
+}
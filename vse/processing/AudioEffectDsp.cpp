@@ -0,0 +1,577 @@
+/// @file
+/// @brief  Vse - Audio Effect DSP
+/// @author (C) 2022 ttsuki
+
+#include "AudioEffectDsp.h"
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./RbjAudioEqProcessor.h"
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        constexpr float NoLimit = std::numeric_limits<float>::max();
+
+        float DecibelToGain(float db) { return std::pow(10.0f, db / 20.0f); }
+
+        /// LFO value in [-1, +1] at phase [0, 1)
+        float Lfo(LfoWaveform waveform, double phase)
+        {
+            switch (waveform)
+            {
+            case LfoWaveform::Sine: return static_cast<float>(std::sin(phase * 6.283185307179586));
+            case LfoWaveform::Square: return phase < 0.5 ? 1.0f : -1.0f;
+            case LfoWaveform::Triangle:
+            default: return static_cast<float>(phase < 0.5 ? phase * 4.0 - 1.0 : 3.0 - phase * 4.0);
+            }
+        }
+
+        double Wrap(double phase) { return phase - std::floor(phase); }
+
+        /// Single channel ring buffer.
+        class DelayLine
+        {
+            std::vector<F32> buffer_{};
+            size_t mask_{};
+            size_t position_{}; // next write
+
+        public:
+            explicit DelayLine(size_t max_delay)
+            {
+                size_t size = 1;
+                while (size < max_delay + 2) size <<= 1;
+                buffer_.resize(size);
+                mask_ = size - 1;
+            }
+
+            [[nodiscard]] size_t MaxDelay() const { return mask_ - 1; }
+
+            void Clear()
+            {
+                std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+                position_ = 0;
+            }
+
+            /// Reads `count` samples from `delay` samples ago (1: the last one). count <= delay.
+            void Read(F32* dst, size_t delay, size_t count) const
+            {
+                const size_t start = (position_ - delay) & mask_;
+                const size_t n = std::min(count, buffer_.size() - start);
+                std::memcpy(dst, &buffer_[start], n * sizeof(F32));
+                std::memcpy(dst + n, &buffer_[0], (count - n) * sizeof(F32));
+            }
+
+            /// Pushes `count` samples.
+            void Write(const F32* src, size_t count)
+            {
+                const size_t n = std::min(count, buffer_.size() - position_);
+                std::memcpy(&buffer_[position_], src, n * sizeof(F32));
+                std::memcpy(&buffer_[0], src + n, (count - n) * sizeof(F32));
+                position_ = (position_ + count) & mask_;
+            }
+        };
+
+        template <class TParameters>
+        class EffectBase : public IParametricWaveProcessor<TParameters>
+        {
+        protected:
+            const PcmWaveFormat format_;
+            const size_t channels_;
+            const float sampling_frequency_;
+
+        private:
+            std::atomic<TParameters> params_;
+            std::atomic_flag continuity_{};
+
+        public:
+            EffectBase(PcmWaveFormat format, TParameters params)
+                : format_(format)
+                , channels_(static_cast<size_t>(format.ChannelCount()))
+                , sampling_frequency_(static_cast<float>(format.SamplingFrequency()))
+                , params_(params)
+            {
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                CheckContinuity();
+
+                const int block_align = format_.BlockAlign();
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+                if (const size_t frames = bytes / block_align)
+                    ProcessFrames(static_cast<F32*>(destination_buffer), frames, GetParameters());
+
+                return bytes;
+            }
+
+            void Discontinuity() override { continuity_.clear(); }
+
+            [[nodiscard]] TParameters GetParameters() const override { return params_.load(std::memory_order_acquire); }
+            void SetParameters(TParameters parameters) override { params_.store(parameters, std::memory_order_release); }
+
+        protected:
+            virtual void Reset() = 0;
+            virtual void ProcessFrames(F32* buffer, size_t frames, const TParameters& params) = 0;
+
+            /// Resets the state if Discontinuity was notified since the last block.
+            void CheckContinuity()
+            {
+                if (!continuity_.test_and_set()) Reset();
+            }
+        };
+
+        /// Effect with independent channels, which runs on planar blocks too.
+        template <class TParameters>
+        class PlanarEffectBase : public EffectBase<TParameters>, public IPlanarWaveProcessor
+        {
+        public:
+            using EffectBase<TParameters>::EffectBase;
+
+            void ProcessPlanar(const PlanarBlock& block) override
+            {
+                this->CheckContinuity();
+                if (block.frames)
+                    ProcessPlanarFrames(block, this->GetParameters());
+            }
+
+        protected:
+            virtual void ProcessPlanarFrames(const PlanarBlock& block, const TParameters& params) = 0;
+        };
+
+        class GargleImpl final : public EffectBase<GargleEffectParameters>
+        {
+            double phase_{};
+            xtl::temp_memory_buffer gains_buffer_{};
+
+        public:
+            using EffectBase::EffectBase;
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                gains_buffer_.reserve<float>(max_output_frames);
+                return max_output_frames;
+            }
+
+        protected:
+            void Reset() override { phase_ = 0; }
+
+            void ProcessFrames(F32* buffer, size_t frames, const GargleEffectParameters& params) override
+            {
+                // amplitude modulation by unipolar LFO
+                const double step = std::clamp(params.RateHz, 1.0f, 1000.0f) / sampling_frequency_;
+                float* gains = gains_buffer_.get<float>(frames);
+                for (size_t i = 0; i < frames; i++)
+                {
+                    gains[i] = 0.5f + 0.5f * Lfo(params.Waveform, phase_);
+                    phase_ = Wrap(phase_ + step);
+                }
+
+                processing::ApplyFrameGain(buffer, buffer, gains, channels_, frames, NoLimit);
+            }
+        };
+
+        /// Chorus and Flanger: feedback delay line with the delay time modulated by LFO.
+        template <class TParameters>
+        class ModulatedDelayImpl final : public PlanarEffectBase<TParameters>
+        {
+            using PlanarEffectBase<TParameters>::channels_;
+            using PlanarEffectBase<TParameters>::sampling_frequency_;
+
+            // frames whose delay times are computed at once.
+            static constexpr size_t SpanFrames = 256;
+
+            const float max_delay_ms_;
+            std::vector<DelayLine> lines_{};
+            double phase_{};
+
+            std::vector<float> delays_{};  // [even/odd channels][SpanFrames]
+            std::vector<F32> history_{};   // a delay line read out linearly
+            std::vector<F32> taps_{};      // [SpanFrames]
+            std::vector<F32> feed_{};      // [SpanFrames]
+
+        public:
+            ModulatedDelayImpl(PcmWaveFormat format, TParameters params, float max_delay_ms)
+                : PlanarEffectBase<TParameters>(format, params)
+                , max_delay_ms_(max_delay_ms)
+                , lines_(channels_, DelayLine(static_cast<size_t>(std::ceil(max_delay_ms * 2.0f * sampling_frequency_ / 1000.0f)) + 2))
+                , delays_(2 * SpanFrames)
+                , history_(lines_[0].MaxDelay() + 2)
+                , taps_(SpanFrames)
+                , feed_(SpanFrames)
+            {
+            }
+
+        protected:
+            void Reset() override
+            {
+                for (auto& l : lines_) l.Clear();
+                phase_ = 0;
+            }
+
+            void ProcessFrames(F32* buffer, size_t frames, const TParameters& params) override
+            {
+                ProcessChannels<false>(buffer, channels_, frames, params);
+            }
+
+            void ProcessPlanarFrames(const PlanarBlock& block, const TParameters& params) override
+            {
+                ProcessChannels<true>(block.data, block.stride, block.frames, params);
+            }
+
+        private:
+            /// sample i of channel c is at buffer[c * stride + i] if Planar, or at buffer[i * stride + c].
+            template <bool Planar>
+            void ProcessChannels(F32* buffer, size_t stride, size_t frames, const TParameters& params)
+            {
+                const float wet = std::clamp(params.WetDryMix, 0.0f, 100.0f) / 100.0f;
+                const float dry = 1.0f - wet;
+                const float feedback = std::clamp(params.Feedback, -99.0f, 99.0f) / 100.0f;
+                const float depth = std::clamp(params.Depth, 0.0f, 100.0f) / 100.0f;
+                const float base = std::clamp(params.Delay, 0.0f, max_delay_ms_) * sampling_frequency_ / 1000.0f;
+                const float max_delay = static_cast<float>(lines_[0].MaxDelay() - 1);
+                const double step = std::clamp(params.Frequency, 0.0f, 10.0f) / sampling_frequency_;
+                const double odd_phase = std::clamp(params.Phase, -180.0f, 180.0f) / 360.0;
+                const size_t curves = std::min<size_t>(channels_, 2);
+
+                for (size_t offset = 0; offset < frames;)
+                {
+                    const size_t span = std::min(SpanFrames, frames - offset);
+
+                    // the LFO runs once for all channels: a delay curve for even channels, and one for odd channels.
+                    for (size_t i = 0; i < span; i++)
+                    {
+                        for (size_t k = 0; k < curves; k++)
+                        {
+                            const float lfo = Lfo(params.Waveform, k ? Wrap(phase_ + odd_phase) : phase_);
+                            delays_[k * SpanFrames + i] = std::clamp(base * (1.0f + depth * lfo), 1.0f, max_delay);
+                        }
+                        phase_ = Wrap(phase_ + step);
+                    }
+
+                    for (size_t s = 0; s < span;)
+                    {
+                        // a sub-span no longer than the shortest delay in it only reads samples pushed before it,
+                        // so that its taps don't depend on each other.
+                        size_t n = span - s;
+                        float shortest[2]{};
+                        float longest[2]{};
+                        for (size_t k = 0; k < curves; k++)
+                        {
+                            const auto [lo, hi] = std::minmax_element(&delays_[k * SpanFrames + s], &delays_[k * SpanFrames + s] + n);
+                            shortest[k] = *lo;
+                            longest[k] = *hi;
+                            n = std::min(n, static_cast<size_t>(*lo));
+                        }
+
+                        for (size_t c = 0; c < channels_; c++)
+                        {
+                            // reads out samples from (longest + 1) to (shortest - n + 1) ago.
+                            const size_t k = c & 1;
+                            const size_t oldest = static_cast<size_t>(longest[k]) + 1;
+                            const size_t newest = static_cast<size_t>(shortest[k]) + 1 - n;
+                            lines_[c].Read(history_.data(), oldest, oldest - newest + 1);
+                            processing::InterpolateDelayTaps(taps_.data(), history_.data() + oldest, &delays_[k * SpanFrames + s], n);
+
+                            const F32* __restrict y = taps_.data();
+                            F32* __restrict f = feed_.data();
+                            F32* x = Planar ? buffer + c * stride + offset + s : buffer + (offset + s) * stride + c;
+                            const size_t x_step = Planar ? 1 : stride;
+                            for (size_t i = 0; i < n; i++)
+                            {
+                                F32& v = x[i * x_step];
+                                f[i] = v + y[i] * feedback;
+                                v = v * dry + y[i] * wet;
+                            }
+
+                            lines_[c].Write(feed_.data(), n);
+                        }
+
+                        s += n;
+                    }
+
+                    offset += span;
+                }
+            }
+        };
+
+        class EchoImpl final : public PlanarEffectBase<EchoEffectParameters>
+        {
+            // frames processed in a span. delay lines are read and written for a span at once (delays are longer).
+            static constexpr size_t SpanFrames = 256;
+            static constexpr float MaxDelayMs = 2000.0f;
+
+            std::vector<DelayLine> lines_{};
+            std::vector<F32> delayed_{}; // [channel][SpanFrames]
+            std::vector<F32> feed_{};    // [channel][SpanFrames]
+
+        public:
+            EchoImpl(PcmWaveFormat format, EchoEffectParameters params)
+                : PlanarEffectBase(format, params)
+                , lines_(channels_, DelayLine(static_cast<size_t>(std::ceil(MaxDelayMs * sampling_frequency_ / 1000.0f))))
+                , delayed_(channels_ * SpanFrames)
+                , feed_(channels_ * SpanFrames)
+            {
+            }
+
+        protected:
+            void Reset() override
+            {
+                for (auto& l : lines_) l.Clear();
+            }
+
+            void ProcessFrames(F32* buffer, size_t frames, const EchoEffectParameters& params) override
+            {
+                ProcessChannels<false>(buffer, channels_, frames, params);
+            }
+
+            void ProcessPlanarFrames(const PlanarBlock& block, const EchoEffectParameters& params) override
+            {
+                ProcessChannels<true>(block.data, block.stride, block.frames, params);
+            }
+
+        private:
+            /// sample i of channel c is at buffer[c * stride + i] if Planar, or at buffer[i * stride + c].
+            template <bool Planar>
+            void ProcessChannels(F32* buffer, size_t stride, size_t frames, const EchoEffectParameters& params)
+            {
+                const float wet = std::clamp(params.WetDryMix, 0.0f, 100.0f) / 100.0f;
+                const float dry = 1.0f - wet;
+                const float feedback = std::clamp(params.Feedback, 0.0f, 100.0f) / 100.0f;
+                const auto delay_frames = [&](float ms) { return std::max<size_t>(static_cast<size_t>(std::clamp(ms, 1.0f, MaxDelayMs) * sampling_frequency_ / 1000.0f), 1); };
+                const size_t delay[2] = {delay_frames(params.LeftDelay), delay_frames(params.RightDelay)};
+                const bool pan = params.PanDelay && channels_ >= 2;
+                const size_t span = std::min({SpanFrames, delay[0], delay[1]});
+
+                for (size_t offset = 0; offset < frames; offset += span)
+                {
+                    const size_t n = std::min(span, frames - offset);
+
+                    for (size_t c = 0; c < channels_; c++)
+                        lines_[c].Read(&delayed_[c * SpanFrames], delay[c & 1], n);
+
+                    for (size_t c = 0; c < channels_; c++)
+                    {
+                        // ping-pong: feeds back the echo of the pair channel.
+                        const size_t source = pan && (c ^ 1) < channels_ ? c ^ 1 : c;
+                        const F32* __restrict d = &delayed_[c * SpanFrames];
+                        const F32* __restrict s = &delayed_[source * SpanFrames];
+                        F32* __restrict f = &feed_[c * SpanFrames];
+                        F32* x = Planar ? buffer + c * stride + offset : buffer + offset * stride + c;
+                        const size_t x_step = Planar ? 1 : stride;
+                        for (size_t i = 0; i < n; i++)
+                        {
+                            F32& v = x[i * x_step];
+                            f[i] = v + s[i] * feedback;
+                            v = v * dry + d[i] * wet;
+                        }
+                    }
+
+                    for (size_t c = 0; c < channels_; c++)
+                        lines_[c].Write(&feed_[c * SpanFrames], n);
+                }
+            }
+        };
+
+        class DistortionImpl final : public EffectBase<DistortionEffectParameters>
+        {
+            processing::BiquadState pre_{};
+            processing::BiquadState post_{};
+
+        public:
+            using EffectBase::EffectBase;
+
+        protected:
+            void Reset() override
+            {
+                pre_ = {};
+                post_ = {};
+            }
+
+            void ProcessFrames(F32* buffer, size_t frames, const DistortionEffectParameters& params) override
+            {
+                using namespace rbj_audio_eq;
+                const float nyquist = sampling_frequency_ * 0.49f;
+
+                const float lpf_w0 = w0(std::clamp(params.PreLowpassCutoff, 100.0f, nyquist), sampling_frequency_);
+                const Coefficients lpf = LowPassFilterCoefficients(lpf_w0, alphaQ(0.70710678f, lpf_w0));
+                const float center = std::clamp(params.PostEQCenterFrequency, 100.0f, nyquist);
+                const float bpf_w0 = w0(center, sampling_frequency_);
+                const Coefficients bpf = BandPassFilterCoefficients_Constant0dBPeakGain(bpf_w0, alphaQ(center / std::max(params.PostEQBandwidth, 1.0f), bpf_w0));
+
+                const float lpf_c[5] = {lpf.b0a0, lpf.b1a0, lpf.b2a0, lpf.a1a0, lpf.a2a0};
+                const float bpf_c[5] = {bpf.b0a0, bpf.b1a0, bpf.b2a0, bpf.a1a0, bpf.a2a0};
+                const float drive = DecibelToGain(std::clamp(params.Edge, 0.0f, 100.0f) * 0.6f); // up to +60dB into the clipper
+                const float gain = DecibelToGain(std::clamp(params.Gain, -60.0f, 0.0f));
+
+                // pre low-pass -> clip -> post band-pass -> gain
+                const size_t count = frames * channels_;
+                processing::ProcessBiquad(buffer, buffer, channels_, frames, lpf_c, pre_);
+                processing::ProcessHardLimit(buffer, buffer, count, drive, 1.0f);
+                processing::ProcessBiquad(buffer, buffer, channels_, frames, bpf_c, post_);
+                processing::ProcessHardLimit(buffer, buffer, count, gain, NoLimit);
+            }
+        };
+
+        /// Feedback delay network of 8 lines with a Householder matrix and frequency dependent decay.
+        class ReverbImpl final : public EffectBase<ReverbEffectParameters>
+        {
+            static constexpr size_t Lines = 8;
+            static constexpr size_t SpanFrames = 256;
+
+            size_t length_[Lines]{};
+            std::vector<DelayLine> lines_{};
+            size_t span_{};
+
+            float damp_[Lines]{};     // one-pole low-pass state in the loop
+            std::vector<F32> taps_{}; // [line][SpanFrames]
+            std::vector<F32> feed_{}; // [line][SpanFrames]
+
+        public:
+            ReverbImpl(PcmWaveFormat format, ReverbEffectParameters params)
+                : EffectBase(format, params)
+                , taps_(Lines * SpanFrames)
+                , feed_(Lines * SpanFrames)
+            {
+                // mutually prime lengths at 44.1kHz (about 25..37ms)
+                constexpr size_t lengths[Lines] = {1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617};
+                span_ = SpanFrames;
+                for (size_t l = 0; l < Lines; l++)
+                {
+                    length_[l] = std::max<size_t>(static_cast<size_t>(lengths[l] * static_cast<double>(sampling_frequency_) / 44100.0), 1);
+                    lines_.emplace_back(length_[l]);
+                    span_ = std::min(span_, length_[l]);
+                }
+            }
+
+        protected:
+            void Reset() override
+            {
+                for (auto& l : lines_) l.Clear();
+                for (auto& d : damp_) d = 0.0f;
+            }
+
+            void ProcessFrames(F32* buffer, size_t frames, const ReverbEffectParameters& params) override
+            {
+                const float in_gain = DecibelToGain(std::clamp(params.InGain, -96.0f, 0.0f)) / static_cast<float>(channels_);
+                const float mix = DecibelToGain(std::clamp(params.ReverbMix, -96.0f, 0.0f)) * 0.5f;
+                const double rt_frames = std::clamp(params.ReverbTime, 1.0f, 3000.0f) * static_cast<double>(sampling_frequency_) / 1000.0;
+                const double hf_ratio = std::clamp(params.HighFreqRTRatio, 0.001f, 0.999f);
+
+                // loop filter of each line: g * (1 - a) / (1 - a z^-1), decays 60dB in rt at dc and in rt * hf_ratio at nyquist.
+                float gain[Lines], pole[Lines];
+                for (size_t l = 0; l < Lines; l++)
+                {
+                    const double g = std::pow(10.0, -3.0 * static_cast<double>(length_[l]) / rt_frames);
+                    const double g_hf = std::pow(10.0, -3.0 * static_cast<double>(length_[l]) / (rt_frames * hf_ratio));
+                    const double k = g_hf / g;
+                    const double a = (1.0 - k) / (1.0 + k);
+                    gain[l] = static_cast<float>(g * (1.0 - a));
+                    pole[l] = static_cast<float>(a);
+                }
+
+                for (size_t offset = 0; offset < frames; offset += span_)
+                {
+                    const size_t n = std::min(span_, frames - offset);
+                    F32* x = buffer + offset * channels_;
+
+                    for (size_t l = 0; l < Lines; l++)
+                        lines_[l].Read(&taps_[l * SpanFrames], length_[l], n);
+
+                    for (size_t i = 0; i < n; i++)
+                    {
+                        float input = 0.0f;
+                        for (size_t c = 0; c < channels_; c++) input += x[i * channels_ + c];
+                        input *= in_gain;
+
+                        float v[Lines];
+                        float sum = 0.0f;
+                        for (size_t l = 0; l < Lines; l++)
+                        {
+                            v[l] = damp_[l] = gain[l] * taps_[l * SpanFrames + i] + pole[l] * damp_[l];
+                            sum += v[l];
+                        }
+
+                        // householder reflection: v - 2/N * sum(v)
+                        const float reflect = sum * (2.0f / Lines);
+                        for (size_t l = 0; l < Lines; l++)
+                            feed_[l * SpanFrames + i] = v[l] - reflect + input;
+
+                        const float out[2] = {
+                            (v[0] - v[2] + v[4] - v[6]) * mix,
+                            (v[1] - v[3] + v[5] - v[7]) * mix,
+                        };
+                        for (size_t c = 0; c < channels_; c++)
+                            x[i * channels_ + c] += out[c & 1];
+                    }
+
+                    for (size_t l = 0; l < Lines; l++)
+                        lines_[l].Write(&feed_[l * SpanFrames], n);
+                }
+            }
+        };
+
+        void ValidateFormat(PcmWaveFormat format, size_t max_channels)
+        {
+            if (format.SampleType() != SampleType::F32 || format.ChannelCount() <= 0 || static_cast<size_t>(format.ChannelCount()) > max_channels)
+                throw std::invalid_argument("not supported.");
+        }
+
+        constexpr size_t AnyChannels = std::numeric_limits<size_t>::max();
+    }
+
+    std::shared_ptr<IGargleEffect> CreateGargleEffect(PcmWaveFormat format, GargleEffectParameters parameters)
+    {
+        ValidateFormat(format, AnyChannels);
+        return std::make_shared<GargleImpl>(format, parameters);
+    }
+
+    std::shared_ptr<IChorusEffect> CreateChorusEffect(PcmWaveFormat format, ChorusEffectParameters parameters)
+    {
+        ValidateFormat(format, AnyChannels);
+        return std::make_shared<ModulatedDelayImpl<ChorusEffectParameters>>(format, parameters, 20.0f);
+    }
+
+    std::shared_ptr<IFlangerEffect> CreateFlangerEffect(PcmWaveFormat format, FlangerEffectParameters parameters)
+    {
+        ValidateFormat(format, AnyChannels);
+        return std::make_shared<ModulatedDelayImpl<FlangerEffectParameters>>(format, parameters, 4.0f);
+    }
+
+    std::shared_ptr<IEchoEffect> CreateEchoEffect(PcmWaveFormat format, EchoEffectParameters parameters)
+    {
+        ValidateFormat(format, AnyChannels);
+        return std::make_shared<EchoImpl>(format, parameters);
+    }
+
+    std::shared_ptr<IDistortionEffect> CreateDistortionEffect(PcmWaveFormat format, DistortionEffectParameters parameters)
+    {
+        ValidateFormat(format, processing::BiquadState::MaxChannels);
+        return std::make_shared<DistortionImpl>(format, parameters);
+    }
+
+    std::shared_ptr<IReverbEffect> CreateReverbEffect(PcmWaveFormat format, ReverbEffectParameters parameters)
+    {
+        ValidateFormat(format, AnyChannels);
+        return std::make_shared<ReverbImpl>(format, parameters);
+    }
+}
@@ -0,0 +1,93 @@
+/// @file
+/// @brief  Vse - Audio Effect DSP
+/// @author (C) 2022 ttsuki
+///
+/// Native implementations of the effects DirectSoundAudioEffectDsp provides through DMO.
+/// Parameters follow the ones of DSFX structures.
+
+#pragma once
+
+#include <memory>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    enum struct LfoWaveform
+    {
+        Triangle = 0,
+        Sine = 1,
+        Square = 2,
+    };
+
+    struct GargleEffectParameters
+    {
+        float RateHz = 20.0f; ///< modulation rate (1..1000)
+        LfoWaveform Waveform = LfoWaveform::Triangle;
+    };
+
+    struct ChorusEffectParameters
+    {
+        float WetDryMix = 50.0f; ///< wet ratio in percent (0..100)
+        float Depth = 10.0f;     ///< delay modulation in percent of Delay (0..100)
+        float Feedback = 25.0f;  ///< percent (-99..99)
+        float Frequency = 1.1f;  ///< LFO frequency in Hz (0..10)
+        LfoWaveform Waveform = LfoWaveform::Sine;
+        float Delay = 16.0f; ///< milliseconds (0..20)
+        float Phase = 90.0f; ///< LFO phase difference of odd channels in degrees (-180..180)
+    };
+
+    struct FlangerEffectParameters
+    {
+        float WetDryMix = 50.0f; ///< wet ratio in percent (0..100)
+        float Depth = 100.0f;    ///< delay modulation in percent of Delay (0..100)
+        float Feedback = -50.0f; ///< percent (-99..99)
+        float Frequency = 0.25f; ///< LFO frequency in Hz (0..10)
+        LfoWaveform Waveform = LfoWaveform::Sine;
+        float Delay = 2.0f; ///< milliseconds (0..4)
+        float Phase = 0.0f; ///< LFO phase difference of odd channels in degrees (-180..180)
+    };
+
+    struct EchoEffectParameters
+    {
+        float WetDryMix = 50.0f;   ///< wet ratio in percent (0..100)
+        float Feedback = 50.0f;    ///< percent (0..100)
+        float LeftDelay = 500.0f;  ///< milliseconds (1..2000), even channels
+        float RightDelay = 500.0f; ///< milliseconds (1..2000), odd channels
+        bool PanDelay = false;     ///< swaps left and right echoes on each repeat
+    };
+
+    struct DistortionEffectParameters
+    {
+        float Gain = -18.0f;                   ///< output gain in dB (-60..0)
+        float Edge = 15.0f;                    ///< intensity in percent (0..100)
+        float PostEQCenterFrequency = 2400.0f; ///< Hz
+        float PostEQBandwidth = 2400.0f;       ///< Hz
+        float PreLowpassCutoff = 8000.0f;      ///< Hz
+    };
+
+    struct ReverbEffectParameters
+    {
+        float InGain = 0.0f;            ///< gain into the reverb in dB (-96..0)
+        float ReverbMix = 0.0f;         ///< gain of the reverb in dB (-96..0)
+        float ReverbTime = 1000.0f;     ///< RT60 in milliseconds (1..3000)
+        float HighFreqRTRatio = 0.001f; ///< ratio of the high frequency reverb time to ReverbTime (0.001..0.999)
+    };
+
+    using IGargleEffect = IParametricWaveProcessor<GargleEffectParameters>;
+    using IChorusEffect = IParametricWaveProcessor<ChorusEffectParameters>;
+    using IFlangerEffect = IParametricWaveProcessor<FlangerEffectParameters>;
+    using IEchoEffect = IParametricWaveProcessor<EchoEffectParameters>;
+    using IDistortionEffect = IParametricWaveProcessor<DistortionEffectParameters>;
+    using IReverbEffect = IParametricWaveProcessor<ReverbEffectParameters>;
+
+    /// Creates effects. F32 only (distortion: up to 8 channels).
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<IGargleEffect> CreateGargleEffect(PcmWaveFormat format, GargleEffectParameters parameters = GargleEffectParameters{});
+    std::shared_ptr<IChorusEffect> CreateChorusEffect(PcmWaveFormat format, ChorusEffectParameters parameters = ChorusEffectParameters{});
+    std::shared_ptr<IFlangerEffect> CreateFlangerEffect(PcmWaveFormat format, FlangerEffectParameters parameters = FlangerEffectParameters{});
+    std::shared_ptr<IEchoEffect> CreateEchoEffect(PcmWaveFormat format, EchoEffectParameters parameters = EchoEffectParameters{});
+    std::shared_ptr<IDistortionEffect> CreateDistortionEffect(PcmWaveFormat format, DistortionEffectParameters parameters = DistortionEffectParameters{});
+    std::shared_ptr<IReverbEffect> CreateReverbEffect(PcmWaveFormat format, ReverbEffectParameters parameters = ReverbEffectParameters{});
+}
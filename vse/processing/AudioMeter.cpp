@@ -0,0 +1,297 @@
+/// @file
+/// @brief  Vse - Audio Meter
+/// @author (C) 2022 ttsuki
+
+#include "AudioMeter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        constexpr size_t MaxChannels = AudioMeterReading::MaxChannels;
+        constexpr size_t MomentaryBlocks = 4;  // 400 ms
+        constexpr size_t ShortTermBlocks = 30; // 3 s
+
+        class AudioMeterImpl final : public IAudioMeter
+        {
+            PcmWaveFormat format_;
+            std::atomic_flag continuity_{};
+
+            const size_t channels_;
+            const size_t block_frames_; // 100 ms
+            const size_t rms_blocks_;
+            const double peak_release_frames_;
+
+            float k_weighting_[2][5]{};
+            float channel_weights_[MaxChannels]{};
+
+            // render thread
+            processing::BiquadState k_states_[2]{};
+            size_t block_position_{};
+            double block_sums_[MaxChannels]{};   // sum of squares in the current block
+            double block_k_sums_[MaxChannels]{}; // K-weighted
+            double history_[ShortTermBlocks][MaxChannels]{};
+            double history_k_[ShortTermBlocks][MaxChannels]{};
+            size_t history_position_{};
+            AudioMeterReading reading_{};
+            xtl::temp_memory_buffer weighted_buffer_{};
+
+            // seqlock: readers poll without locking; odd version means writing. the render thread is the only writer.
+            static constexpr size_t PublishedValues = MaxChannels * 2 + 2;
+            std::atomic<uint32_t> version_{};
+            std::atomic<float> published_[PublishedValues]{};
+            std::atomic<uint64_t> published_frames_{};
+
+        public:
+            AudioMeterImpl(PcmWaveFormat format, size_t rms_blocks, double peak_release_frames)
+                : format_(format)
+                , channels_(static_cast<size_t>(format.ChannelCount()))
+                , block_frames_(static_cast<size_t>(format.SamplingFrequency()) / 10)
+                , rms_blocks_(rms_blocks)
+                , peak_release_frames_(peak_release_frames)
+            {
+                BuildKWeighting(static_cast<double>(format.SamplingFrequency()));
+                BuildChannelWeights(format.ChannelMask());
+                Reset();
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                if (!continuity_.test_and_set()) Reset();
+
+                const int block_align = format_.BlockAlign();
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+                const size_t frames = bytes / block_align;
+                if (frames == 0) return bytes;
+
+                const size_t c = channels_;
+                const F32* src = static_cast<const F32*>(destination_buffer);
+                F32* weighted = weighted_buffer_.get<F32>(frames * c);
+                processing::ProcessBiquadCascade(weighted, src, c, frames, k_weighting_, k_states_, 2);
+
+                const float decay = static_cast<float>(std::pow(0.1, static_cast<double>(frames) / peak_release_frames_));
+                for (size_t ch = 0; ch < c; ch++)
+                    reading_.Peak[ch] *= decay;
+
+                for (size_t done = 0; done < frames;)
+                {
+                    const size_t n = std::min(frames - done, block_frames_ - block_position_);
+                    float peaks[MaxChannels], sums[MaxChannels], k_peaks[MaxChannels], k_sums[MaxChannels];
+                    processing::ComputeChannelStatistics(peaks, sums, src + done * c, c, n);
+                    processing::ComputeChannelStatistics(k_peaks, k_sums, weighted + done * c, c, n);
+                    for (size_t ch = 0; ch < c; ch++)
+                    {
+                        reading_.Peak[ch] = std::max(reading_.Peak[ch], peaks[ch]);
+                        block_sums_[ch] += sums[ch];
+                        block_k_sums_[ch] += k_sums[ch];
+                    }
+
+                    done += n;
+                    block_position_ += n;
+                    if (block_position_ == block_frames_)
+                    {
+                        CompleteBlock();
+                        block_position_ = 0;
+                    }
+                }
+
+                reading_.Frames += frames;
+                Publish();
+                return bytes;
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                weighted_buffer_.reserve<F32>(max_output_frames * channels_);
+                return max_output_frames;
+            }
+
+            [[nodiscard]] AudioMeterReading GetReading() const override
+            {
+                for (;;)
+                {
+                    const uint32_t version = version_.load(std::memory_order_acquire);
+                    if (version & 1) continue;
+
+                    AudioMeterReading r{};
+                    r.Channels = static_cast<uint32_t>(channels_);
+                    for (size_t ch = 0; ch < MaxChannels; ch++)
+                    {
+                        r.Peak[ch] = published_[ch].load(std::memory_order_relaxed);
+                        r.Rms[ch] = published_[MaxChannels + ch].load(std::memory_order_relaxed);
+                    }
+                    r.MomentaryLoudness = published_[MaxChannels * 2 + 0].load(std::memory_order_relaxed);
+                    r.ShortTermLoudness = published_[MaxChannels * 2 + 1].load(std::memory_order_relaxed);
+                    r.Frames = published_frames_.load(std::memory_order_relaxed);
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (version_.load(std::memory_order_relaxed) == version)
+                        return r;
+                }
+            }
+
+        private:
+            void BuildKWeighting(double fs)
+            {
+                // ITU-R BS.1770 pre-filter (high shelf) and RLB weighting (high pass), derived for the sampling frequency.
+                const double pi = 3.14159265358979323846;
+                {
+                    const double f0 = 1681.974450955533, gain_db = 3.999843853973347, q = 0.7071752369554196;
+                    const double k = std::tan(pi * f0 / fs);
+                    const double vh = std::pow(10.0, gain_db / 20.0);
+                    const double vb = std::pow(vh, 0.4996667741545416);
+                    const double a0 = 1.0 + k / q + k * k;
+                    k_weighting_[0][0] = static_cast<float>((vh + vb * k / q + k * k) / a0);
+                    k_weighting_[0][1] = static_cast<float>(2.0 * (k * k - vh) / a0);
+                    k_weighting_[0][2] = static_cast<float>((vh - vb * k / q + k * k) / a0);
+                    k_weighting_[0][3] = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+                    k_weighting_[0][4] = static_cast<float>((1.0 - k / q + k * k) / a0);
+                }
+                {
+                    const double f0 = 38.13547087602444, q = 0.5003270373238773;
+                    const double k = std::tan(pi * f0 / fs);
+                    const double a0 = 1.0 + k / q + k * k;
+                    k_weighting_[1][0] = 1.0f;
+                    k_weighting_[1][1] = -2.0f;
+                    k_weighting_[1][2] = 1.0f;
+                    k_weighting_[1][3] = static_cast<float>(2.0 * (k * k - 1.0) / a0);
+                    k_weighting_[1][4] = static_cast<float>((1.0 - k / q + k * k) / a0);
+                }
+            }
+
+            void BuildChannelWeights(SpeakerBit mask)
+            {
+                // channels are interleaved in the order of the mask bits.
+                size_t ch = 0;
+                for (uint32_t bit = 1; bit != 0 && ch < channels_; bit <<= 1)
+                {
+                    const SpeakerBit speaker = static_cast<SpeakerBit>(bit);
+                    if ((mask & speaker) == SpeakerBit::None) continue;
+
+                    if (speaker == SpeakerBit::LowFrequency)
+                        channel_weights_[ch] = 0.0f;
+                    else if ((speaker & (SpeakerBit::BackPair | SpeakerBit::SidePair)) != SpeakerBit::None)
+                        channel_weights_[ch] = 1.41f;
+                    else
+                        channel_weights_[ch] = 1.0f;
+                    ch++;
+                }
+
+                for (; ch < channels_; ch++)
+                    channel_weights_[ch] = 1.0f;
+            }
+
+            static float ToLufs(double mean_square) noexcept
+            {
+                return mean_square > 0.0
+                           ? static_cast<float>(-0.691 + 10.0 * std::log10(mean_square))
+                           : -std::numeric_limits<float>::infinity();
+            }
+
+            double SumHistory(const double (&history)[ShortTermBlocks][MaxChannels], size_t ch, size_t blocks) const noexcept
+            {
+                double sum = 0.0;
+                for (size_t i = 0; i < blocks; i++)
+                    sum += history[(history_position_ + ShortTermBlocks - 1 - i) % ShortTermBlocks][ch];
+                return sum;
+            }
+
+            void CompleteBlock()
+            {
+                for (size_t ch = 0; ch < channels_; ch++)
+                {
+                    history_[history_position_][ch] = block_sums_[ch];
+                    history_k_[history_position_][ch] = block_k_sums_[ch];
+                    block_sums_[ch] = 0.0;
+                    block_k_sums_[ch] = 0.0;
+                }
+                history_position_ = (history_position_ + 1) % ShortTermBlocks;
+
+                const double frames = static_cast<double>(block_frames_);
+                double momentary = 0.0, short_term = 0.0;
+                for (size_t ch = 0; ch < channels_; ch++)
+                {
+                    reading_.Rms[ch] = static_cast<float>(std::sqrt(SumHistory(history_, ch, rms_blocks_) / (frames * static_cast<double>(rms_blocks_))));
+                    momentary += channel_weights_[ch] * SumHistory(history_k_, ch, MomentaryBlocks) / (frames * MomentaryBlocks);
+                    short_term += channel_weights_[ch] * SumHistory(history_k_, ch, ShortTermBlocks) / (frames * ShortTermBlocks);
+                }
+                reading_.MomentaryLoudness = ToLufs(momentary);
+                reading_.ShortTermLoudness = ToLufs(short_term);
+            }
+
+            void Publish() noexcept
+            {
+                const uint32_t version = version_.load(std::memory_order_relaxed);
+                version_.store(version + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (size_t ch = 0; ch < MaxChannels; ch++)
+                {
+                    published_[ch].store(reading_.Peak[ch], std::memory_order_relaxed);
+                    published_[MaxChannels + ch].store(reading_.Rms[ch], std::memory_order_relaxed);
+                }
+                published_[MaxChannels * 2 + 0].store(reading_.MomentaryLoudness, std::memory_order_relaxed);
+                published_[MaxChannels * 2 + 1].store(reading_.ShortTermLoudness, std::memory_order_relaxed);
+                published_frames_.store(reading_.Frames, std::memory_order_relaxed);
+                version_.store(version + 2, std::memory_order_release);
+            }
+
+            void Reset()
+            {
+                for (auto& s : k_states_) s = processing::BiquadState{};
+                block_position_ = 0;
+                std::fill(std::begin(block_sums_), std::end(block_sums_), 0.0);
+                std::fill(std::begin(block_k_sums_), std::end(block_k_sums_), 0.0);
+                for (auto& h : history_) std::fill(std::begin(h), std::end(h), 0.0);
+                for (auto& h : history_k_) std::fill(std::begin(h), std::end(h), 0.0);
+                history_position_ = 0;
+
+                reading_ = AudioMeterReading{};
+                reading_.Channels = static_cast<uint32_t>(channels_);
+                reading_.MomentaryLoudness = -std::numeric_limits<float>::infinity();
+                reading_.ShortTermLoudness = -std::numeric_limits<float>::infinity();
+                Publish();
+            }
+        };
+    }
+
+    std::shared_ptr<IAudioMeter> CreateAudioMeter(PcmWaveFormat format, AudioMeterOptions options)
+    {
+        if (format.SampleType() != SampleType::F32 || format.ChannelCount() > static_cast<int>(MaxChannels) || format.SamplingFrequency() < 10)
+            throw std::invalid_argument("not supported.");
+
+        if (!(options.peak_release_milliseconds > 0.0f))
+            throw std::invalid_argument("peak_release_milliseconds");
+
+        if (!(options.rms_window_milliseconds >= 100.0f && options.rms_window_milliseconds <= 3000.0f))
+            throw std::invalid_argument("rms_window_milliseconds");
+
+        const size_t rms_blocks = std::clamp<size_t>(static_cast<size_t>(std::lround(options.rms_window_milliseconds / 100.0f)), 1, ShortTermBlocks);
+        const double peak_release_frames = static_cast<double>(options.peak_release_milliseconds) * format.SamplingFrequency() / 1000.0;
+        return std::make_shared<AudioMeterImpl>(format, rms_blocks, peak_release_frames);
+    }
+}
@@ -0,0 +1,48 @@
+/// @file
+/// @brief  Vse - Audio Meter
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    struct AudioMeterReading
+    {
+        static constexpr size_t MaxChannels = 8;
+        uint32_t Channels;
+        float Peak[MaxChannels];  ///< sample peak (abs), falling by 20 dB per peak_release_milliseconds
+        float Rms[MaxChannels];   ///< RMS over rms_window_milliseconds
+        float MomentaryLoudness;  ///< EBU R128 momentary loudness (400 ms) in LUFS
+        float ShortTermLoudness;  ///< EBU R128 short-term loudness (3 s) in LUFS
+        uint64_t Frames;          ///< frames metered since the last discontinuity
+    };
+
+    struct AudioMeterOptions
+    {
+        float peak_release_milliseconds = 1700.0f; ///< time for the peak to fall by 20 dB
+        float rms_window_milliseconds = 300.0f;    ///< rounded to 100 ms (100 .. 3000)
+    };
+
+    class IAudioMeter : public IWaveProcessor
+    {
+    public:
+        /// Gets the latest reading.
+        /// Lock-free: it can be polled from any thread without blocking the audio thread.
+        /// Loudness and RMS are updated every 100 ms, peaks on every Process.
+        [[nodiscard]] virtual AudioMeterReading GetReading() const = 0;
+    };
+
+    /// Creates meter tap. The audio passes through unchanged.
+    /// Loudness follows ITU-R BS.1770 (K-weighting, channel weights by the channel mask, LFE excluded).
+    /// @param format source/destination format. F32 only, up to 8 channels.
+    /// @param options meter ballistics
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<IAudioMeter> CreateAudioMeter(PcmWaveFormat format, AudioMeterOptions options = AudioMeterOptions{});
+}
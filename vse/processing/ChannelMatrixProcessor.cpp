@@ -0,0 +1,236 @@
+/// @file
+/// @brief  Vse - Channel Matrix Processor
+/// @author (C) 2022 ttsuki
+
+#include "ChannelMatrixProcessor.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <utility>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        struct SpeakerRoute
+        {
+            SpeakerBit to;
+            float gain;
+        };
+
+        using SpeakerRoutes = std::vector<SpeakerRoute>;
+
+        constexpr float m3dB = 0.70710678f;
+        constexpr float m6dB = 0.5f;
+
+        // Where the sound of a speaker goes if the speaker is missing.
+        // Alternatives are tried in order; routes may chain through other missing speakers.
+        std::vector<SpeakerRoutes> GetFallbackRoutes(SpeakerBit speaker)
+        {
+            using S = SpeakerBit;
+            switch (speaker)
+            {
+            case S::FrontLeft: return {{{S::FrontCenter, m3dB}}};
+            case S::FrontRight: return {{{S::FrontCenter, m3dB}}};
+            case S::FrontCenter: return {{{S::FrontLeft, m3dB}, {S::FrontRight, m3dB}}};
+            case S::LowFrequency: return {};
+            case S::BackLeft: return {{{S::SideLeft, 1.0f}}, {{S::FrontLeft, m3dB}}};
+            case S::BackRight: return {{{S::SideRight, 1.0f}}, {{S::FrontRight, m3dB}}};
+            case S::FrontLeftOfCenter: return {{{S::FrontLeft, 1.0f}}};
+            case S::FrontRightOfCenter: return {{{S::FrontRight, 1.0f}}};
+            case S::BackCenter: return {{{S::BackLeft, m3dB}, {S::BackRight, m3dB}}};
+            case S::SideLeft: return {{{S::BackLeft, 1.0f}}, {{S::FrontLeft, m3dB}}};
+            case S::SideRight: return {{{S::BackRight, 1.0f}}, {{S::FrontRight, m3dB}}};
+            case S::TopCenter: return {{{S::FrontCenter, m6dB}, {S::BackCenter, m6dB}}};
+            case S::TopFrontLeft: return {{{S::FrontLeft, m3dB}}};
+            case S::TopFrontCenter: return {{{S::FrontCenter, m3dB}}};
+            case S::TopFrontRight: return {{{S::FrontRight, m3dB}}};
+            case S::TopBackLeft: return {{{S::BackLeft, m3dB}}};
+            case S::TopBackCenter: return {{{S::BackCenter, m3dB}}};
+            case S::TopBackRight: return {{{S::BackRight, m3dB}}};
+            default: return {};
+            }
+        }
+
+        // Resolves a speaker to output speakers. returns nullopt if the speaker can't be placed (dropped).
+        std::optional<SpeakerRoutes> ResolveRoutes(SpeakerBit speaker, float gain, SpeakerBit output_channels, SpeakerBit visited)
+        {
+            if ((speaker & output_channels) == speaker) return SpeakerRoutes{{speaker, gain}};
+            if ((speaker & visited) == speaker) return std::nullopt;
+            visited |= speaker;
+
+            for (const SpeakerRoutes& alternative : GetFallbackRoutes(speaker))
+            {
+                SpeakerRoutes resolved;
+                bool ok = true;
+                for (const SpeakerRoute& r : alternative)
+                {
+                    auto sub = ResolveRoutes(r.to, gain * r.gain, output_channels, visited);
+                    if (!sub) { ok = false; break; }
+                    resolved.insert(resolved.end(), sub->begin(), sub->end());
+                }
+
+                if (ok) return resolved;
+            }
+
+            return std::nullopt;
+        }
+
+        std::vector<SpeakerBit> EnumerateSpeakers(SpeakerBit mask)
+        {
+            std::vector<SpeakerBit> speakers;
+            for (DWORD bit = 1; bit != 0 && bit <= +mask; bit <<= 1)
+                if (+mask & bit) speakers.push_back(static_cast<SpeakerBit>(bit));
+            return speakers;
+        }
+
+        size_t IndexOf(const std::vector<SpeakerBit>& speakers, SpeakerBit speaker)
+        {
+            for (size_t i = 0; i < speakers.size(); i++)
+                if (speakers[i] == speaker) return i;
+            return speakers.size();
+        }
+
+        template <class TInput, class TOutput>
+        class ChannelMatrixProcessorImpl final : public IWaveProcessor
+        {
+            PcmWaveFormat input_format_{};
+            PcmWaveFormat output_format_{};
+            std::vector<float> matrix_{};
+            size_t input_channels_{};
+            size_t output_channels_{};
+
+            xtl::temp_memory_buffer read_buffer_{};
+            xtl::temp_memory_buffer convert_buffer_{};
+            xtl::temp_memory_buffer output_buffer_{};
+
+        public:
+            ChannelMatrixProcessorImpl(const PcmWaveFormat& input_format, const PcmWaveFormat& output_format, std::vector<float> matrix)
+                : input_format_(input_format)
+                , output_format_(output_format)
+                , matrix_(std::move(matrix))
+                , input_channels_(static_cast<size_t>(input_format.ChannelCount()))
+                , output_channels_(static_cast<size_t>(output_format.ChannelCount())) { }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return input_format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return output_format_; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                const size_t max_frames = destination_buffer_length / output_format_.BlockAlign();
+
+                auto* raw = read_buffer_.get<TInput>(max_frames * input_channels_);
+                const size_t frames = read_source(context, raw, max_frames * input_format_.BlockAlign()) / input_format_.BlockAlign();
+
+                const F32* src;
+                if constexpr (std::is_same_v<TInput, F32>)
+                {
+                    src = raw;
+                }
+                else
+                {
+                    F32* tmp = convert_buffer_.get<F32>(frames * input_channels_);
+                    processing::ConvertCopy(tmp, raw, frames * input_channels_);
+                    src = tmp;
+                }
+
+                if constexpr (std::is_same_v<TOutput, F32>)
+                {
+                    processing::MixChannels(static_cast<F32*>(destination_buffer), output_channels_, src, input_channels_, matrix_.data(), frames);
+                }
+                else
+                {
+                    F32* out = output_buffer_.get<F32>(frames * output_channels_);
+                    processing::MixChannels(out, output_channels_, src, input_channels_, matrix_.data(), frames);
+                    processing::ConvertCopy(static_cast<TOutput*>(destination_buffer), out, frames * output_channels_);
+                }
+
+                return frames * output_format_.BlockAlign();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                read_buffer_.reserve<TInput>(max_output_frames * input_channels_);
+                if constexpr (!std::is_same_v<TInput, F32>) convert_buffer_.reserve<F32>(max_output_frames * input_channels_);
+                if constexpr (!std::is_same_v<TOutput, F32>) output_buffer_.reserve<F32>(max_output_frames * output_channels_);
+                return max_output_frames;
+            }
+        };
+
+        template <class TInput>
+        std::shared_ptr<IWaveProcessor> CreateChannelMatrixProcessorImpl(const PcmWaveFormat& input_format, const PcmWaveFormat& output_format, std::vector<float> matrix)
+        {
+            switch (output_format.SampleType())
+            {
+            case SampleType::S16: return std::make_shared<ChannelMatrixProcessorImpl<TInput, S16>>(input_format, output_format, std::move(matrix));
+            case SampleType::S24: return std::make_shared<ChannelMatrixProcessorImpl<TInput, S24>>(input_format, output_format, std::move(matrix));
+            case SampleType::S32: return std::make_shared<ChannelMatrixProcessorImpl<TInput, S32>>(input_format, output_format, std::move(matrix));
+            case SampleType::F32: return std::make_shared<ChannelMatrixProcessorImpl<TInput, F32>>(input_format, output_format, std::move(matrix));
+            default: throw std::invalid_argument("not supported format!");
+            }
+        }
+    }
+
+    std::vector<float> GetDefaultChannelMatrix(SpeakerBit input_channels, SpeakerBit output_channels)
+    {
+        const auto inputs = EnumerateSpeakers(input_channels);
+        const auto outputs = EnumerateSpeakers(output_channels);
+        std::vector<float> matrix(inputs.size() * outputs.size());
+
+        // mono: duplicates to the front pair at unity gain, rather than panning at -3dB.
+        if (inputs.size() == 1 && (inputs[0] & output_channels) == SpeakerBit::None
+            && (output_channels & SpeakerBit::FrontPair) == SpeakerBit::FrontPair)
+        {
+            matrix[IndexOf(outputs, SpeakerBit::FrontLeft)] = 1.0f;
+            matrix[IndexOf(outputs, SpeakerBit::FrontRight)] = 1.0f;
+            return matrix;
+        }
+
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            if (auto routes = ResolveRoutes(inputs[i], 1.0f, output_channels, SpeakerBit::None))
+            {
+                for (const SpeakerRoute& r : *routes)
+                    matrix[IndexOf(outputs, r.to) * inputs.size() + i] += r.gain;
+            }
+        }
+
+        return matrix;
+    }
+
+    std::shared_ptr<IWaveProcessor> CreateChannelMatrixProcessor(
+        PcmWaveFormat input_format,
+        PcmWaveFormat output_format,
+        std::vector<float> matrix)
+    {
+        if (!input_format || !output_format || input_format.SamplingFrequency() != output_format.SamplingFrequency())
+            throw std::invalid_argument("not supported format!");
+
+        if (input_format.ChannelCount() == 0 || output_format.ChannelCount() == 0)
+            throw std::invalid_argument("not supported format!");
+
+        if (matrix.empty())
+            matrix = GetDefaultChannelMatrix(input_format.ChannelMask(), output_format.ChannelMask());
+
+        if (matrix.size() != static_cast<size_t>(input_format.ChannelCount()) * static_cast<size_t>(output_format.ChannelCount()))
+            throw std::invalid_argument("matrix size mismatch!");
+
+        switch (input_format.SampleType())
+        {
+        case SampleType::S16: return CreateChannelMatrixProcessorImpl<S16>(input_format, output_format, std::move(matrix));
+        case SampleType::S24: return CreateChannelMatrixProcessorImpl<S24>(input_format, output_format, std::move(matrix));
+        case SampleType::S32: return CreateChannelMatrixProcessorImpl<S32>(input_format, output_format, std::move(matrix));
+        case SampleType::F32: return CreateChannelMatrixProcessorImpl<F32>(input_format, output_format, std::move(matrix));
+        default: throw std::invalid_argument("not supported format!");
+        }
+    }
+}
@@ -0,0 +1,31 @@
+/// @file
+/// @brief  Vse - Channel Matrix Processor
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    /// Gets default up/down-mix matrix.
+    /// The matrix is row-major: matrix[o * input_channel_count + i] is the gain from input channel i to output channel o,
+    /// where channels are in the order of speaker bits.
+    /// Speakers missing in the output are folded into their nearest speakers (e.g. center -> front pair at -3dB,
+    /// back -> side -> front), LFE is dropped, and a mono source is duplicated to the front pair at unity gain.
+    [[nodiscard]] std::vector<float> GetDefaultChannelMatrix(SpeakerBit input_channels, SpeakerBit output_channels);
+
+    /// Creates channel matrix (up/down-mix) processor.
+    /// @param input_format source format
+    /// @param output_format destination format. sampling frequency must be same as source.
+    /// @param matrix row-major output x input gains. if empty, GetDefaultChannelMatrix is used.
+    /// @throw std::invalid_argument Not supported format or matrix size.
+    [[nodiscard]] std::shared_ptr<IWaveProcessor> CreateChannelMatrixProcessor(
+        PcmWaveFormat input_format,
+        PcmWaveFormat output_format,
+        std::vector<float> matrix = {});
+}
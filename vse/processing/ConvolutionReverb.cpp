@@ -0,0 +1,558 @@
+/// @file
+/// @brief  Vse - Convolution Reverb
+/// @author (C) 2022 ttsuki
+
+#include "ConvolutionReverb.h"
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        /// Real FFT of size N (power of 2) by the complex FFT of size N/2.
+        /// Spectra are N/2 + 1 bins in split (real/imaginary) arrays.
+        class RealFft final
+        {
+            size_t size_{};  // N
+            size_t half_{};  // M = N/2
+            std::vector<size_t> bit_reverse_{};
+            std::vector<float> butterfly_re_{}; // twiddles of each stage, concatenated
+            std::vector<float> butterfly_im_{};
+            std::vector<float> split_re_{};     // W^k = exp(-2 pi i k / N), k = 0..M
+            std::vector<float> split_im_{};
+            std::vector<float> z_re_{};
+            std::vector<float> z_im_{};
+
+        public:
+            explicit RealFft(size_t size)
+                : size_(size)
+                , half_(size / 2)
+                , bit_reverse_(half_)
+                , split_re_(half_ + 1)
+                , split_im_(half_ + 1)
+                , z_re_(half_)
+                , z_im_(half_)
+            {
+                const double pi = 3.14159265358979323846;
+
+                size_t bits = 0;
+                while ((size_t{1} << bits) < half_) bits++;
+                for (size_t i = 0; i < half_; i++)
+                {
+                    size_t r = 0;
+                    for (size_t b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+                    bit_reverse_[i] = r;
+                }
+
+                for (size_t length = 2; length <= half_; length <<= 1)
+                {
+                    for (size_t j = 0; j < length / 2; j++)
+                    {
+                        butterfly_re_.push_back(static_cast<float>(std::cos(2.0 * pi * static_cast<double>(j) / static_cast<double>(length))));
+                        butterfly_im_.push_back(static_cast<float>(-std::sin(2.0 * pi * static_cast<double>(j) / static_cast<double>(length))));
+                    }
+                }
+
+                for (size_t k = 0; k <= half_; k++)
+                {
+                    split_re_[k] = static_cast<float>(std::cos(2.0 * pi * static_cast<double>(k) / static_cast<double>(size_)));
+                    split_im_[k] = static_cast<float>(-std::sin(2.0 * pi * static_cast<double>(k) / static_cast<double>(size_)));
+                }
+            }
+
+            [[nodiscard]] size_t Size() const noexcept { return size_; }
+            [[nodiscard]] size_t Bins() const noexcept { return half_ + 1; }
+
+            /// X = DFT(x)
+            void Forward(const float* x, float* re, float* im) noexcept
+            {
+                const size_t m = half_;
+                for (size_t n = 0; n < m; n++)
+                {
+                    z_re_[n] = x[2 * n];
+                    z_im_[n] = x[2 * n + 1];
+                }
+
+                Transform(z_re_.data(), z_im_.data(), false);
+
+                // X[k] = E[k] + W^k O[k], where E and O are the spectra of even and odd samples.
+                for (size_t k = 0; k <= m; k++)
+                {
+                    const size_t p = k == m ? 0 : k;
+                    const size_t q = k == 0 ? 0 : m - k;
+                    const float ar = z_re_[p], ai = z_im_[p];
+                    const float br = z_re_[q], bi = -z_im_[q];
+                    const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+                    const float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+                    re[k] = er + split_re_[k] * or_ - split_im_[k] * oi;
+                    im[k] = ei + split_re_[k] * oi + split_im_[k] * or_;
+                }
+            }
+
+            /// x = IDFT(X) * N/2 (not normalized)
+            void Inverse(const float* re, const float* im, float* x) noexcept
+            {
+                const size_t m = half_;
+                for (size_t k = 0; k < m; k++)
+                {
+                    const float ar = re[k], ai = im[k];
+                    const float br = re[m - k], bi = -im[m - k];
+                    const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+                    const float dr = 0.5f * (ar - br), di = 0.5f * (ai - bi);
+                    const float or_ = dr * split_re_[k] + di * split_im_[k]; // * W^-k
+                    const float oi = di * split_re_[k] - dr * split_im_[k];
+                    z_re_[k] = er - oi;
+                    z_im_[k] = ei + or_;
+                }
+
+                Transform(z_re_.data(), z_im_.data(), true);
+
+                for (size_t n = 0; n < m; n++)
+                {
+                    x[2 * n] = z_re_[n];
+                    x[2 * n + 1] = z_im_[n];
+                }
+            }
+
+        private:
+            // in-place radix-2 decimation-in-time complex FFT.
+            void Transform(float* re, float* im, bool inverse) const noexcept
+            {
+                const size_t m = half_;
+                for (size_t i = 0; i < m; i++)
+                {
+                    const size_t r = bit_reverse_[i];
+                    if (i < r)
+                    {
+                        std::swap(re[i], re[r]);
+                        std::swap(im[i], im[r]);
+                    }
+                }
+
+                const float sign = inverse ? -1.0f : 1.0f;
+                const float* wr = butterfly_re_.data();
+                const float* wi = butterfly_im_.data();
+                for (size_t length = 2; length <= m; length <<= 1)
+                {
+                    const size_t half = length / 2;
+                    for (size_t i = 0; i < m; i += length)
+                    {
+                        float* ur = re + i;
+                        float* ui = im + i;
+                        float* vr = re + i + half;
+                        float* vi = im + i + half;
+                        for (size_t j = 0; j < half; j++)
+                        {
+                            const float tr = vr[j] * wr[j] - vi[j] * wi[j] * sign;
+                            const float ti = vr[j] * wi[j] * sign + vi[j] * wr[j];
+                            vr[j] = ur[j] - tr;
+                            vi[j] = ui[j] - ti;
+                            ur[j] = ur[j] + tr;
+                            ui[j] = ui[j] + ti;
+                        }
+                    }
+                    wr += half;
+                    wi += half;
+                }
+            }
+        };
+
+        /// Uniformly partitioned overlap-save convolution of planar channels.
+        /// Each call convolves one block of each channel with the response.
+        class PartitionedConvolver final
+        {
+            size_t block_{};
+            size_t channels_{};
+            size_t response_channels_{};
+            size_t partitions_{};
+            size_t stride_{}; // floats per spectrum
+            RealFft fft_;
+
+            std::vector<float> response_re_{}; // [response channel][partition][bin]
+            std::vector<float> response_im_{};
+            std::vector<float> history_{};     // [channel][2 * block] time domain input
+            std::vector<float> delay_re_{};    // [channel][partition][bin] frequency domain delay line
+            std::vector<float> delay_im_{};
+            size_t delay_position_{};
+
+            std::vector<float> time_{};
+            std::vector<float> accumulator_re_{};
+            std::vector<float> accumulator_im_{};
+
+        public:
+            /// @param response planar response: response[c][offset .. offset + length)
+            PartitionedConvolver(size_t block, size_t channels, const std::vector<std::vector<float>>& response, size_t offset, size_t length)
+                : block_(block)
+                , channels_(channels)
+                , response_channels_(response.size())
+                , partitions_(std::max<size_t>((length + block - 1) / block, 1))
+                , stride_((block + 1 + 15) / 16 * 16)
+                , fft_(block * 2)
+                , response_re_(response_channels_ * partitions_ * stride_)
+                , response_im_(response_channels_ * partitions_ * stride_)
+                , history_(channels * block * 2)
+                , delay_re_(channels * partitions_ * stride_)
+                , delay_im_(channels * partitions_ * stride_)
+                , time_(block * 2)
+                , accumulator_re_(stride_)
+                , accumulator_im_(stride_)
+            {
+                // the inverse transform is not normalized: scales the response instead.
+                const float scale = 1.0f / static_cast<float>(block_);
+                for (size_t c = 0; c < response_channels_; c++)
+                {
+                    for (size_t p = 0; p < partitions_; p++)
+                    {
+                        std::fill(time_.begin(), time_.end(), 0.0f);
+                        const size_t begin = std::min(offset + p * block_, offset + length);
+                        const size_t end = std::min(begin + block_, offset + length);
+                        for (size_t i = begin; i < end; i++)
+                            time_[i - begin] = response[c][i] * scale;
+
+                        const size_t s = (c * partitions_ + p) * stride_;
+                        fft_.Forward(time_.data(), &response_re_[s], &response_im_[s]);
+                    }
+                }
+            }
+
+            [[nodiscard]] size_t Block() const noexcept { return block_; }
+
+            /// Convolves src[c * src_stride .. + block) into dst[c * dst_stride .. + block) for each channel.
+            void Process(const float* src, size_t src_stride, float* dst, size_t dst_stride) noexcept
+            {
+                const size_t b = block_;
+                const size_t bins = fft_.Bins();
+                for (size_t c = 0; c < channels_; c++)
+                {
+                    float* history = &history_[c * b * 2];
+                    std::memcpy(history, history + b, b * sizeof(float));
+                    std::memcpy(history + b, src + c * src_stride, b * sizeof(float));
+
+                    const size_t head = (c * partitions_ + delay_position_) * stride_;
+                    fft_.Forward(history, &delay_re_[head], &delay_im_[head]);
+
+                    std::fill(accumulator_re_.begin(), accumulator_re_.end(), 0.0f);
+                    std::fill(accumulator_im_.begin(), accumulator_im_.end(), 0.0f);
+
+                    const size_t rc = response_channels_ == 1 ? 0 : c;
+                    for (size_t p = 0; p < partitions_; p++)
+                    {
+                        const size_t d = (c * partitions_ + (delay_position_ + partitions_ - p) % partitions_) * stride_;
+                        const size_t r = (rc * partitions_ + p) * stride_;
+                        processing::MultiplyAccumulateComplex(
+                            accumulator_re_.data(), accumulator_im_.data(),
+                            &delay_re_[d], &delay_im_[d],
+                            &response_re_[r], &response_im_[r], bins);
+                    }
+
+                    // overlap-save: the latter half is the linear convolution.
+                    fft_.Inverse(accumulator_re_.data(), accumulator_im_.data(), time_.data());
+                    std::memcpy(dst + c * dst_stride, time_.data() + b, b * sizeof(float));
+                }
+
+                delay_position_ = (delay_position_ + 1) % partitions_;
+            }
+
+            void Reset() noexcept
+            {
+                std::fill(history_.begin(), history_.end(), 0.0f);
+                std::fill(delay_re_.begin(), delay_re_.end(), 0.0f);
+                std::fill(delay_im_.begin(), delay_im_.end(), 0.0f);
+                delay_position_ = 0;
+            }
+        };
+
+        class ConvolutionReverbImpl final : public IConvolutionReverb, public IPlanarWaveProcessor
+        {
+            PcmWaveFormat format_;
+            std::atomic<ConvolutionReverbParameters> params_;
+            std::atomic_flag continuity_{};
+
+            const size_t channels_;
+            const size_t head_block_;
+            const size_t tail_block_;
+
+            // head: response [0, 2 * tail_block), on the audio thread.
+            PartitionedConvolver head_;
+            std::vector<float> head_input_{};  // [channel][head_block], holds the previous block until overwritten
+            std::vector<float> head_output_{}; // [channel][head_block]
+            size_t head_position_{};
+            size_t head_block_count_{};
+
+            // tail: response [2 * tail_block, end), one tail block of input is convolved while the next one is collected.
+            // the output for the input block q is mixed while the input block q + 2 is collected.
+            std::unique_ptr<PartitionedConvolver> tail_{};
+            std::vector<float> tail_input_[2]{};  // [channel][tail_block]
+            std::vector<float> tail_output_[2]{}; // [channel][tail_block]
+
+            std::mutex tail_mutex_{};
+            std::condition_variable tail_submitted_cv_{};
+            std::condition_variable tail_completed_cv_{};
+            size_t tail_submitted_{};
+            std::atomic<size_t> tail_completed_{};
+            bool tail_running_{true};
+            std::thread tail_thread_{};
+
+        public:
+            ConvolutionReverbImpl(PcmWaveFormat format, const std::vector<std::vector<float>>& response, ConvolutionReverbParameters params, ConvolutionReverbOptions options)
+                : format_(format)
+                , params_(params)
+                , channels_(static_cast<size_t>(format.ChannelCount()))
+                , head_block_(options.head_partition_frames)
+                , tail_block_(options.tail_partition_frames)
+                , head_(head_block_, channels_, response, 0, std::min(response[0].size(), tail_block_ * 2))
+                , head_input_(channels_ * head_block_)
+                , head_output_(channels_ * head_block_)
+            {
+                if (response[0].size() > tail_block_ * 2)
+                {
+                    tail_ = std::make_unique<PartitionedConvolver>(tail_block_, channels_, response, tail_block_ * 2, response[0].size() - tail_block_ * 2);
+                    for (auto& v : tail_input_) v.resize(channels_ * tail_block_);
+                    for (auto& v : tail_output_) v.resize(channels_ * tail_block_);
+
+                    if (options.background_tail)
+                        tail_thread_ = std::thread([this] { TailThreadProc(); });
+                }
+
+                continuity_.test_and_set();
+            }
+
+            ConvolutionReverbImpl(const ConvolutionReverbImpl& other) = delete;
+            ConvolutionReverbImpl(ConvolutionReverbImpl&& other) noexcept = delete;
+            ConvolutionReverbImpl& operator=(const ConvolutionReverbImpl& other) = delete;
+            ConvolutionReverbImpl& operator=(ConvolutionReverbImpl&& other) noexcept = delete;
+
+            ~ConvolutionReverbImpl() override
+            {
+                if (tail_thread_.joinable())
+                {
+                    {
+                        std::lock_guard lock(tail_mutex_);
+                        tail_running_ = false;
+                    }
+                    tail_submitted_cv_.notify_one();
+                    tail_thread_.join();
+                }
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, head_block_, 1.0}; }
+            [[nodiscard]] size_t GetLatency() const override { return head_block_; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                if (!continuity_.test_and_set()) Reset();
+
+                const int block_align = format_.BlockAlign();
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+                const size_t frames = bytes / block_align;
+
+                ProcessFrames<false>(static_cast<F32*>(destination_buffer), channels_, frames);
+                return bytes;
+            }
+
+            void ProcessPlanar(const PlanarBlock& block) override
+            {
+                if (!continuity_.test_and_set()) Reset();
+
+                ProcessFrames<true>(block.data, block.stride, block.frames);
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            [[nodiscard]] ConvolutionReverbParameters GetParameters() const override { return params_.load(std::memory_order_acquire); }
+            void SetParameters(ConvolutionReverbParameters parameters) override { params_.store(parameters, std::memory_order_release); }
+
+        private:
+            /// Processes frames in place: sample i of channel ch is at buf[ch * stride + i] if Planar, or at buf[i * stride + ch].
+            template <bool Planar>
+            void ProcessFrames(F32* buf, size_t stride, size_t frames)
+            {
+                const ConvolutionReverbParameters params = GetParameters();
+                const size_t b = head_block_;
+
+                for (size_t done = 0; done < frames;)
+                {
+                    const size_t count = std::min(frames - done, b - head_position_);
+                    for (size_t ch = 0; ch < channels_; ch++)
+                    {
+                        F32* p = Planar ? buf + ch * stride + done : buf + done * stride + ch;
+                        const size_t step = Planar ? 1 : stride;
+                        float* input = &head_input_[ch * b + head_position_];
+                        const float* output = &head_output_[ch * b + head_position_];
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            // input[i] is the dry sample of the previous block.
+                            const float x = p[i * step];
+                            p[i * step] = input[i] * params.DryMultiplier + output[i] * params.WetMultiplier;
+                            input[i] = x;
+                        }
+                    }
+
+                    done += count;
+                    head_position_ += count;
+                    if (head_position_ == b)
+                    {
+                        ProcessBlock();
+                        head_position_ = 0;
+                    }
+                }
+            }
+
+            void ProcessBlock()
+            {
+                const size_t b = head_block_;
+                head_.Process(head_input_.data(), b, head_output_.data(), b);
+
+                if (tail_)
+                {
+                    const size_t l = tail_block_;
+                    const size_t t = head_block_count_ * b;
+                    const size_t q = t / l;
+                    const size_t r = t % l;
+
+                    // the output for the block q - 2 must be ready, and then its input slot can be reused.
+                    if (q >= 2)
+                    {
+                        if (r == 0) WaitTail(q - 1);
+
+                        const float* tail = tail_output_[q % 2].data();
+                        for (size_t ch = 0; ch < channels_; ch++)
+                            for (size_t i = 0; i < b; i++)
+                                head_output_[ch * b + i] += tail[ch * l + r + i];
+                    }
+
+                    float* input = tail_input_[q % 2].data();
+                    for (size_t ch = 0; ch < channels_; ch++)
+                        std::memcpy(&input[ch * l + r], &head_input_[ch * b], b * sizeof(float));
+
+                    if (r + b == l) SubmitTail(q);
+                }
+
+                head_block_count_++;
+            }
+
+            void SubmitTail(size_t q)
+            {
+                if (!tail_thread_.joinable())
+                {
+                    ConvolveTail(q);
+                    tail_completed_.store(q + 1, std::memory_order_release);
+                    return;
+                }
+
+                {
+                    std::lock_guard lock(tail_mutex_);
+                    tail_submitted_ = q + 1;
+                }
+                tail_submitted_cv_.notify_one();
+            }
+
+            void WaitTail(size_t count)
+            {
+                if (tail_completed_.load(std::memory_order_acquire) >= count)
+                    return;
+
+                // the worker is late. waits for it rather than dropping the tail.
+                std::unique_lock lock(tail_mutex_);
+                tail_completed_cv_.wait(lock, [&] { return tail_completed_.load(std::memory_order_acquire) >= count; });
+            }
+
+            void ConvolveTail(size_t q)
+            {
+                tail_->Process(tail_input_[q % 2].data(), tail_block_, tail_output_[q % 2].data(), tail_block_);
+            }
+
+            void TailThreadProc()
+            {
+                std::unique_lock lock(tail_mutex_);
+                while (true)
+                {
+                    tail_submitted_cv_.wait(lock, [&] { return !tail_running_ || tail_completed_.load(std::memory_order_relaxed) < tail_submitted_; });
+                    if (!tail_running_) break;
+
+                    const size_t q = tail_completed_.load(std::memory_order_relaxed);
+                    lock.unlock();
+                    ConvolveTail(q);
+                    lock.lock();
+
+                    tail_completed_.store(q + 1, std::memory_order_release);
+                    tail_completed_cv_.notify_all();
+                }
+            }
+
+            void Reset()
+            {
+                head_.Reset();
+                std::fill(head_input_.begin(), head_input_.end(), 0.0f);
+                std::fill(head_output_.begin(), head_output_.end(), 0.0f);
+                head_position_ = 0;
+                head_block_count_ = 0;
+
+                if (tail_)
+                {
+                    std::unique_lock lock(tail_mutex_);
+                    tail_completed_cv_.wait(lock, [&] { return tail_completed_.load(std::memory_order_acquire) >= tail_submitted_; });
+                    tail_submitted_ = 0;
+                    tail_completed_.store(0, std::memory_order_relaxed);
+                    tail_->Reset();
+                }
+            }
+        };
+    }
+
+    std::shared_ptr<IConvolutionReverb> CreateConvolutionReverb(PcmWaveFormat format, const std::shared_ptr<IRandomAccessWaveBuffer>& impulse_response, ConvolutionReverbParameters initialParameters, ConvolutionReverbOptions options)
+    {
+        if (format.SampleType() != SampleType::F32)
+            throw std::invalid_argument("not supported.");
+
+        if (!impulse_response)
+            throw std::invalid_argument("impulse_response");
+
+        const PcmWaveFormat ir_format = impulse_response->GetFormat();
+        const size_t channels = static_cast<size_t>(format.ChannelCount());
+        const size_t ir_channels = static_cast<size_t>(ir_format.ChannelCount());
+        if (ir_format.SampleType() != SampleType::F32 || ir_format.SamplingFrequency() != format.SamplingFrequency() || (ir_channels != 1 && ir_channels != channels))
+            throw std::invalid_argument("impulse_response format not supported.");
+
+        auto is_power_of_2 = [](size_t v) { return v != 0 && (v & (v - 1)) == 0; };
+        if (!is_power_of_2(options.head_partition_frames) || options.head_partition_frames < 4)
+            throw std::invalid_argument("head_partition_frames");
+        if (!is_power_of_2(options.tail_partition_frames) || options.tail_partition_frames < options.head_partition_frames)
+            throw std::invalid_argument("tail_partition_frames");
+
+        // de-interleave
+        const size_t frames = impulse_response->Size() / ir_format.BlockAlign();
+        if (frames == 0)
+            throw std::invalid_argument("impulse_response is empty.");
+
+        std::vector<F32> interleaved(frames * ir_channels);
+        (void)impulse_response->Read(interleaved.data(), 0, frames * ir_format.BlockAlign());
+
+        std::vector<std::vector<float>> response(ir_channels, std::vector<float>(frames));
+        for (size_t i = 0; i < frames; i++)
+            for (size_t c = 0; c < ir_channels; c++)
+                response[c][i] = interleaved[i * ir_channels + c];
+
+        return std::make_shared<ConvolutionReverbImpl>(format, response, initialParameters, options);
+    }
+}
@@ -0,0 +1,51 @@
+/// @file
+/// @brief  Vse - Convolution Reverb
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveSource.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    struct ConvolutionReverbParameters
+    {
+        float DryMultiplier = 1.0f;
+        float WetMultiplier = 0.25f;
+    };
+
+    struct ConvolutionReverbOptions
+    {
+        size_t head_partition_frames = 128;  ///< partition size processed on the audio thread. the output is delayed by this. (power of 2)
+        size_t tail_partition_frames = 4096; ///< partition size of the tail after 2 * tail_partition_frames. (power of 2, >= head_partition_frames)
+        bool background_tail = true;         ///< processes the tail on a worker thread.
+    };
+
+    class IConvolutionReverb : public IParametricWaveProcessor<ConvolutionReverbParameters>
+    {
+    public:
+        /// Gets the delay of the output from the input in frames.
+        [[nodiscard]] virtual size_t GetLatency() const = 0;
+    };
+
+    /// Creates convolution reverb.
+    /// The impulse response is convolved by partitioned FFT convolution (overlap-save):
+    /// its head is split into short partitions processed on the audio thread,
+    /// and the rest into long partitions processed on a worker thread one tail partition ahead.
+    /// @param format source/destination format. F32 only.
+    /// @param impulse_response impulse response. F32, same sampling frequency as format, mono or the same channel count as format.
+    ///        Load it by LoadAudioFile(path, desired_format) or IAsyncAudioFileLoader.
+    /// @param initialParameters parameters
+    /// @param options partitioning
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<IConvolutionReverb> CreateConvolutionReverb(
+        PcmWaveFormat format,
+        const std::shared_ptr<IRandomAccessWaveBuffer>& impulse_response,
+        ConvolutionReverbParameters initialParameters = ConvolutionReverbParameters{},
+        ConvolutionReverbOptions options = ConvolutionReverbOptions{});
+}
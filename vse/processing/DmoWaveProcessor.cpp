@@ -171,6 +171,23 @@ namespace vse
         return VSE_EXPECT_SUCCESS (*pp_media_buffer ? S_OK : E_OUTOFMEMORY);
     }
 
+    /// Gets an empty buffer of the capacity at least, reusing the cached one if no one else holds it.
+    static HRESULT ReuseOrCreateMediaBuffer(win32::com_ptr<IMediaBuffer>& cache, DWORD capacity, IMediaBuffer** pp_media_buffer) noexcept
+    {
+        if (IMediaBuffer* cached = cache.get())
+        {
+            DWORD max_length{};
+            const ULONG ref_count = cached->AddRef();
+            if (ref_count == 2 && SUCCEEDED(cached->GetMaxLength(&max_length)) && max_length >= capacity && SUCCEEDED(cached->SetLength(0)))
+                return *pp_media_buffer = cached, S_OK;
+            cached->Release();
+        }
+
+        if (HRESULT hr = CreateMediaBuffer(capacity, pp_media_buffer); FAILED(hr)) return hr;
+        cache.reset(*pp_media_buffer);
+        return S_OK;
+    }
+
     HRESULT CreateMediaObject(
         const CLSID& clsid,
         const WAVEFORMATEX* input_format,
@@ -220,11 +237,10 @@ namespace vse
             if (need_more_input_)
             {
                 constexpr int alignment_in_samples = 16;
-                DWORD read_size = static_cast<DWORD>(static_cast<uintmax_t>(rest) * input_format_.AvgBytesPerSec() / output_format_.AvgBytesPerSec());
-                read_size = static_cast<DWORD>(RoundUpSizeToAlignment(read_size, input_format_, alignment_in_samples));
+                DWORD read_size = static_cast<DWORD>(SuggestInputBufferSizeForOutputBufferSize(input_format_, output_format_, rest));
 
                 win32::com_ptr<IMediaBuffer> src_buffer;
-                if (HRESULT hr = VSE_EXPECT_SUCCESS CreateMediaBuffer(read_size, src_buffer.put()); FAILED(hr) || !src_buffer) break;
+                if (HRESULT hr = VSE_EXPECT_SUCCESS ReuseOrCreateMediaBuffer(input_buffer_, read_size, src_buffer.put()); FAILED(hr) || !src_buffer) break;
                 BYTE* buf{};
                 DWORD len{};
                 if (HRESULT hr = VSE_EXPECT_SUCCESS src_buffer->GetBufferAndLength(&buf, &len); FAILED(hr)) break;
@@ -252,7 +268,14 @@ namespace vse
             // Processes output
             {
                 win32::com_ptr<IMediaBuffer> dst_buffer;
-                if (HRESULT hr = VSE_EXPECT_SUCCESS CreateMediaBuffer(static_cast<DWORD>(rest), dst_buffer.put()); FAILED(hr) || !dst_buffer) break;
+                if (HRESULT hr = VSE_EXPECT_SUCCESS ReuseOrCreateMediaBuffer(output_buffer_, static_cast<DWORD>(rest), dst_buffer.put()); FAILED(hr) || !dst_buffer) break;
+
+                // the media object appends after the current length: leaves just `rest` bytes of room in a larger reused buffer.
+                DWORD offset{};
+                if (HRESULT hr = VSE_EXPECT_SUCCESS dst_buffer->GetMaxLength(&offset); FAILED(hr)) break;
+                offset -= static_cast<DWORD>(rest);
+                if (HRESULT hr = VSE_EXPECT_SUCCESS dst_buffer->SetLength(offset); FAILED(hr)) break;
+
                 DMO_OUTPUT_DATA_BUFFER out = {dst_buffer.get(), 0, 0, 0};
                 DWORD status{};
                 if (HRESULT hr = VSE_EXPECT_SUCCESS media_object_->ProcessOutput(0, 1, &out, &status); FAILED(hr)) break;
@@ -260,6 +283,8 @@ namespace vse
                 BYTE* buf{};
                 DWORD len{};
                 if (HRESULT hr = VSE_EXPECT_SUCCESS dst_buffer->GetBufferAndLength(&buf, &len); FAILED(hr)) break;
+                buf += offset;
+                len -= offset;
 
                 memcpy(buffer, buf, len);
                 buffer = static_cast<std::byte*>(buffer) + len;
@@ -276,4 +301,16 @@ namespace vse
     {
         continuity_.clear();
     }
+
+    size_t DmoWaveProcessor::Prepare(size_t max_output_frames)
+    {
+        const size_t output_size = max_output_frames * output_format_.BlockAlign();
+        const size_t input_size = SuggestInputBufferSizeForOutputBufferSize(input_format_, output_format_, output_size);
+
+        win32::com_ptr<IMediaBuffer> input, output;
+        VSE_EXPECT_SUCCESS ReuseOrCreateMediaBuffer(input_buffer_, static_cast<DWORD>(input_size), input.put());
+        VSE_EXPECT_SUCCESS ReuseOrCreateMediaBuffer(output_buffer_, static_cast<DWORD>(output_size), output.put());
+
+        return input_size / input_format_.BlockAlign();
+    }
 }
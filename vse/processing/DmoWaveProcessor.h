@@ -54,6 +54,8 @@ namespace vse
         bool need_more_input_{true};
         bool end_of_input_{false};
         std::atomic_flag continuity_{false};
+        win32::com_ptr<IMediaBuffer> input_buffer_{};  // reused while the media object does not hold it.
+        win32::com_ptr<IMediaBuffer> output_buffer_{}; // reused while the media object does not hold it.
 
     public:
         DmoWaveProcessor(IMediaObject* media_object, const PcmWaveFormat& input_format, const PcmWaveFormat& output_format);
@@ -66,6 +68,9 @@ namespace vse
             void* buffer, size_t buffer_length) override;
 
         void Discontinuity() override;
+
+        /// Allocates media buffers for the output size and the input size suggested for it.
+        size_t Prepare(size_t max_output_frames) override;
     };
 
     static inline std::shared_ptr<IWaveProcessor> CreateDmoWaveProcessor(IMediaObject* media_object, const PcmWaveFormat& input_format, const PcmWaveFormat& output_format)
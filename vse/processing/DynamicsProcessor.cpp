@@ -0,0 +1,207 @@
+/// @file
+/// @brief  Vse - Dynamics Processor
+/// @author (C) 2022 ttsuki
+
+#include "DynamicsProcessor.h"
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        constexpr float DecibelsPerOctave = 6.0205999f; // 20 * log10(2)
+
+        class DynamicsProcessorImpl final : public IDynamicsProcessor
+        {
+            PcmWaveFormat format_;
+            std::atomic<DynamicsProcessorParameters> params_;
+            std::atomic_flag continuity_{};
+            std::shared_ptr<IWaveSource> sidechain_;
+
+            const size_t channels_;
+            const size_t detector_channels_;
+
+            std::vector<float> smoothed_; // gain in dB of each channel (the first one if linked)
+            std::atomic<float> gain_reduction_{};
+
+            xtl::temp_memory_buffer sidechain_buffer_{};
+            xtl::temp_memory_buffer level_buffer_{};
+            xtl::temp_memory_buffer gain_buffer_{};
+            xtl::temp_memory_buffer channel_gain_buffer_{};
+
+        public:
+            DynamicsProcessorImpl(PcmWaveFormat format, DynamicsProcessorParameters params, std::shared_ptr<IWaveSource> sidechain)
+                : format_(format)
+                , params_(params)
+                , sidechain_(std::move(sidechain))
+                , channels_(static_cast<size_t>(format.ChannelCount()))
+                , detector_channels_(sidechain_ ? static_cast<size_t>(sidechain_->GetFormat().ChannelCount()) : channels_)
+                , smoothed_(channels_)
+            {
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
+            [[nodiscard]] float GetGainReductionDb() const override { return gain_reduction_.load(std::memory_order_relaxed); }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                if (!continuity_.test_and_set()) Reset();
+
+                const int block_align = format_.BlockAlign();
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+                const size_t frames = bytes / block_align;
+                if (frames == 0) return bytes;
+
+                const DynamicsProcessorParameters params = GetParameters();
+                auto* buf = static_cast<F32*>(destination_buffer);
+                constexpr float no_limit = std::numeric_limits<float>::max();
+
+                const F32* detector = buf;
+                if (sidechain_)
+                {
+                    const size_t length = frames * detector_channels_ * sizeof(F32);
+                    F32* sidechain = sidechain_buffer_.get<F32>(frames * detector_channels_);
+                    const size_t read = sidechain_->Read(sidechain, length);
+                    std::memset(reinterpret_cast<std::byte*>(sidechain) + read, 0, length - read);
+                    detector = sidechain;
+                }
+
+                float* levels = level_buffer_.get<float>(frames);
+                float* gains = gain_buffer_.get<float>(frames);
+                if (params.StereoLink || detector_channels_ != channels_)
+                {
+                    processing::ComputeFramePeaks(levels, detector, detector_channels_, frames);
+                    ComputeGains(gains, levels, frames, params, smoothed_[0]);
+                    processing::ApplyFrameGain(buf, buf, gains, channels_, frames, no_limit);
+                    gain_reduction_.store(smoothed_[0], std::memory_order_relaxed);
+                }
+                else
+                {
+                    float* channel_gains = channel_gain_buffer_.get<float>(frames * channels_);
+                    float reduction = 0.0f;
+                    for (size_t c = 0; c < channels_; c++)
+                    {
+                        for (size_t i = 0; i < frames; i++)
+                            levels[i] = std::abs(detector[i * channels_ + c]);
+
+                        ComputeGains(gains, levels, frames, params, smoothed_[c]);
+                        for (size_t i = 0; i < frames; i++)
+                            channel_gains[i * channels_ + c] = gains[i];
+
+                        reduction = std::min(reduction, smoothed_[c]);
+                    }
+
+                    // per-sample gains: interleaved samples as one channel.
+                    processing::ApplyFrameGain(buf, buf, channel_gains, 1, frames * channels_, no_limit);
+                    gain_reduction_.store(reduction, std::memory_order_relaxed);
+                }
+
+                return bytes;
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                level_buffer_.reserve<float>(max_output_frames);
+                gain_buffer_.reserve<float>(max_output_frames);
+                if (detector_channels_ == channels_) channel_gain_buffer_.reserve<float>(max_output_frames * channels_); // unlinked
+                if (sidechain_)
+                {
+                    sidechain_buffer_.reserve<F32>(max_output_frames * detector_channels_);
+                    sidechain_->Prepare(max_output_frames);
+                }
+                return max_output_frames;
+            }
+
+            [[nodiscard]] DynamicsProcessorParameters GetParameters() const override { return params_.load(std::memory_order_acquire); }
+            void SetParameters(DynamicsProcessorParameters parameters) override { params_.store(parameters, std::memory_order_release); }
+
+        private:
+            [[nodiscard]] float SmoothingCoefficient(float milliseconds) const noexcept
+            {
+                const double frames = static_cast<double>(milliseconds) * format_.SamplingFrequency() / 1000.0;
+                return frames > 1.0 ? static_cast<float>(std::exp(-1.0 / frames)) : 0.0f;
+            }
+
+            /// Computes linear gains from peak levels. levels are overwritten.
+            void ComputeGains(float* gains, float* levels, size_t frames, const DynamicsProcessorParameters& params, float& smoothed) const noexcept
+            {
+                const bool expander = params.Mode == DynamicsMode::Expander;
+                const float threshold = params.ThresholdDb;
+                const float slope = expander ? std::max(params.Ratio, 1.0f) - 1.0f : 1.0f - 1.0f / std::max(params.Ratio, 1.0f);
+                const float knee = std::max(params.KneeDb, 0.0f);
+                const float half_knee = knee * 0.5f;
+                const float knee_scale = knee > 0.0f ? slope / (2.0f * knee) : 0.0f;
+                const float attack = SmoothingCoefficient(params.AttackMilliseconds);
+                const float release = SmoothingCoefficient(params.ReleaseMilliseconds);
+                const float makeup = params.MakeupGainDb;
+
+                // level [dB] = 20 log10(peak)
+                processing::FastLog2(gains, levels, frames);
+
+                float s = smoothed;
+                for (size_t i = 0; i < frames; i++)
+                {
+                    // static curve: the gain [dB] for the level.
+                    const float x = gains[i] * DecibelsPerOctave;
+                    const float over = expander ? threshold - x : x - threshold;
+                    const float g = over <= -half_knee ? 0.0f
+                                        : over < half_knee ? -knee_scale * (over + half_knee) * (over + half_knee)
+                                        : -slope * over;
+
+                    // ballistics: attack while the gain is moving in the direction of a rising level.
+                    const float coefficient = (expander ? g > s : g < s) ? attack : release;
+                    s = g + (s - g) * coefficient;
+                    levels[i] = (s + makeup) * (1.0f / DecibelsPerOctave);
+                }
+                smoothed = s;
+
+                // gain = 10^(dB / 20)
+                processing::FastExp2(gains, levels, frames);
+            }
+
+            void Reset()
+            {
+                std::fill(smoothed_.begin(), smoothed_.end(), 0.0f);
+                gain_reduction_.store(0.0f, std::memory_order_relaxed);
+            }
+        };
+    }
+
+    std::shared_ptr<IDynamicsProcessor> CreateDynamicsProcessor(PcmWaveFormat format, DynamicsProcessorParameters initialParameters, std::shared_ptr<IWaveSource> sidechain)
+    {
+        if (format.SampleType() != SampleType::F32)
+            throw std::invalid_argument("not supported.");
+
+        if (sidechain)
+        {
+            const PcmWaveFormat sidechain_format = sidechain->GetFormat();
+            if (sidechain_format.SampleType() != SampleType::F32 || sidechain_format.SamplingFrequency() != format.SamplingFrequency())
+                throw std::invalid_argument("sidechain format not supported.");
+        }
+
+        return std::make_shared<DynamicsProcessorImpl>(format, initialParameters, std::move(sidechain));
+    }
+}
@@ -0,0 +1,52 @@
+/// @file
+/// @brief  Vse - Dynamics Processor
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <memory>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveSource.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    enum struct DynamicsMode
+    {
+        Compressor = 0, ///< reduces the level above the threshold by the ratio.
+        Expander = 1,   ///< reduces the level below the threshold by the ratio (downward expander).
+    };
+
+    struct DynamicsProcessorParameters
+    {
+        DynamicsMode Mode = DynamicsMode::Compressor;
+        float ThresholdDb = -18.0f;
+        float Ratio = 4.0f;                ///< >= 1
+        float KneeDb = 6.0f;               ///< width of the soft knee
+        float AttackMilliseconds = 10.0f;  ///< time constant of the gain reduction (compressor) or recovery (expander)
+        float ReleaseMilliseconds = 100.0f;
+        float MakeupGainDb = 0.0f;
+        bool StereoLink = true; ///< applies one gain to all channels, detected from the loudest channel.
+    };
+
+    class IDynamicsProcessor : public IParametricWaveProcessor<DynamicsProcessorParameters>
+    {
+    public:
+        /// Gets the current gain reduction in dB (<= 0), without makeup gain.
+        [[nodiscard]] virtual float GetGainReductionDb() const = 0;
+    };
+
+    /// Creates feed-forward compressor/expander.
+    /// Levels are detected by sample peak, and the gain is computed and smoothed in the log domain.
+    /// @param format source/destination format. F32 only.
+    /// @param initialParameters parameters
+    /// @param sidechain optional detector input instead of the source. F32, the same sampling frequency as format.
+    ///        It is read by the same number of frames as the source on each Process.
+    ///        Without StereoLink, its channel count must be the same as format, or the detection is linked.
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<IDynamicsProcessor> CreateDynamicsProcessor(
+        PcmWaveFormat format,
+        DynamicsProcessorParameters initialParameters = DynamicsProcessorParameters{},
+        std::shared_ptr<IWaveSource> sidechain = nullptr);
+}
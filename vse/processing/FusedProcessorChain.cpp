@@ -0,0 +1,337 @@
+/// @file
+/// @brief  Vse - Fused Processor Chain
+/// @author (C) 2022 ttsuki
+
+#include "FusedProcessorChain.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./WaveformProcessing.h"
+#include "./WaveSourceWithProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        // F32 bytes processed through all stages at once: small enough to stay in L1 with the output.
+        constexpr size_t TileBytes = 8192;
+
+        struct FusedStage
+        {
+            IFusableWaveProcessor* processor;
+            processing::BiquadState biquad;     // Biquad
+            rbj_audio_eq::CoefficientRamp ramp; // Biquad
+        };
+
+        template <class TOutput>
+        class FusedProcessorImpl final : public IWaveProcessor
+        {
+            PcmWaveFormat input_format_{};
+            PcmWaveFormat output_format_{};
+            std::vector<std::shared_ptr<IWaveProcessor>> processors_{}; // keeps the parameter sources alive.
+            std::vector<FusedStage> stages_{};
+            std::vector<FusedOperation> operations_{};
+            processing::DitherState dither_{};
+            xtl::temp_memory_buffer buffer_{};
+            std::atomic_flag continuity_{};
+
+            // F32 samples are processed in destination_buffer if they fit there: the output is converted in place (S32).
+            static constexpr bool InPlace = sizeof(TOutput) >= sizeof(F32);
+
+        public:
+            explicit FusedProcessorImpl(std::vector<std::shared_ptr<IWaveProcessor>> processors)
+                : input_format_(processors.front()->GetInputFormat())
+                , output_format_(processors.back()->GetOutputFormat())
+                , processors_(std::move(processors))
+            {
+                for (auto& p : processors_)
+                {
+                    stages_.push_back(FusedStage{dynamic_cast<IFusableWaveProcessor*>(p.get()), {}, {}});
+                    stages_.back().ramp.Reset(stages_.back().processor->GetFusedOperation().biquad);
+                }
+
+                operations_.resize(stages_.size());
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return input_format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return output_format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {InPlace, input_format_ == output_format_, 0, static_cast<double>(sizeof(TOutput)) / sizeof(F32)}; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                if (!continuity_.test_and_set()) Reset();
+
+                // snapshots parameters once per block.
+                for (size_t i = 0; i < stages_.size(); i++)
+                {
+                    operations_[i] = stages_[i].processor->GetFusedOperation();
+                    if (operations_[i].type == FusedOperation::Type::Biquad)
+                        stages_[i].ramp.SetTarget(operations_[i].biquad);
+                }
+
+                const size_t channels = static_cast<size_t>(input_format_.ChannelCount());
+                const size_t max_frames = destination_buffer_length / output_format_.BlockAlign();
+
+                F32* src;
+                if constexpr (InPlace) src = static_cast<F32*>(destination_buffer);
+                else src = buffer_.get<F32>(max_frames * channels);
+
+                const size_t frames = read_source(context, src, max_frames * input_format_.BlockAlign()) / input_format_.BlockAlign();
+                const size_t tile_frames = TileBytes / input_format_.BlockAlign() > 0 ? TileBytes / input_format_.BlockAlign() : 1;
+
+                for (size_t offset = 0; offset < frames; offset += tile_frames)
+                {
+                    const size_t n = frames - offset < tile_frames ? frames - offset : tile_frames;
+                    F32* tile = src + offset * channels;
+
+                    for (size_t i = 0; i < stages_.size(); i++)
+                    {
+                        const FusedOperation& op = operations_[i];
+                        switch (op.type)
+                        {
+                        case FusedOperation::Type::HardLimit:
+                            processing::ProcessHardLimit(tile, tile, n * channels, op.hard_limit.PreAmpMultiplier, op.hard_limit.LimiterAbs);
+                            break;
+
+                        case FusedOperation::Type::Biquad:
+                            rbj_audio_eq::ProcessRamped(tile, channels, n, stages_[i].ramp, stages_[i].biquad);
+                            break;
+
+                        case FusedOperation::Type::ConvertBitDepth:
+                            if constexpr (!std::is_same_v<TOutput, F32>)
+                                ConvertTile(static_cast<TOutput*>(destination_buffer) + offset * channels, tile, n * channels, channels, op.bit_depth);
+                            break;
+                        }
+                    }
+                }
+
+                return frames * output_format_.BlockAlign();
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                if constexpr (!InPlace)
+                    buffer_.reserve<F32>(max_output_frames * static_cast<size_t>(input_format_.ChannelCount()));
+                return max_output_frames;
+            }
+
+        private:
+            void ConvertTile(TOutput* dst, const F32* src, size_t count, size_t channels, const BitDepthConverterOptions& options) noexcept
+            {
+                if constexpr (std::is_same_v<TOutput, S16> || std::is_same_v<TOutput, S24>)
+                {
+                    if (options.dither)
+                    {
+                        dither_.shaping[0] = options.noise_shaping == NoiseShaping::FirstOrder ? 1.0f : options.noise_shaping == NoiseShaping::SecondOrder ? 2.0f : 0.0f;
+                        dither_.shaping[1] = options.noise_shaping == NoiseShaping::SecondOrder ? -1.0f : 0.0f;
+                        return processing::ConvertCopyDithered(dst, src, count, channels, dither_);
+                    }
+                }
+
+                processing::ConvertCopy(dst, src, count);
+            }
+
+            void Reset()
+            {
+                for (auto& s : stages_)
+                {
+                    s.biquad = {};
+                    s.ramp.Reset(s.ramp.to);
+                }
+                for (auto& e : dither_.error) e[0] = e[1] = 0.0f;
+                dither_.channel = 0;
+            }
+        };
+
+        /// Runs planar processors on each tile of the block: deinterleaved once before the first stage and interleaved once after the last one.
+        class PlanarProcessorRunImpl final : public IWaveProcessor
+        {
+            PcmWaveFormat format_{};
+            std::vector<std::shared_ptr<IWaveProcessor>> processors_{};
+            std::vector<IPlanarWaveProcessor*> stages_{};
+            size_t tile_frames_{};
+            xtl::temp_memory_buffer buffer_{};
+            std::vector<F32*> channels_{};
+
+        public:
+            explicit PlanarProcessorRunImpl(std::vector<std::shared_ptr<IWaveProcessor>> processors)
+                : format_(processors.front()->GetInputFormat())
+                , processors_(std::move(processors))
+                , tile_frames_(TileBytes / format_.BlockAlign() > 0 ? TileBytes / format_.BlockAlign() : 1)
+                , channels_(static_cast<size_t>(format_.ChannelCount()))
+            {
+                for (auto& p : processors_)
+                    stages_.push_back(dynamic_cast<IPlanarWaveProcessor*>(p.get()));
+
+                // one tile, allocated once.
+                const size_t stride = PlanarBlock::StrideFor(tile_frames_);
+                F32* data = buffer_.get<F32>(stride * channels_.size());
+                for (size_t c = 0; c < channels_.size(); c++)
+                    channels_[c] = data + c * stride;
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override
+            {
+                WaveProcessorCapabilities caps{false, true, 0, 1.0};
+                for (auto& p : processors_) caps.latency_frames += p->GetCapabilities().latency_frames;
+                return caps;
+            }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                const size_t block_align = static_cast<size_t>(format_.BlockAlign());
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+                const size_t frames = bytes / block_align;
+                const size_t channels = channels_.size();
+
+                PlanarBlock block{};
+                block.data = channels_[0];
+                block.stride = PlanarBlock::StrideFor(tile_frames_);
+                block.channels = channels;
+
+                auto* buf = static_cast<F32*>(destination_buffer);
+                for (size_t offset = 0; offset < frames; offset += tile_frames_)
+                {
+                    block.frames = frames - offset < tile_frames_ ? frames - offset : tile_frames_;
+                    processing::DeinterleaveCopy(channels_.data(), buf + offset * channels, channels, block.frames);
+                    for (IPlanarWaveProcessor* stage : stages_)
+                        stage->ProcessPlanar(block);
+                    processing::InterleaveCopy(buf + offset * channels, channels_.data(), channels, block.frames);
+                }
+
+                return frames * block_align;
+            }
+
+            void Discontinuity() override
+            {
+                for (auto& p : processors_) p->Discontinuity();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                // stages see a tile at most.
+                for (auto& p : processors_) p->Prepare(std::min(max_output_frames, tile_frames_));
+                return max_output_frames;
+            }
+        };
+
+        // Gets whether the processor can run on planar blocks: IPlanarWaveProcessor of the same F32 format.
+        bool IsPlanar(const std::shared_ptr<IWaveProcessor>& processor)
+        {
+            const PcmWaveFormat in = processor->GetInputFormat();
+            return dynamic_cast<IPlanarWaveProcessor*>(processor.get()) && in.SampleType() == SampleType::F32 && in == processor->GetOutputFormat();
+        }
+
+        // Gets whether the processor can be fused: F32 input and a known operation.
+        bool IsFusable(const std::shared_ptr<IWaveProcessor>& processor, bool* ends_fused_stages)
+        {
+            auto* fusable = dynamic_cast<IFusableWaveProcessor*>(processor.get());
+            const PcmWaveFormat in = processor->GetInputFormat();
+            const PcmWaveFormat out = processor->GetOutputFormat();
+            if (!fusable || in.SampleType() != SampleType::F32 || in.ChannelMask() != out.ChannelMask() || in.SamplingFrequency() != out.SamplingFrequency())
+                return false;
+
+            switch (fusable->GetFusedOperation().type)
+            {
+            case FusedOperation::Type::HardLimit: return *ends_fused_stages = false, out.SampleType() == SampleType::F32;
+            case FusedOperation::Type::Biquad: return *ends_fused_stages = false, out.SampleType() == SampleType::F32 && in.ChannelCount() <= 8;
+            case FusedOperation::Type::ConvertBitDepth: return *ends_fused_stages = true, true;
+            default: return false;
+            }
+        }
+
+        std::shared_ptr<IWaveProcessor> CreateFusedProcessor(std::vector<std::shared_ptr<IWaveProcessor>> stages)
+        {
+            switch (stages.back()->GetOutputFormat().SampleType())
+            {
+            case SampleType::S16: return std::make_shared<FusedProcessorImpl<S16>>(std::move(stages));
+            case SampleType::S24: return std::make_shared<FusedProcessorImpl<S24>>(std::move(stages));
+            case SampleType::S32: return std::make_shared<FusedProcessorImpl<S32>>(std::move(stages));
+            case SampleType::F32: return std::make_shared<FusedProcessorImpl<F32>>(std::move(stages));
+            default: throw std::invalid_argument("not supported format!");
+            }
+        }
+    }
+
+    std::shared_ptr<IWaveProcessor> CreateFusedProcessorChain(
+        std::vector<std::shared_ptr<IWaveProcessor>> processors)
+    {
+        if (processors.empty())
+            throw std::invalid_argument("no processors.");
+
+        for (size_t i = 1; i < processors.size(); i++)
+            if (processors[i - 1]->GetOutputFormat() != processors[i]->GetInputFormat())
+                throw std::logic_error("The processor output format and the next processor input format isn't match.");
+
+        std::vector<std::shared_ptr<IWaveProcessor>> chain;
+        std::vector<std::shared_ptr<IWaveProcessor>> run;
+        std::vector<std::shared_ptr<IWaveProcessor>> planar_run;
+
+        auto flush = [&]
+        {
+            // a single stage gains nothing from fusing.
+            if (run.size() >= 2) chain.push_back(CreateFusedProcessor(std::move(run)));
+            else if (run.size() == 1) chain.push_back(std::move(run.front()));
+            run.clear();
+        };
+
+        auto flush_planar = [&]
+        {
+            // a single stage processes the interleaved block itself rather than paying for the conversion.
+            if (planar_run.size() >= 2) chain.push_back(std::make_shared<PlanarProcessorRunImpl>(std::move(planar_run)));
+            else if (planar_run.size() == 1) chain.push_back(std::move(planar_run.front()));
+            planar_run.clear();
+        };
+
+        for (auto& p : processors)
+        {
+            bool ends = false;
+            if (IsFusable(p, &ends))
+            {
+                flush_planar();
+                run.push_back(std::move(p));
+                if (ends) flush();
+            }
+            else if (IsPlanar(p))
+            {
+                flush();
+                planar_run.push_back(std::move(p));
+            }
+            else
+            {
+                flush();
+                flush_planar();
+                chain.push_back(std::move(p));
+            }
+        }
+        flush();
+        flush_planar();
+
+        std::shared_ptr<IWaveProcessor> result = chain.front();
+        for (size_t i = 1; i < chain.size(); i++)
+            result = CreateProcessorChain(std::move(result), std::move(chain[i]));
+        return result;
+    }
+}
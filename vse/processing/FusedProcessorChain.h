@@ -0,0 +1,55 @@
+/// @file
+/// @brief  Vse - Fused Processor Chain
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+#include "./HardLimiter.h"
+#include "./RbjAudioEqProcessor.h"
+#include "./WaveFormatConverter.h"
+
+namespace vse
+{
+    /// Fixed-function operation of a fusable processor.
+    struct FusedOperation
+    {
+        enum struct Type
+        {
+            HardLimit,       ///< y = clamp(x * PreAmpMultiplier, -LimiterAbs, +LimiterAbs)
+            Biquad,          ///< biquad IIR filter on each channel (up to 8 channels)
+            ConvertBitDepth, ///< converts F32 to the output sample type. ends fused stages.
+        };
+
+        Type type{};
+        HardLimiterParameters hard_limit{};
+        rbj_audio_eq::Coefficients biquad{};
+        BitDepthConverterOptions bit_depth{};
+    };
+
+    /// Implemented by processors which can run as a stage of fused processor chain.
+    class IFusableWaveProcessor : protected virtual Interface
+    {
+    public:
+        /// Gets the operation with the current parameters. Called once per Process of the fused chain.
+        [[nodiscard]] virtual FusedOperation GetFusedOperation() const = 0;
+    };
+
+    /// Creates a processor which processes with `processors` in order.
+    /// Consecutive F32 stages of HardLimiter, biquad filter and a bit-depth converter tail
+    /// are fused into one processor, which runs all of them on each cache-resident tile of the block in turn
+    /// instead of making a pass over the whole block for each stage. Other processors are chained as they are.
+    /// The fused stages keep their own filter/dither state; parameters are read from the original processors.
+    /// Consecutive processors implementing IPlanarWaveProcessor run on planar tiles instead:
+    /// each tile is deinterleaved before the first of them and interleaved after the last one.
+    /// A lone planar processor gains nothing from it, and runs by Process as usual.
+    /// @throw std::invalid_argument `processors` is empty.
+    /// @throw std::logic_error The output format of a processor and the input format of the next one isn't match.
+    [[nodiscard]] std::shared_ptr<IWaveProcessor> CreateFusedProcessorChain(
+        std::vector<std::shared_ptr<IWaveProcessor>> processors);
+}
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <stdexcept>
 
+#include "./FusedProcessorChain.h"
 #include "./WaveformProcessing.h"
 
 namespace vse
@@ -16,7 +17,7 @@ namespace vse
     namespace
     {
         template <class TSample>
-        class HardLimitImpl final : public virtual IHardLimiter
+        class HardLimitImpl final : public virtual IHardLimiter, public IFusableWaveProcessor
         {
             PcmWaveFormat format_;
             std::atomic<HardLimiterParameters> params_;
@@ -26,6 +27,7 @@ namespace vse
 
             [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
             [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
 
             [[nodiscard]] size_t Process(size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context, void* destination_buffer, size_t destination_buffer_length) override
             {
@@ -40,6 +42,14 @@ namespace vse
 
             [[nodiscard]] HardLimiterParameters GetParameters() const override { return params_.load(std::memory_order_acquire); }
             void SetParameters(HardLimiterParameters parameters) override { params_.store(parameters, std::memory_order_release); }
+
+            [[nodiscard]] FusedOperation GetFusedOperation() const override
+            {
+                FusedOperation op{};
+                op.type = FusedOperation::Type::HardLimit;
+                op.hard_limit = GetParameters();
+                return op;
+            }
         };
     }
 
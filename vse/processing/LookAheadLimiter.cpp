@@ -0,0 +1,282 @@
+/// @file
+/// @brief  Vse - Look-ahead Limiter
+/// @author (C) 2022 ttsuki
+
+#include "LookAheadLimiter.h"
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        // 4x oversampling interpolator for true-peak detection.
+        // output for the frame i estimates the signal on [i - TruePeakDelay, i - TruePeakDelay + 1).
+        constexpr size_t TruePeakPhases = 4;
+        constexpr size_t TruePeakTaps = 16;
+        constexpr size_t TruePeakDelay = TruePeakTaps / 2;
+
+        class LookAheadLimiterImpl final : public ILookAheadLimiter
+        {
+            PcmWaveFormat format_;
+            std::atomic<LookAheadLimiterParameters> params_;
+            std::atomic_flag continuity_{};
+
+            const size_t channels_;
+            const size_t window_;  // look-ahead frames + 1
+            const size_t latency_; // frames
+            const bool true_peak_;
+
+            // delay line
+            std::vector<F32> delay_{};
+            size_t delay_position_{};
+
+            // gain computer: sliding minimum of the required gain over the window, then moving average over the window.
+            // the average at frame n is not greater than the required gain at frame n - (window - 1).
+            std::vector<float> queue_gain_{};  // monotonic deque (ring)
+            std::vector<size_t> queue_frame_{};
+            size_t queue_head_{};
+            size_t queue_size_{};
+            std::vector<float> average_{}; // ring
+            size_t average_position_{};
+            double average_sum_{};
+            float gain_{};
+            size_t frame_{};
+
+            // true-peak
+            F32 true_peak_coefficients_[TruePeakPhases * TruePeakTaps]{};
+            std::vector<F32> true_peak_history_{};
+
+            xtl::temp_memory_buffer input_buffer_{};
+            xtl::temp_memory_buffer peaks_buffer_{};
+            xtl::temp_memory_buffer channel_peaks_buffer_{};
+            xtl::temp_memory_buffer gains_buffer_{};
+            xtl::temp_memory_buffer planar_buffer_{};
+            xtl::temp_memory_buffer oversampled_buffer_{};
+
+        public:
+            LookAheadLimiterImpl(PcmWaveFormat format, LookAheadLimiterParameters params, size_t look_ahead_frames, bool true_peak)
+                : format_(format)
+                , params_(params)
+                , channels_(static_cast<size_t>(format.ChannelCount()))
+                , window_(look_ahead_frames + 1)
+                , latency_(look_ahead_frames + (true_peak ? TruePeakDelay : 0))
+                , true_peak_(true_peak)
+                , delay_(latency_ * channels_)
+                , queue_gain_(window_)
+                , queue_frame_(window_)
+                , average_(window_)
+                , true_peak_history_(true_peak ? (TruePeakTaps - 1) * channels_ : 0)
+            {
+                if (true_peak_) BuildTruePeakFilter();
+                Reset();
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, latency_, 1.0}; }
+            [[nodiscard]] size_t GetLatency() const override { return latency_; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                if (!continuity_.test_and_set()) Reset();
+
+                const int block_align = format_.BlockAlign();
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+                const size_t frames = bytes / block_align;
+                if (frames == 0) return bytes;
+
+                const LookAheadLimiterParameters params = GetParameters();
+                auto* buf = static_cast<F32*>(destination_buffer);
+
+                float* peaks = peaks_buffer_.get<float>(frames);
+                if (true_peak_) ComputeTruePeaks(peaks, buf, frames);
+                else processing::ComputeFramePeaks(peaks, buf, channels_, frames);
+
+                float* gains = gains_buffer_.get<float>(frames);
+                ComputeGains(gains, peaks, frames, params);
+
+                F32* input = input_buffer_.get<F32>(frames * channels_);
+                std::memcpy(input, buf, frames * channels_ * sizeof(F32));
+                Delay(buf, input, frames);
+
+                processing::ApplyFrameGain(buf, buf, gains, channels_, frames, params.Ceiling);
+                return bytes;
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                peaks_buffer_.reserve<float>(max_output_frames);
+                gains_buffer_.reserve<float>(max_output_frames);
+                input_buffer_.reserve<F32>(max_output_frames * channels_);
+                if (true_peak_)
+                {
+                    channel_peaks_buffer_.reserve<float>(max_output_frames);
+                    planar_buffer_.reserve<F32>(TruePeakTaps - 1 + max_output_frames);
+                    oversampled_buffer_.reserve<F32>(max_output_frames * TruePeakPhases);
+                }
+                return max_output_frames;
+            }
+
+            [[nodiscard]] LookAheadLimiterParameters GetParameters() const override { return params_.load(std::memory_order_acquire); }
+            void SetParameters(LookAheadLimiterParameters parameters) override { params_.store(parameters, std::memory_order_release); }
+
+        private:
+            void BuildTruePeakFilter()
+            {
+                // hann-windowed sinc, pass band up to 90% of the source nyquist.
+                const double pi = 3.14159265358979323846;
+                const double cutoff = 0.45; // cycles per source sample
+                const double half_width = static_cast<double>(TruePeakTaps / 2);
+                for (size_t p = 0; p < TruePeakPhases; p++)
+                {
+                    F32* c = &true_peak_coefficients_[p * TruePeakTaps];
+                    double sum = 0.0;
+                    for (size_t m = 0; m < TruePeakTaps; m++)
+                    {
+                        // m-th coefficient multiplies the source sample at distance u from the output position.
+                        const double u = static_cast<double>(m) - (half_width - 1.0) - static_cast<double>(p) / TruePeakPhases;
+                        const double window = std::abs(u) < half_width ? 0.5 + 0.5 * std::cos(pi * u / half_width) : 0.0;
+                        const double sinc = u == 0.0 ? 1.0 : std::sin(2.0 * pi * cutoff * u) / (2.0 * pi * cutoff * u);
+                        c[m] = static_cast<F32>(sinc * window);
+                        sum += sinc * window;
+                    }
+
+                    for (size_t m = 0; m < TruePeakTaps; m++)
+                        c[m] = static_cast<F32>(c[m] / sum);
+                }
+            }
+
+            void ComputeTruePeaks(float* peaks, const F32* src, size_t frames)
+            {
+                constexpr size_t history = TruePeakTaps - 1;
+                float* channel_peaks = channel_peaks_buffer_.get<float>(frames);
+                F32* planar = planar_buffer_.get<F32>(history + frames);
+                F32* oversampled = oversampled_buffer_.get<F32>(frames * TruePeakPhases);
+
+                for (size_t c = 0; c < channels_; c++)
+                {
+                    F32* h = &true_peak_history_[c * history];
+                    std::memcpy(planar, h, history * sizeof(F32));
+                    for (size_t i = 0; i < frames; i++) planar[history + i] = src[i * channels_ + c];
+                    std::memcpy(h, planar + frames, history * sizeof(F32));
+
+                    size_t index = 0, phase = 0;
+                    processing::ResamplePolyphase(oversampled, 1, planar, true_peak_coefficients_, TruePeakTaps, TruePeakPhases, 1, index, phase, frames * TruePeakPhases);
+                    processing::ComputeFramePeaks(c == 0 ? peaks : channel_peaks, oversampled, TruePeakPhases, frames);
+
+                    if (c != 0)
+                        for (size_t i = 0; i < frames; i++)
+                            peaks[i] = std::max(peaks[i], channel_peaks[i]);
+                }
+            }
+
+            void ComputeGains(float* gains, const float* peaks, size_t frames, const LookAheadLimiterParameters& params)
+            {
+                const float multiplier = params.PreAmpMultiplier;
+                const float ceiling = params.Ceiling;
+                const double release_frames = static_cast<double>(params.ReleaseMilliseconds) * format_.SamplingFrequency() / 1000.0;
+                const float release = release_frames > 1.0 ? static_cast<float>(1.0 - std::exp(-1.0 / release_frames)) : 1.0f;
+
+                const size_t window = window_;
+                for (size_t i = 0; i < frames; i++, frame_++)
+                {
+                    const float peak = peaks[i] * multiplier;
+                    const float required = peak > ceiling ? ceiling / peak : 1.0f;
+
+                    // sliding minimum
+                    if (queue_size_ && queue_frame_[queue_head_] + window <= frame_)
+                        queue_head_ = (queue_head_ + 1) % window, queue_size_--;
+                    while (queue_size_ && queue_gain_[(queue_head_ + queue_size_ - 1) % window] >= required)
+                        queue_size_--;
+                    queue_gain_[(queue_head_ + queue_size_) % window] = required;
+                    queue_frame_[(queue_head_ + queue_size_) % window] = frame_;
+                    queue_size_++;
+                    const float minimum = queue_gain_[queue_head_];
+
+                    // moving average: attack ramps over the look-ahead time.
+                    average_sum_ += static_cast<double>(minimum) - average_[average_position_];
+                    average_[average_position_] = minimum;
+                    average_position_ = average_position_ + 1 < window ? average_position_ + 1 : 0;
+                    const float target = static_cast<float>(average_sum_ / static_cast<double>(window));
+
+                    // release
+                    gain_ = target < gain_ ? target : gain_ + (target - gain_) * release;
+                    gains[i] = gain_ * multiplier;
+                }
+            }
+
+            void Delay(F32* dst, const F32* src, size_t frames)
+            {
+                const size_t c = channels_;
+                const size_t length = latency_;
+
+                // the oldest frames come out from the delay line first.
+                const size_t head = std::min(frames, length);
+                const size_t head_1 = std::min(head, length - delay_position_);
+                std::memcpy(dst, &delay_[delay_position_ * c], head_1 * c * sizeof(F32));
+                std::memcpy(dst + head_1 * c, &delay_[0], (head - head_1) * c * sizeof(F32));
+                if (frames > length) std::memcpy(dst + length * c, src, (frames - length) * c * sizeof(F32));
+
+                // the newest frames go in.
+                if (frames >= length)
+                {
+                    std::memcpy(&delay_[0], src + (frames - length) * c, length * c * sizeof(F32));
+                    delay_position_ = 0;
+                }
+                else
+                {
+                    const size_t tail_1 = std::min(frames, length - delay_position_);
+                    std::memcpy(&delay_[delay_position_ * c], src, tail_1 * c * sizeof(F32));
+                    std::memcpy(&delay_[0], src + tail_1 * c, (frames - tail_1) * c * sizeof(F32));
+                    delay_position_ = (delay_position_ + frames) % length;
+                }
+            }
+
+            void Reset()
+            {
+                std::fill(delay_.begin(), delay_.end(), 0.0f);
+                std::fill(true_peak_history_.begin(), true_peak_history_.end(), 0.0f);
+                std::fill(average_.begin(), average_.end(), 1.0f);
+                delay_position_ = 0;
+                queue_head_ = 0;
+                queue_size_ = 0;
+                average_position_ = 0;
+                average_sum_ = static_cast<double>(window_);
+                gain_ = 1.0f;
+            }
+        };
+    }
+
+    std::shared_ptr<ILookAheadLimiter> CreateLookAheadLimiter(PcmWaveFormat format, LookAheadLimiterParameters initialParameters, LookAheadLimiterOptions options)
+    {
+        if (format.SampleType() != SampleType::F32)
+            throw std::invalid_argument("not supported.");
+
+        if (!(options.look_ahead_milliseconds >= 0.0f && options.look_ahead_milliseconds <= 1000.0f))
+            throw std::invalid_argument("look_ahead_milliseconds");
+
+        const double frames = std::ceil(static_cast<double>(options.look_ahead_milliseconds) * format.SamplingFrequency() / 1000.0);
+        const size_t look_ahead_frames = std::max<size_t>(static_cast<size_t>(frames), 1);
+        return std::make_shared<LookAheadLimiterImpl>(format, initialParameters, look_ahead_frames, options.true_peak);
+    }
+}
@@ -0,0 +1,46 @@
+/// @file
+/// @brief  Vse - Look-ahead Limiter
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    struct LookAheadLimiterParameters
+    {
+        float PreAmpMultiplier = 1.0f;
+        float Ceiling = 0.999f;            ///< output peak limit (abs)
+        float ReleaseMilliseconds = 80.0f; ///< time constant of gain recovery
+    };
+
+    struct LookAheadLimiterOptions
+    {
+        float look_ahead_milliseconds = 1.5f; ///< attack time. the output is delayed by this.
+        bool true_peak = false;               ///< detects peaks between samples on 4x oversampled signal (adds 8 frames of latency).
+    };
+
+    class ILookAheadLimiter : public IParametricWaveProcessor<LookAheadLimiterParameters>
+    {
+    public:
+        /// Gets the delay of the output from the input in frames.
+        [[nodiscard]] virtual size_t GetLatency() const = 0;
+    };
+
+    /// Creates brickwall limiter.
+    /// The gain falls smoothly over the look-ahead time before a peak arrives, so that the output doesn't exceed Ceiling,
+    /// and recovers with ReleaseMilliseconds. Samples still over Ceiling (e.g. by rounding) are clipped.
+    /// @param format source/destination format. F32 only.
+    /// @param initialParameters parameters
+    /// @param options look-ahead time and peak detection
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<ILookAheadLimiter> CreateLookAheadLimiter(
+        PcmWaveFormat format,
+        LookAheadLimiterParameters initialParameters = LookAheadLimiterParameters{},
+        LookAheadLimiterOptions options = LookAheadLimiterOptions{});
+}
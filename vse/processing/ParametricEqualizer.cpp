@@ -0,0 +1,266 @@
+/// @file
+/// @brief  Vse - Parametric Equalizer
+/// @author (C) 2022 ttsuki
+
+#include "ParametricEqualizer.h"
+
+#include <cstddef>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_spin_lock_mutex.h"
+
+#include "./RbjAudioEqProcessor.h"
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        bool GetBandCoefficients(const ParametricEqualizerBand& band, float sampling_frequency, rbj_audio_eq::Coefficients& coefficients)
+        {
+            using namespace rbj_audio_eq;
+            using T = ParametricEqualizerBand::FilterType;
+
+            if (band.Type == T::Bypass || !(band.Frequency > 0.0f && band.Frequency < sampling_frequency / 2) || !(band.Q > 0.0f))
+                return false;
+
+            const float w = w0(band.Frequency, sampling_frequency);
+            const float alpha = alphaQ(band.Q, w);
+
+            Coefficients c{};
+            switch (band.Type)
+            {
+            case T::Peaking: c = PeakingEqFilterCoefficients(w, alpha, A(band.GainDb)); break;
+            case T::LowShelf: c = LowShelfFilterCoefficients(w, alpha, A(band.GainDb)); break;
+            case T::HighShelf: c = HighShelfFilterCoefficients(w, alpha, A(band.GainDb)); break;
+            case T::LowPass: c = LowPassFilterCoefficients(w, alpha); break;
+            case T::HighPass: c = HighPassFilterCoefficients(w, alpha); break;
+            case T::BandPass: c = BandPassFilterCoefficients_Constant0dBPeakGain(w, alpha); break;
+            case T::Notch: c = NotchFilterCoefficients(w, alpha); break;
+            default: return false;
+            }
+
+            coefficients = c;
+            return true;
+        }
+
+        class ParametricEqualizerImpl final : public IParametricEqualizer
+        {
+            static constexpr size_t MaxBands = ParametricEqualizerParameters::MaxBands;
+            static constexpr rbj_audio_eq::Coefficients Identity{1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+            PcmWaveFormat format_{};
+
+            // seqlock: the render thread reads without locking; odd version means writing.
+            struct AtomicBand
+            {
+                std::atomic<int> type{};
+                std::atomic<float> frequency{};
+                std::atomic<float> gain_db{};
+                std::atomic<float> q{};
+            };
+
+            xtl::spin_lock_mutex writer_mutex_{};
+            std::atomic<uint32_t> version_{};
+            AtomicBand bands_[MaxBands]{};
+            std::atomic_flag continuity_{};
+
+            // render thread: each band glides to its target. a bypassed band fades to identity, then leaves the cascade.
+            uint32_t version_seen_{};
+            rbj_audio_eq::CoefficientRamp ramps_[MaxBands]{};
+            bool active_[MaxBands]{};
+            bool bypassing_[MaxBands]{};
+            processing::BiquadState band_states_[MaxBands]{};
+
+            // render thread: active bands packed in band order.
+            size_t stage_count_{};
+            float coefficients_[MaxBands][5]{};
+            size_t stage_band_[MaxBands]{};
+            processing::BiquadState stage_states_[MaxBands]{};
+
+        public:
+            ParametricEqualizerImpl(PcmWaveFormat format, const ParametricEqualizerParameters& params)
+                : format_(format)
+            {
+                SetParameters(params);
+                version_seen_ = version_.load(std::memory_order_relaxed);
+                UpdateTargets(params);
+                SnapRamps();
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                const int block_align = format_.BlockAlign();
+                const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
+
+                const uint32_t version = version_.load(std::memory_order_acquire);
+                if (version != version_seen_)
+                {
+                    version_seen_ = version;
+                    UpdateTargets(GetParameters());
+                }
+
+                // a new stream doesn't need to glide.
+                if (!continuity_.test_and_set())
+                {
+                    for (auto& s : band_states_) s = {};
+                    SnapRamps();
+                }
+
+                auto* buf = static_cast<F32*>(destination_buffer);
+                const size_t frames = bytes / block_align;
+                const size_t channels = static_cast<size_t>(format_.ChannelCount());
+
+                stage_count_ = 0;
+                bool ramping = false;
+                for (size_t b = 0; b < MaxBands; b++)
+                {
+                    if (!active_[b]) continue;
+                    ramping |= ramps_[b].IsRamping();
+                    stage_states_[stage_count_] = band_states_[b];
+                    stage_band_[stage_count_++] = b;
+                }
+
+                // sub-blocks of SubBlockFrames while ramping, the rest at once (same as rbj_audio_eq::ProcessRamped).
+                for (size_t offset = 0; offset < frames;)
+                {
+                    const size_t n = ramping && frames - offset > rbj_audio_eq::CoefficientRamp::SubBlockFrames ? rbj_audio_eq::CoefficientRamp::SubBlockFrames : frames - offset;
+
+                    ramping = false;
+                    for (size_t k = 0; k < stage_count_; k++)
+                    {
+                        auto& ramp = ramps_[stage_band_[k]];
+                        const rbj_audio_eq::Coefficients& c = ramp.Next();
+                        ramping |= ramp.IsRamping();
+                        coefficients_[k][0] = c.b0a0;
+                        coefficients_[k][1] = c.b1a0;
+                        coefficients_[k][2] = c.b2a0;
+                        coefficients_[k][3] = c.a1a0;
+                        coefficients_[k][4] = c.a2a0;
+                    }
+
+                    F32* p = buf + offset * channels;
+                    processing::ProcessBiquadCascade(p, p, channels, n, coefficients_, stage_states_, stage_count_);
+                    offset += n;
+                }
+
+                for (size_t k = 0; k < stage_count_; k++)
+                {
+                    const size_t b = stage_band_[k];
+                    band_states_[b] = stage_states_[k];
+
+                    // a bypassed band which reached identity restarts from silence.
+                    if (bypassing_[b] && !ramps_[b].IsRamping())
+                    {
+                        active_[b] = false;
+                        band_states_[b] = {};
+                    }
+                }
+
+                return bytes;
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            [[nodiscard]] ParametricEqualizerParameters GetParameters() const override
+            {
+                for (;;)
+                {
+                    const uint32_t version = version_.load(std::memory_order_acquire);
+                    if (version & 1) continue;
+
+                    ParametricEqualizerParameters params{};
+                    for (size_t b = 0; b < MaxBands; b++)
+                    {
+                        params.Bands[b].Type = static_cast<ParametricEqualizerBand::FilterType>(bands_[b].type.load(std::memory_order_relaxed));
+                        params.Bands[b].Frequency = bands_[b].frequency.load(std::memory_order_relaxed);
+                        params.Bands[b].GainDb = bands_[b].gain_db.load(std::memory_order_relaxed);
+                        params.Bands[b].Q = bands_[b].q.load(std::memory_order_relaxed);
+                    }
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (version_.load(std::memory_order_relaxed) == version)
+                        return params;
+                }
+            }
+
+            void SetParameters(ParametricEqualizerParameters parameters) override
+            {
+                xtl::lock_guard lock(writer_mutex_);
+                const uint32_t version = version_.load(std::memory_order_relaxed);
+                version_.store(version + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (size_t b = 0; b < MaxBands; b++)
+                {
+                    bands_[b].type.store(static_cast<int>(parameters.Bands[b].Type), std::memory_order_relaxed);
+                    bands_[b].frequency.store(parameters.Bands[b].Frequency, std::memory_order_relaxed);
+                    bands_[b].gain_db.store(parameters.Bands[b].GainDb, std::memory_order_relaxed);
+                    bands_[b].q.store(parameters.Bands[b].Q, std::memory_order_relaxed);
+                }
+                version_.store(version + 2, std::memory_order_release);
+            }
+
+        private:
+            // recomputes target coefficients of the bands on the render thread.
+            void UpdateTargets(const ParametricEqualizerParameters& params)
+            {
+                const float fs = static_cast<float>(format_.SamplingFrequency());
+                for (size_t b = 0; b < MaxBands; b++)
+                {
+                    rbj_audio_eq::Coefficients c{};
+                    bypassing_[b] = !GetBandCoefficients(params.Bands[b], fs, c);
+                    if (bypassing_[b])
+                    {
+                        if (active_[b]) ramps_[b].SetTarget(Identity);
+                        continue;
+                    }
+
+                    // a band entering the cascade fades in from identity.
+                    if (!active_[b])
+                    {
+                        active_[b] = true;
+                        ramps_[b].Reset(Identity);
+                        band_states_[b] = {};
+                    }
+                    ramps_[b].SetTarget(c);
+                }
+            }
+
+            // jumps to the targets.
+            void SnapRamps()
+            {
+                for (size_t b = 0; b < MaxBands; b++)
+                {
+                    ramps_[b].Reset(ramps_[b].to);
+                    if (bypassing_[b])
+                    {
+                        active_[b] = false;
+                        band_states_[b] = {};
+                    }
+                }
+            }
+        };
+    }
+
+    std::shared_ptr<IParametricEqualizer> CreateParametricEqualizer(PcmWaveFormat format, ParametricEqualizerParameters initialParameters)
+    {
+        if (format.SampleType() != SampleType::F32 || format.ChannelCount() <= 0 || static_cast<size_t>(format.ChannelCount()) > processing::BiquadState::MaxChannels)
+            throw std::invalid_argument("not supported.");
+
+        return std::make_shared<ParametricEqualizerImpl>(format, initialParameters);
+    }
+}
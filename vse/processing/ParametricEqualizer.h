@@ -0,0 +1,53 @@
+/// @file
+/// @brief  Vse - Parametric Equalizer
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <array>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    struct ParametricEqualizerBand
+    {
+        enum struct FilterType
+        {
+            Bypass = 0,
+            Peaking,
+            LowShelf,
+            HighShelf,
+            LowPass,
+            HighPass,
+            BandPass, ///< constant 0dB peak gain
+            Notch,
+        };
+
+        FilterType Type = FilterType::Bypass;
+        float Frequency = 1000.0f; ///< center or corner frequency in Hz
+        float GainDb = 0.0f;       ///< gain of Peaking, LowShelf and HighShelf
+        float Q = 0.70710678f;
+    };
+
+    struct ParametricEqualizerParameters
+    {
+        static constexpr size_t MaxBands = 16;
+        std::array<ParametricEqualizerBand, MaxBands> Bands{};
+    };
+
+    using IParametricEqualizer = IParametricWaveProcessor<ParametricEqualizerParameters>;
+
+    /// Creates multi-band parametric equalizer, a cascade of RBJ's Audio EQ Cookbook biquad filters.
+    /// All active bands run in one pass over each block.
+    /// Bands can be changed while playing. Each band glides to its new coefficients in a few hundred samples without resetting its state.
+    /// @param format source/destination format. F32, up to 8 channels.
+    /// @param initialParameters bands
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<IParametricEqualizer> CreateParametricEqualizer(
+        PcmWaveFormat format,
+        ParametricEqualizerParameters initialParameters = ParametricEqualizerParameters{});
+}
@@ -0,0 +1,365 @@
+/// @file
+/// @brief  Vse - Polyphase Resampler
+/// @author (C) 2022 ttsuki
+
+#include "PolyphaseResampler.h"
+
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../base/xtl/xtl_temp_memory_buffer.h"
+
+#include "./WaveformProcessing.h"
+
+namespace vse
+{
+    namespace
+    {
+        /// Polyphase decomposition of a windowed-sinc low-pass filter.
+        /// Output at source position (index + phase / phase_count) is dot(src[index - delay + 1 ...], coefficients[phase]).
+        struct PolyphaseFilterTable
+        {
+            size_t phase_count{}; // L: interpolation factor (reduced output rate)
+            size_t phase_step{};  // M: decimation factor (reduced input rate)
+            size_t taps{};        // per phase
+            size_t delay{};       // half of taps
+            std::vector<F32> coefficients{};
+        };
+
+        static constexpr size_t MaxPhaseCount = 4096;
+        static constexpr size_t MaxTaps = 1024;
+
+        double BesselI0(double x)
+        {
+            // power series: sum((x/2)^2k / (k!)^2)
+            double sum = 1.0;
+            double term = 1.0;
+            const double q = x * x / 4.0;
+            for (int k = 1; k < 64 && term > sum * 1e-12; k++)
+            {
+                term *= q / (static_cast<double>(k) * k);
+                sum += term;
+            }
+            return sum;
+        }
+
+        std::shared_ptr<const PolyphaseFilterTable> BuildFilterTable(size_t phase_count, size_t phase_step, int quality_level)
+        {
+            auto table = std::make_shared<PolyphaseFilterTable>();
+            table->phase_count = phase_count;
+            table->phase_step = phase_step;
+
+            if (quality_level <= 1)
+            {
+                // linear interpolation
+                table->taps = 2;
+                table->delay = 1;
+                table->coefficients.resize(phase_count * 2);
+                for (size_t p = 0; p < phase_count; p++)
+                {
+                    const double f = static_cast<double>(p) / static_cast<double>(phase_count);
+                    table->coefficients[p * 2 + 0] = static_cast<F32>(1.0 - f);
+                    table->coefficients[p * 2 + 1] = static_cast<F32>(f);
+                }
+                return table;
+            }
+
+            // quality 2..60 -> 16..128 taps, 80%..97% pass band, kaiser beta 5..10 (about 50..100dB stop band).
+            const double q = static_cast<double>(std::clamp(quality_level, 2, 60) - 2) / 58.0;
+            const size_t base_taps = (16 + static_cast<size_t>(q * 112.0) + 7) / 8 * 8;
+            const double pass_band = 0.80 + 0.17 * q;
+            const double beta = 5.0 + 5.0 * q;
+
+            // when decimating, the cut-off follows the output nyquist, so the filter stretches.
+            const size_t stretch = (phase_step + phase_count - 1) / phase_count;
+            const size_t taps = std::min(base_taps * std::max<size_t>(stretch, 1), MaxTaps);
+            const size_t delay = taps / 2;
+            const double cutoff = 0.5 * pass_band * std::min(1.0, static_cast<double>(phase_count) / static_cast<double>(phase_step)); // cycles per input sample
+
+            table->taps = taps;
+            table->delay = delay;
+            table->coefficients.resize(phase_count * taps);
+
+            const double pi = 3.14159265358979323846;
+            const double i0_beta = BesselI0(beta);
+            const double half_width = static_cast<double>(delay * phase_count);
+
+            for (size_t p = 0; p < phase_count; p++)
+            {
+                F32* c = &table->coefficients[p * taps];
+                double sum = 0.0;
+                for (size_t m = 0; m < taps; m++)
+                {
+                    // m-th coefficient multiplies src[index - delay + 1 + m],
+                    // whose distance from the output position is u (in 1/phase_count source samples).
+                    const double u = static_cast<double>(p) + (static_cast<double>(delay) - 1.0 - static_cast<double>(m)) * static_cast<double>(phase_count);
+                    const double x = u / static_cast<double>(phase_count);
+                    const double r = u / half_width;
+                    const double window = std::abs(r) < 1.0 ? BesselI0(beta * std::sqrt(1.0 - r * r)) / i0_beta : 0.0;
+                    const double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * pi * cutoff * x) / (2.0 * pi * cutoff * x);
+                    const double h = 2.0 * cutoff * sinc * window;
+                    c[m] = static_cast<F32>(h);
+                    sum += h;
+                }
+
+                // normalizes dc gain of each phase to unity.
+                for (size_t m = 0; m < taps; m++)
+                    c[m] = static_cast<F32>(c[m] / sum);
+            }
+
+            return table;
+        }
+
+        std::shared_ptr<const PolyphaseFilterTable> GetSharedFilterTable(size_t phase_count, size_t phase_step, int quality_level)
+        {
+            static std::mutex mutex;
+            static std::map<std::tuple<size_t, size_t, int>, std::weak_ptr<const PolyphaseFilterTable>> cache;
+
+            std::lock_guard lock(mutex);
+            auto& entry = cache[std::make_tuple(phase_count, phase_step, quality_level)];
+            if (auto table = entry.lock()) return table;
+
+            auto table = BuildFilterTable(phase_count, phase_step, quality_level);
+            entry = table;
+
+            // sweeps tables no longer used.
+            for (auto it = cache.begin(); it != cache.end();)
+                it = it->second.expired() ? cache.erase(it) : std::next(it);
+
+            return table;
+        }
+
+        template <class TInput, class TOutput>
+        class PolyphaseResamplerImpl final : public IWaveProcessor
+        {
+            PcmWaveFormat input_format_{};
+            PcmWaveFormat output_format_{};
+            std::shared_ptr<const PolyphaseFilterTable> table_{};
+            size_t channels_{};
+
+            // planar source history. history_[c][index_] is the first sample of the next output's window.
+            std::vector<std::vector<F32>> history_{};
+            size_t history_length_{};
+            size_t index_{};
+            size_t phase_{};
+            size_t index_limit_{}; // outputs at index >= index_limit_ are beyond the end of source.
+            bool end_of_source_{};
+            std::atomic_flag continuity_{};
+
+            xtl::temp_memory_buffer read_buffer_{};
+            xtl::temp_memory_buffer convert_buffer_{};
+            xtl::temp_memory_buffer output_buffer_{};
+
+        public:
+            PolyphaseResamplerImpl(const PcmWaveFormat& input_format, const PcmWaveFormat& output_format, std::shared_ptr<const PolyphaseFilterTable> table)
+                : input_format_(input_format)
+                , output_format_(output_format)
+                , table_(std::move(table))
+                , channels_(static_cast<size_t>(input_format.ChannelCount()))
+                , history_(channels_)
+            {
+                Reset();
+                continuity_.test_and_set();
+            }
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return input_format_; }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return output_format_; }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                if (!continuity_.test_and_set())
+                    Reset();
+
+                const size_t output_frames = destination_buffer_length / output_format_.BlockAlign();
+                F32* out = output_buffer_.get<F32>(output_frames * channels_);
+
+                size_t produced = 0;
+                while (produced < output_frames)
+                {
+                    const size_t available = std::min(CountAvailableOutputs(), output_frames - produced);
+                    if (available == 0)
+                    {
+                        if (end_of_source_) break;
+                        Fill(read_source, context, output_frames - produced);
+                        continue;
+                    }
+
+                    const PolyphaseFilterTable& t = *table_;
+                    size_t index = index_;
+                    size_t phase = phase_;
+                    for (size_t c = 0; c < channels_; c++)
+                    {
+                        index = index_;
+                        phase = phase_;
+                        processing::ResamplePolyphase(
+                            out + produced * channels_ + c, channels_,
+                            history_[c].data(), t.coefficients.data(), t.taps,
+                            t.phase_count, t.phase_step,
+                            index, phase, available);
+                    }
+
+                    index_ = index;
+                    phase_ = phase;
+                    produced += available;
+                }
+
+                processing::ConvertCopy(static_cast<TOutput*>(destination_buffer), out, produced * channels_);
+                return produced * output_format_.BlockAlign();
+            }
+
+            void Discontinuity() override
+            {
+                continuity_.clear();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                // the largest read in Fill, with phase_ < phase_count.
+                const PolyphaseFilterTable& t = *table_;
+                const size_t max_input_frames = (t.phase_count - 1 + max_output_frames * t.phase_step) / t.phase_count + t.taps + 1;
+
+                output_buffer_.reserve<F32>(max_output_frames * channels_);
+                read_buffer_.reserve<TInput>(max_input_frames * channels_);
+                if constexpr (!std::is_same_v<TInput, F32>) convert_buffer_.reserve<F32>(max_input_frames * channels_);
+                for (auto& h : history_) h.reserve(max_input_frames + t.taps);
+                return max_input_frames;
+            }
+
+        private:
+            void Reset()
+            {
+                // leading (delay - 1) zeros: the first output is aligned to the first source sample.
+                const size_t lead = table_->delay - 1;
+                for (auto& h : history_) h.assign(lead, 0.0f);
+                history_length_ = lead;
+                index_ = 0;
+                phase_ = 0;
+                index_limit_ = SIZE_MAX;
+                end_of_source_ = false;
+            }
+
+            [[nodiscard]] size_t CountAvailableOutputs() const
+            {
+                const PolyphaseFilterTable& t = *table_;
+                if (index_ >= index_limit_ || index_ + t.taps > history_length_) return 0;
+
+                // i-th output reads history from index_ + (phase_ + i * M) / L, up to taps samples.
+                const size_t last_index = std::min(history_length_ - t.taps, index_limit_ - 1);
+                return ((last_index - index_) * t.phase_count + (t.phase_count - 1) - phase_) / t.phase_step + 1;
+            }
+
+            void Fill(size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context, size_t output_frames)
+            {
+                const PolyphaseFilterTable& t = *table_;
+
+                // drops consumed samples.
+                if (index_ > 0)
+                {
+                    for (auto& h : history_) std::memmove(h.data(), h.data() + index_, (history_length_ - index_) * sizeof(F32));
+                    history_length_ -= index_;
+                    if (index_limit_ != SIZE_MAX) index_limit_ -= index_;
+                    index_ = 0;
+                }
+
+                // source frames to produce requested output frames.
+                const size_t needed = (phase_ + output_frames * t.phase_step) / t.phase_count + t.taps + 1;
+                const size_t frames = needed > history_length_ ? needed - history_length_ : 1;
+
+                const size_t block_align = input_format_.BlockAlign();
+                auto* raw = read_buffer_.get<TInput>(frames * channels_);
+                const size_t read_frames = read_source(context, raw, frames * block_align) / block_align;
+
+                if (read_frames == 0)
+                {
+                    // end of source: trailing zeros flush the filter tail.
+                    end_of_source_ = true;
+                    index_limit_ = history_length_ - std::min(history_length_, t.delay - 1);
+                    for (auto& h : history_)
+                    {
+                        // the vector may still hold dropped samples past history_length_.
+                        h.resize(history_length_);
+                        h.resize(history_length_ + t.taps - t.delay, 0.0f);
+                    }
+                    history_length_ += t.taps - t.delay;
+                    return;
+                }
+
+                const F32* src;
+                if constexpr (std::is_same_v<TInput, F32>)
+                {
+                    src = raw;
+                }
+                else
+                {
+                    F32* tmp = convert_buffer_.get<F32>(read_frames * channels_);
+                    processing::ConvertCopy(tmp, raw, read_frames * channels_);
+                    src = tmp;
+                }
+
+                for (size_t c = 0; c < channels_; c++)
+                {
+                    history_[c].resize(history_length_ + read_frames);
+                    processing::GatherCopy<F32>(history_[c].data() + history_length_, src, static_cast<int>(channels_), static_cast<int>(c), read_frames);
+                }
+                history_length_ += read_frames;
+            }
+        };
+
+        template <class TInput>
+        std::shared_ptr<IWaveProcessor> CreateResamplerImpl(const PcmWaveFormat& input_format, const PcmWaveFormat& output_format, std::shared_ptr<const PolyphaseFilterTable> table)
+        {
+            switch (output_format.SampleType())
+            {
+            case SampleType::S16: return std::make_shared<PolyphaseResamplerImpl<TInput, S16>>(input_format, output_format, std::move(table));
+            case SampleType::S24: return std::make_shared<PolyphaseResamplerImpl<TInput, S24>>(input_format, output_format, std::move(table));
+            case SampleType::S32: return std::make_shared<PolyphaseResamplerImpl<TInput, S32>>(input_format, output_format, std::move(table));
+            case SampleType::F32: return std::make_shared<PolyphaseResamplerImpl<TInput, F32>>(input_format, output_format, std::move(table));
+            default: throw std::invalid_argument("not supported format!");
+            }
+        }
+    }
+
+    std::shared_ptr<IWaveProcessor> CreatePolyphaseResampler(
+        PcmWaveFormat input_format,
+        PcmWaveFormat output_format,
+        int quality_level)
+    {
+        if (!input_format || !output_format || input_format.ChannelMask() != output_format.ChannelMask() || input_format.ChannelCount() == 0)
+            throw std::invalid_argument("not supported format!");
+
+        if (input_format.SamplingFrequency() <= 0 || output_format.SamplingFrequency() <= 0)
+            throw std::invalid_argument("not supported format!");
+
+        const size_t in_rate = static_cast<size_t>(input_format.SamplingFrequency());
+        const size_t out_rate = static_cast<size_t>(output_format.SamplingFrequency());
+        const size_t g = std::gcd(in_rate, out_rate);
+        const size_t phase_count = out_rate / g;
+        const size_t phase_step = in_rate / g;
+
+        if (phase_count > MaxPhaseCount)
+            throw std::invalid_argument("not supported rate ratio!");
+
+        auto table = GetSharedFilterTable(phase_count, phase_step, std::clamp(quality_level, 1, 60));
+
+        switch (input_format.SampleType())
+        {
+        case SampleType::S16: return CreateResamplerImpl<S16>(input_format, output_format, std::move(table));
+        case SampleType::S24: return CreateResamplerImpl<S24>(input_format, output_format, std::move(table));
+        case SampleType::S32: return CreateResamplerImpl<S32>(input_format, output_format, std::move(table));
+        case SampleType::F32: return CreateResamplerImpl<F32>(input_format, output_format, std::move(table));
+        default: throw std::invalid_argument("not supported format!");
+        }
+    }
+}
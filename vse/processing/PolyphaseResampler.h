@@ -0,0 +1,24 @@
+/// @file
+/// @brief  Vse - Polyphase Resampler
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include <memory>
+
+#include "../base/WaveFormat.h"
+#include "../base/IWaveProcessor.h"
+
+namespace vse
+{
+    /// Creates native polyphase windowed-sinc sample rate converter.
+    /// Filter tables are shared between instances with the same rate ratio and quality.
+    /// @param input_format source format
+    /// @param output_format destination format. channels must be same as source.
+    /// @param quality_level 1-60 inclusive (same scale as CreateAudioResamplingDsp), 1 is linear interpolation, 60 is most high quality.
+    /// @throw std::invalid_argument Not supported format or rate ratio.
+    [[nodiscard]] std::shared_ptr<IWaveProcessor> CreatePolyphaseResampler(
+        PcmWaveFormat input_format,
+        PcmWaveFormat output_format,
+        int quality_level = 60);
+}
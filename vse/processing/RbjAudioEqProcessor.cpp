@@ -9,44 +9,110 @@
 
 #include <cstddef>
 #include <memory>
-#include <array>
+#include <cstdint>
+#include <atomic>
 #include <stdexcept>
 
+#include "../base/xtl/xtl_spin_lock_mutex.h"
+
+#include "./FusedProcessorChain.h"
+#include "./WaveformProcessing.h"
+
 namespace vse
 {
-    std::shared_ptr<IWaveProcessor> CreateBiquadIirFilter(PcmWaveFormat format, rbj_audio_eq::Coefficients coefficients)
+    void rbj_audio_eq::ProcessRamped(F32* buffer, size_t channels, size_t frames, CoefficientRamp& ramp, processing::BiquadState& state) noexcept
+    {
+        for (size_t offset = 0; offset < frames;)
+        {
+            const size_t n = ramp.IsRamping() && frames - offset > CoefficientRamp::SubBlockFrames ? CoefficientRamp::SubBlockFrames : frames - offset;
+            const Coefficients& c = ramp.Next();
+            const float coefficients[5] = {c.b0a0, c.b1a0, c.b2a0, c.a1a0, c.a2a0};
+            F32* p = buffer + offset * channels;
+            processing::ProcessBiquad(p, p, channels, n, coefficients, state);
+            offset += n;
+        }
+    }
+
+    std::shared_ptr<IBiquadIirFilter> CreateBiquadIirFilter(PcmWaveFormat format, rbj_audio_eq::Coefficients coefficients)
     {
         if (format.SampleType() != SampleType::F32 || format.ChannelCount() > 8)
             throw std::invalid_argument("not supported.");
 
-        class BiquadIirFilterImpl : public IWaveProcessor
+        class BiquadIirFilterImpl final : public virtual IBiquadIirFilter, public IFusableWaveProcessor
         {
             const PcmWaveFormat format_{};
-            const rbj_audio_eq::Coefficients parameters_{};
-            std::array<rbj_audio_eq::ShiftRegister, 8> registers_{};
+
+            // seqlock: the render thread reads without locking; odd version means writing.
+            xtl::spin_lock_mutex writer_mutex_{};
+            std::atomic<uint32_t> version_{};
+            std::atomic<float> params_[5]{};
+
+            // render thread
+            rbj_audio_eq::CoefficientRamp ramp_{};
+            processing::BiquadState state_{};
 
         public:
-            BiquadIirFilterImpl(PcmWaveFormat format, rbj_audio_eq::Coefficients parameters) : format_(format), parameters_(parameters) { }
+            BiquadIirFilterImpl(PcmWaveFormat format, rbj_audio_eq::Coefficients parameters) : format_(format)
+            {
+                SetParameters(parameters);
+                ramp_.Reset(parameters);
+            }
 
             [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
             [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
 
             [[nodiscard]] size_t Process(
                 size_t (* read_source)(void* context, void* buffer, size_t buffer_length), void* context,
                 void* destination_buffer, size_t destination_buffer_length) override
             {
-                const auto coeff = parameters_;
                 const int channels = format_.ChannelCount();
                 const int block_align = format_.BlockAlign();
                 const size_t bytes = read_source(context, destination_buffer, destination_buffer_length / block_align * block_align);
 
                 auto* buf = static_cast<F32*>(destination_buffer);
                 const size_t sample_count = bytes / block_align;
-                for (int i = 0; i < channels; ++i)
-                    registers_[i] = rbj_audio_eq::ProcessSingleChannel(registers_[i], coeff, buf + i, buf + i, sample_count, channels);
+                ramp_.SetTarget(GetParameters());
+                rbj_audio_eq::ProcessRamped(buf, static_cast<size_t>(channels), sample_count, ramp_, state_);
 
                 return bytes;
             }
+
+            [[nodiscard]] rbj_audio_eq::Coefficients GetParameters() const override
+            {
+                for (;;)
+                {
+                    const uint32_t version = version_.load(std::memory_order_acquire);
+                    if (version & 1) continue;
+
+                    float c[5];
+                    for (int i = 0; i < 5; i++) c[i] = params_[i].load(std::memory_order_relaxed);
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (version_.load(std::memory_order_relaxed) == version)
+                        return rbj_audio_eq::Coefficients{c[0], c[1], c[2], c[3], c[4]};
+                }
+            }
+
+            void SetParameters(rbj_audio_eq::Coefficients parameters) override
+            {
+                const float c[5] = {parameters.b0a0, parameters.b1a0, parameters.b2a0, parameters.a1a0, parameters.a2a0};
+
+                xtl::lock_guard lock(writer_mutex_);
+                const uint32_t version = version_.load(std::memory_order_relaxed);
+                version_.store(version + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (int i = 0; i < 5; i++) params_[i].store(c[i], std::memory_order_relaxed);
+                version_.store(version + 2, std::memory_order_release);
+            }
+
+            [[nodiscard]] FusedOperation GetFusedOperation() const override
+            {
+                FusedOperation op{};
+                op.type = FusedOperation::Type::Biquad;
+                op.biquad = GetParameters();
+                return op;
+            }
         };
 
         return std::make_shared<BiquadIirFilterImpl>(format, coefficients);
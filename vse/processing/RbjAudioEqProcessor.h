@@ -13,6 +13,11 @@
 #include "../base/WaveFormat.h"
 #include "../base/IWaveProcessor.h"
 
+namespace vse::processing
+{
+    struct BiquadState;
+}
+
 namespace vse
 {
     namespace rbj_audio_eq
@@ -213,12 +218,71 @@ namespace vse
             input += stride;
             return {y2, y0, x2, x0};
         }
+
+        /// Coefficients moving linearly from the current ones to the target, a step per sub-block.
+        /// Every point on the way is stable if both ends are, since the stable region of (a1, a2) is convex.
+        struct CoefficientRamp
+        {
+            static constexpr size_t SubBlockFrames = 32;
+            static constexpr int Steps = 16;
+
+            Coefficients current{};
+            Coefficients from{};
+            Coefficients to{};
+            int step = Steps;
+
+            /// Jumps to `c` without ramping.
+            void Reset(const Coefficients& c)
+            {
+                current = from = to = c;
+                step = Steps;
+            }
+
+            /// Starts ramping toward `c` from the current coefficients, if `c` is a new target.
+            void SetTarget(const Coefficients& c)
+            {
+                if (c.b0a0 == to.b0a0 && c.b1a0 == to.b1a0 && c.b2a0 == to.b2a0 && c.a1a0 == to.a1a0 && c.a2a0 == to.a2a0)
+                    return;
+
+                from = current;
+                to = c;
+                step = 0;
+            }
+
+            [[nodiscard]] bool IsRamping() const { return step < Steps; }
+
+            /// Advances a step and gets the coefficients for the next sub-block.
+            const Coefficients& Next()
+            {
+                if (step < Steps)
+                {
+                    const float t = static_cast<float>(++step) / Steps;
+                    const auto lerp = [t](float a, float b) { return a + (b - a) * t; };
+                    current = step == Steps ? to : Coefficients{
+                        lerp(from.b0a0, to.b0a0),
+                        lerp(from.b1a0, to.b1a0),
+                        lerp(from.b2a0, to.b2a0),
+                        lerp(from.a1a0, to.a1a0),
+                        lerp(from.a2a0, to.a2a0),
+                    };
+                }
+                return current;
+            }
+        };
+
+        /// Processes interleaved channels in place with the ramping coefficients:
+        /// sub-blocks of SubBlockFrames while ramping, the rest at once.
+        void ProcessRamped(F32* buffer, size_t channels, size_t frames, CoefficientRamp& ramp, processing::BiquadState& state) noexcept;
     }
 
+    using IBiquadIirFilter = IParametricWaveProcessor<rbj_audio_eq::Coefficients>;
+
     /// Creates Audio EQ Cookbook's Biquad Filter
-    /// @param format source format
-    /// @param coefficients filter parameter.
-    std::shared_ptr<IWaveProcessor> CreateBiquadIirFilter(
+    /// Coefficients can be changed while playing. The filter glides to new coefficients in a few hundred samples without resetting its state.
+    /// @param format source format. F32, up to 8 channels.
+    /// @param coefficients initial filter parameter.
+    /// @throw std::invalid_argument Not supported format.
+    std::shared_ptr<IBiquadIirFilter> CreateBiquadIirFilter(
         PcmWaveFormat format,
         rbj_audio_eq::Coefficients coefficients);
 }
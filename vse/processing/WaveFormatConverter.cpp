@@ -11,14 +11,19 @@
 #pragma comment(lib, "mfplat.lib")
 #pragma comment(lib, "wmcodecdspuuid.lib")
 
+#include <atomic>
 #include <memory>
 #include <algorithm>
+#include <type_traits>
 #include <stdexcept>
 
 #include "../base/xtl/xtl_temp_memory_buffer.h"
 #include "../base/win32/debug.h"
 
+#include "./ChannelMatrixProcessor.h"
 #include "./DmoWaveProcessor.h"
+#include "./FusedProcessorChain.h"
+#include "./PolyphaseResampler.h"
 #include "./WaveformProcessing.h"
 #include "./WaveSourceWithProcessing.h"
 
@@ -34,6 +39,7 @@ namespace vse
             explicit ThruProcessorImpl(const PcmWaveFormat& format) : format_(format) {}
             [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return format_; }
             [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return format_; }
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {true, true, 0, 1.0}; }
 
             [[nodiscard]] size_t Process(
                 size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
@@ -50,7 +56,7 @@ namespace vse
 namespace vse
 {
     template <class TSourceSampleType, class TDestinationSampleType>
-    class BitDepthConvertProcessorImpl final : public IWaveProcessor
+    class BitDepthConvertProcessorImpl final : public IWaveProcessor, public IFusableWaveProcessor
     {
         using SrcType = TSourceSampleType;
         using DstType = TDestinationSampleType;
@@ -67,35 +73,149 @@ namespace vse
             //
         }
 
+        // samples of the same size are converted in destination_buffer.
+        static constexpr bool InPlace = sizeof(SrcType) == sizeof(DstType);
+
         [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return input_format_; }
         [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return output_format_; }
+        [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override { return {InPlace, input_format_ == output_format_, 0, static_cast<double>(sizeof(DstType)) / sizeof(SrcType)}; }
 
         [[nodiscard]] size_t Process(
             size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
-            void* destination_buffer, size_t destination_buffer_length) noexcept override
+            void* destination_buffer, size_t destination_buffer_length) override
         {
             // calculates maximum sample count.
             size_t max_count = destination_buffer_length / sizeof(DstType);
 
-            // allocates temporally buffer.
-            auto* tmp = buffer_.get<SrcType>(max_count);
+            if constexpr (InPlace)
+            {
+                auto read_bytes = read_source(context, destination_buffer, max_count * sizeof(SrcType));
+                size_t count = read_bytes / sizeof(SrcType);
+                if constexpr (!std::is_same_v<SrcType, DstType>)
+                    processing::ConvertCopy(static_cast<DstType*>(destination_buffer), static_cast<const SrcType*>(destination_buffer), count);
+                return count * sizeof(DstType);
+            }
+            else
+            {
+                // allocates temporally buffer.
+                auto* tmp = buffer_.get<SrcType>(max_count);
 
-            // reads source.
-            auto read_bytes = read_source(context, tmp, max_count * sizeof(SrcType));
+                // reads source.
+                auto read_bytes = read_source(context, tmp, max_count * sizeof(SrcType));
 
-            size_t count = read_bytes / sizeof(SrcType);
+                size_t count = read_bytes / sizeof(SrcType);
+
+                // converts.
+                processing::ConvertCopy(static_cast<DstType*>(destination_buffer), tmp, count);
+
+                // returns processed size.
+                return count * sizeof(DstType);
+            }
+        }
+
+        size_t Prepare(size_t max_output_frames) override
+        {
+            if constexpr (!InPlace)
+                buffer_.reserve<SrcType>(max_output_frames * static_cast<size_t>(output_format_.ChannelCount()));
+            return max_output_frames;
+        }
+
+        [[nodiscard]] FusedOperation GetFusedOperation() const override
+        {
+            FusedOperation op{};
+            op.type = FusedOperation::Type::ConvertBitDepth;
+            return op;
+        }
+    };
+
+    template <class TDestinationSampleType>
+    class DitheredBitDepthConvertProcessorImpl final : public IWaveProcessor, public IFusableWaveProcessor
+    {
+        using SrcType = F32;
+        using DstType = TDestinationSampleType;
+
+        PcmWaveFormat input_format_{};
+        PcmWaveFormat output_format_{};
+        xtl::temp_memory_buffer buffer_{};
+        NoiseShaping noise_shaping_{};
+        processing::DitherState dither_{};
+        std::atomic_flag continuity_{};
+
+    public:
+        DitheredBitDepthConvertProcessorImpl(const PcmWaveFormat& input_format, const PcmWaveFormat& output_format, NoiseShaping noise_shaping)
+            : input_format_(input_format)
+            , output_format_(output_format)
+            , noise_shaping_(noise_shaping)
+        {
+            switch (noise_shaping)
+            {
+            case NoiseShaping::None: break;
+            case NoiseShaping::FirstOrder: dither_.shaping[0] = 1.0f, dither_.shaping[1] = 0.0f; break;
+            case NoiseShaping::SecondOrder: dither_.shaping[0] = 2.0f, dither_.shaping[1] = -1.0f; break;
+            default: throw std::invalid_argument("not supported noise shaping!");
+            }
+
+            continuity_.test_and_set();
+        }
+
+        [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return input_format_; }
+        [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return output_format_; }
+
+        [[nodiscard]] size_t Process(
+            size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+            void* destination_buffer, size_t destination_buffer_length) override
+        {
+            // clears the noise shaping history after discontinuity.
+            if (!continuity_.test_and_set())
+            {
+                for (auto& e : dither_.error) e[0] = e[1] = 0.0f;
+                dither_.channel = 0;
+            }
 
-            // converts.
-            processing::ConvertCopy(static_cast<DstType*>(destination_buffer), tmp, count);
+            size_t max_count = destination_buffer_length / sizeof(DstType);
+            auto* tmp = buffer_.get<SrcType>(max_count);
+            auto read_bytes = read_source(context, tmp, max_count * sizeof(SrcType));
+            size_t count = read_bytes / sizeof(SrcType);
 
-            // returns processed size.
+            processing::ConvertCopyDithered(static_cast<DstType*>(destination_buffer), tmp, count, static_cast<size_t>(input_format_.ChannelCount()), dither_);
             return count * sizeof(DstType);
         }
+
+        void Discontinuity() override
+        {
+            continuity_.clear();
+        }
+
+        size_t Prepare(size_t max_output_frames) override
+        {
+            buffer_.reserve<SrcType>(max_output_frames * static_cast<size_t>(output_format_.ChannelCount()));
+            return max_output_frames;
+        }
+
+        [[nodiscard]] FusedOperation GetFusedOperation() const override
+        {
+            FusedOperation op{};
+            op.type = FusedOperation::Type::ConvertBitDepth;
+            op.bit_depth.dither = true;
+            op.bit_depth.noise_shaping = noise_shaping_;
+            return op;
+        }
     };
 
-    std::shared_ptr<IWaveProcessor> CreateBitDepthConverter(PcmWaveFormat input_format, SampleType output_format)
+    std::shared_ptr<IWaveProcessor> CreateBitDepthConverter(PcmWaveFormat input_format, SampleType output_format, BitDepthConverterOptions options)
     {
         if (input_format.SampleType() == output_format) return CreateThruProcessor(input_format);
+
+        if (options.dither && input_format.SampleType() == SampleType::F32 && (output_format == SampleType::S16 || output_format == SampleType::S24))
+        {
+            if (input_format.ChannelCount() <= 0 || (options.noise_shaping != NoiseShaping::None && static_cast<size_t>(input_format.ChannelCount()) > processing::DitherState::MaxChannels))
+                throw std::runtime_error("not supported format!");
+
+            PcmWaveFormat out{output_format, input_format.channels_, input_format.frequency_};
+            if (output_format == SampleType::S16) return std::make_shared<DitheredBitDepthConvertProcessorImpl<S16>>(input_format, out, options.noise_shaping);
+            if (output_format == SampleType::S24) return std::make_shared<DitheredBitDepthConvertProcessorImpl<S24>>(input_format, out, options.noise_shaping);
+        }
+
         if (input_format.SampleType() == SampleType::S16 && output_format == SampleType::S16) return std::make_shared<BitDepthConvertProcessorImpl<S16, S16>>(input_format, PcmWaveFormat{output_format, input_format.channels_, input_format.frequency_});
         if (input_format.SampleType() == SampleType::S16 && output_format == SampleType::S24) return std::make_shared<BitDepthConvertProcessorImpl<S16, S24>>(input_format, PcmWaveFormat{output_format, input_format.channels_, input_format.frequency_});
         if (input_format.SampleType() == SampleType::S16 && output_format == SampleType::S32) return std::make_shared<BitDepthConvertProcessorImpl<S16, S32>>(input_format, PcmWaveFormat{output_format, input_format.channels_, input_format.frequency_});
@@ -210,6 +330,46 @@ namespace vse
             return CreateBitDepthConverter(in, out.SampleType());
         }
 
+        // If channels are same, native resampler converts sampling-rate (and bit-depth).
+        if (in && out && in.ChannelMask() == out.ChannelMask())
+        {
+            try
+            {
+                return CreatePolyphaseResampler(in, out);
+            }
+            catch (const std::invalid_argument&) {}
+        }
+
+        // If sampling-rates are same, only channel matrix is needed (no resampling).
+        if (in && out && in.SamplingFrequency() == out.SamplingFrequency())
+        {
+            try
+            {
+                return CreateChannelMatrixProcessor(in, out);
+            }
+            catch (const std::invalid_argument&) {}
+        }
+
+        // Both differ: mixes and resamples via F32.
+        // Down-mixes before resampling, up-mixes after, so that the resampler processes fewer channels.
+        if (in && out)
+        {
+            try
+            {
+                if (in.ChannelCount() >= out.ChannelCount())
+                {
+                    PcmWaveFormat mid{SampleType::F32, out.ChannelMask(), in.SamplingFrequency()};
+                    return CreateProcessorChain(CreateChannelMatrixProcessor(in, mid), CreatePolyphaseResampler(mid, out));
+                }
+                else
+                {
+                    PcmWaveFormat mid{SampleType::F32, in.ChannelMask(), out.SamplingFrequency()};
+                    return CreateProcessorChain(CreatePolyphaseResampler(in, mid), CreateChannelMatrixProcessor(mid, out));
+                }
+            }
+            catch (const std::invalid_argument&) {}
+        }
+
         try
         {
             return CreateAudioResamplingDsp(in, out);
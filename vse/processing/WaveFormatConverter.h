@@ -14,13 +14,33 @@ namespace vse
     [[nodiscard]] std::shared_ptr<IWaveProcessor> CreateThru(
         PcmWaveFormat format);
 
+    /// Noise shaping of dithered bit-depth conversion
+    enum struct NoiseShaping
+    {
+        None = 0,        ///< flat TPDF dither
+        FirstOrder = 1,  ///< error feedback (1 - z^-1): +6dB/oct noise slope
+        SecondOrder = 2, ///< error feedback (1 - z^-1)^2: +12dB/oct noise slope
+    };
+
+    /// Bit-depth converter options
+    struct BitDepthConverterOptions
+    {
+        /// Adds TPDF dither of +-1 LSB on F32 to S16/S24 conversion, instead of truncating.
+        bool dither = false;
+
+        /// Shapes the dither and requantization noise towards high frequencies. Used with dither only.
+        NoiseShaping noise_shaping = NoiseShaping::None;
+    };
+
     /// Creates bit-depth converter
     /// @param input_format source format
     /// @param output_format destination format
+    /// @param options dither options
     /// @throw std::runtime_error No suitable format converter found.
     [[nodiscard]] std::shared_ptr<IWaveProcessor> CreateBitDepthConverter(
         PcmWaveFormat input_format,
-        SampleType output_format);
+        SampleType output_format,
+        BitDepthConverterOptions options = {});
 
     /// Creates Microsoft Audio Resampling DSP.
     /// @param input_format source format
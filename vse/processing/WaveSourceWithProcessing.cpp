@@ -4,7 +4,10 @@
 
 #include "WaveSourceWithProcessing.h"
 
+#include <cstddef>
+#include <cstring>
 #include <memory>
+#include <algorithm>
 #include <stdexcept>
 
 #include "../base/WaveFormat.h"
@@ -13,6 +16,66 @@
 
 namespace vse
 {
+    namespace
+    {
+        /// Bytes run through upstream and processor together, while they stay in cache.
+        constexpr size_t TileBytes = 8192;
+
+        using ReadSourceFunction = size_t (*)(void* context, void* buffer, size_t buffer_length);
+
+        /// Tells whether the processor can be run by ProcessInDestination.
+        bool CanProcessInDestination(const IWaveProcessor& processor)
+        {
+            const WaveProcessorCapabilities caps = processor.GetCapabilities();
+            return caps.in_place && caps.same_format;
+        }
+
+        /// Runs an in-place, same-format processor in destination_buffer, tile by tile:
+        /// the upstream fills a tile, then the processor reads the tile where it already is and processes it there.
+        size_t ProcessInDestination(
+            IWaveProcessor& processor, size_t block_align,
+            ReadSourceFunction read_upstream, void* context,
+            void* destination_buffer, size_t destination_buffer_length)
+        {
+            struct Prefilled
+            {
+                std::byte* data;
+                size_t filled;
+                size_t offset;
+                ReadSourceFunction read_upstream;
+                void* context;
+
+                static size_t Read(void* ctx, void* buffer, size_t buffer_length)
+                {
+                    auto* p = static_cast<Prefilled*>(ctx);
+                    const size_t served = std::min(buffer_length, p->filled - p->offset);
+                    if (buffer != p->data + p->offset) std::memmove(buffer, p->data + p->offset, served);
+                    p->offset += served;
+
+                    // past the tile (e.g. a processor flushing its latency at the end of stream), reads on from the upstream.
+                    if (served == buffer_length) return served;
+                    return served + p->read_upstream(p->context, static_cast<std::byte*>(buffer) + served, buffer_length - served);
+                }
+            };
+
+            const size_t tile_bytes = std::max<size_t>(TileBytes / block_align, 1) * block_align;
+            auto* dst = static_cast<std::byte*>(destination_buffer);
+
+            size_t total = 0;
+            while (total < destination_buffer_length)
+            {
+                const size_t length = std::min(tile_bytes, destination_buffer_length - total);
+                Prefilled tile{dst + total, 0, 0, read_upstream, context};
+                tile.filled = read_upstream(context, tile.data, length);
+
+                const size_t written = processor.Process(&Prefilled::Read, &tile, tile.data, length);
+                total += written;
+                if (written < length) break;
+            }
+            return total;
+        }
+    }
+
     std::shared_ptr<IWaveSourceWithProcessing> CreateSourceWithProcessing(
         std::shared_ptr<IWaveSource> source,
         std::shared_ptr<IWaveProcessor> processor)
@@ -22,10 +85,12 @@ namespace vse
         public:
             std::shared_ptr<IWaveSource> source_;
             std::shared_ptr<IWaveProcessor> processor_;
+            bool in_destination_;
 
             Proc(std::shared_ptr<IWaveSource> source, std::shared_ptr<IWaveProcessor> processor)
                 : source_(std::move(source))
-                , processor_(std::move(processor)) {}
+                , processor_(std::move(processor))
+                , in_destination_(CanProcessInDestination(*processor_)) {}
 
             [[nodiscard]] PcmWaveFormat GetFormat() const override
             {
@@ -34,9 +99,20 @@ namespace vse
 
             [[nodiscard]] size_t Read(void* buffer, size_t buffer_length) override
             {
+                if (in_destination_)
+                    return ProcessInDestination(
+                        *processor_, static_cast<size_t>(processor_->GetInputFormat().BlockAlign()),
+                        [](void* ctx, void* buf, size_t sz) { return static_cast<IWaveSource*>(ctx)->Read(buf, sz); }, source_.get(),
+                        buffer, buffer_length);
+
                 return processor_->Process([&](void* buf, size_t sz) { return source_->Read(buf, sz); }, buffer, buffer_length);
             }
 
+            void Prepare(size_t max_frames) override
+            {
+                source_->Prepare(processor_->Prepare(max_frames));
+            }
+
             [[nodiscard]] std::shared_ptr<IWaveSource> GetUpstreamWaveSource() override
             {
                 return source_;
@@ -53,4 +129,83 @@ namespace vse
 
         return std::make_shared<Proc>(std::move(source), std::move(processor));
     }
+
+    std::shared_ptr<IWaveProcessor> CreateProcessorChain(
+        std::shared_ptr<IWaveProcessor> first,
+        std::shared_ptr<IWaveProcessor> second)
+    {
+        class ProcessorChainImpl final : public IWaveProcessor
+        {
+            std::shared_ptr<IWaveProcessor> first_;
+            std::shared_ptr<IWaveProcessor> second_;
+            bool in_destination_; // second runs on first's output in destination_buffer.
+
+            struct FirstStageContext
+            {
+                IWaveProcessor* processor;
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length);
+                void* context;
+
+                static size_t Read(void* ctx, void* buf, size_t len)
+                {
+                    auto* c = static_cast<FirstStageContext*>(ctx);
+                    return c->processor->Process(c->read_source, c->context, buf, len);
+                }
+            };
+
+        public:
+            ProcessorChainImpl(std::shared_ptr<IWaveProcessor> first, std::shared_ptr<IWaveProcessor> second)
+                : first_(std::move(first))
+                , second_(std::move(second))
+                , in_destination_(CanProcessInDestination(*second_)) {}
+
+            [[nodiscard]] PcmWaveFormat GetInputFormat() const override { return first_->GetInputFormat(); }
+            [[nodiscard]] PcmWaveFormat GetOutputFormat() const override { return second_->GetOutputFormat(); }
+
+            [[nodiscard]] WaveProcessorCapabilities GetCapabilities() const override
+            {
+                // second reads first's output into the buffer it processes in: both in place means no staging at all.
+                const WaveProcessorCapabilities f = first_->GetCapabilities();
+                const WaveProcessorCapabilities s = second_->GetCapabilities();
+                const double latency_ratio = static_cast<double>(second_->GetOutputFormat().SamplingFrequency()) / second_->GetInputFormat().SamplingFrequency();
+
+                WaveProcessorCapabilities caps{};
+                caps.in_place = f.in_place && s.in_place;
+                caps.same_format = GetInputFormat() == GetOutputFormat();
+                caps.latency_frames = s.latency_frames + static_cast<size_t>(static_cast<double>(f.latency_frames) * latency_ratio + 0.5);
+                caps.max_expansion = f.max_expansion * s.max_expansion;
+                return caps;
+            }
+
+            [[nodiscard]] size_t Process(
+                size_t (*read_source)(void* context, void* buffer, size_t buffer_length), void* context,
+                void* destination_buffer, size_t destination_buffer_length) override
+            {
+                FirstStageContext first{first_.get(), read_source, context};
+                if (in_destination_)
+                    return ProcessInDestination(
+                        *second_, static_cast<size_t>(second_->GetInputFormat().BlockAlign()),
+                        &FirstStageContext::Read, &first,
+                        destination_buffer, destination_buffer_length);
+
+                return second_->Process(&FirstStageContext::Read, &first, destination_buffer, destination_buffer_length);
+            }
+
+            void Discontinuity() override
+            {
+                first_->Discontinuity();
+                second_->Discontinuity();
+            }
+
+            size_t Prepare(size_t max_output_frames) override
+            {
+                return first_->Prepare(second_->Prepare(max_output_frames));
+            }
+        };
+
+        if (first->GetOutputFormat() != second->GetInputFormat())
+            throw std::logic_error("The first processor output format and the second processor input format isn't match.");
+
+        return std::make_shared<ProcessorChainImpl>(std::move(first), std::move(second));
+    }
 }
@@ -18,7 +18,16 @@ namespace vse
         [[nodiscard]] virtual std::shared_ptr<IWaveProcessor> GetAttachedProcessor() = 0;
     };
 
+    /// Creates a source which reads `source` through `processor`.
+    /// A processor reporting in_place and same_format capabilities runs in the read buffer, tile by tile.
     [[nodiscard]] std::shared_ptr<IWaveSourceWithProcessing> CreateSourceWithProcessing(
         std::shared_ptr<IWaveSource> source,
         std::shared_ptr<IWaveProcessor> processor);
+
+    /// Creates a processor which processes with `first` then `second`.
+    /// If `second` reports in_place and same_format, both run in the destination buffer tile by tile, while each tile is in cache.
+    /// @throw std::logic_error The output format of `first` and the input format of `second` isn't match.
+    [[nodiscard]] std::shared_ptr<IWaveProcessor> CreateProcessorChain(
+        std::shared_ptr<IWaveProcessor> first,
+        std::shared_ptr<IWaveProcessor> second);
 }
@@ -3,459 +3,209 @@
 /// @author (C) 2022 ttsuki
 
 #include "WaveformProcessing.h"
+#include "WaveformProcessingKernels.h"
 
-#include <cmath>
-#include <algorithm>
+#include <atomic>
 
-#ifdef __RESHARPER__
-#define __AVX2__
-#endif
-
-#ifdef __AVX2__
-#include "../base/arkxmm.h"
-using namespace arkana;
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
 #endif
 
 namespace vse::processing
 {
-    void ConvertCopy(S16* __restrict dst, const S32* __restrict src, size_t count) noexcept
+    namespace
     {
-#ifdef __AVX2__
-        for (size_t i = 0; i < count / 8; i++)
+        struct CpuFeatures
         {
-            xmm::store_u<xmm::vi16x8>(
-                dst, xmm::pack_sat_i(
-                    xmm::load_u<xmm::vi32x4>(src + 0) >> 16,
-                    xmm::load_u<xmm::vi32x4>(src + 4) >> 16));
+            bool sse41{};
+            bool avx2{};
+            bool avx512{};
+        };
 
-            src += 8;
-            dst += 8;
-        }
-        count %= 8;
-#endif
-
-        for (size_t i = 0; i < count; i++)
+        CpuFeatures DetectCpuFeatures() noexcept
         {
-            dst[i] = static_cast<S16>(src[i] >> 16);
-        }
-    }
-
-    void ConvertCopy(S16* __restrict dst, const S24* __restrict src, size_t count) noexcept
-    {
-#ifdef __AVX2__
-        for (size_t i = 0; i < count / 16; i++)
-        {
-            auto x0 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 0);
-            auto x1 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 16);
-            auto x2 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 32);
-
-            auto y0 = xmm::byte_align_r_128<6>(
-                xmm::byte_shuffle_128(x0, xmm::i8x16(-1, -1, -1, -1, -1, -1, 1, 2, 4, 5, 7, 8, 10, 11, 13, 14)),
-                xmm::byte_shuffle_128(x1, xmm::i8x16(0, 1, 3, 4, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+            auto cpuid = [](unsigned leaf, unsigned subleaf, unsigned (&r)[4])
+            {
+#if defined(_MSC_VER)
+                int regs[4]{};
+                __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+                for (int i = 0; i < 4; i++) r[i] = static_cast<unsigned>(regs[i]);
+#else
+                __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+#endif
+            };
 
-            auto y1 = xmm::byte_align_r_128<11>(
-                xmm::byte_shuffle_128(x1, xmm::i8x16(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 10, 12, 13, 15)),
-                xmm::byte_shuffle_128(x2, xmm::i8x16(0, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, -1, -1, -1, -1, -1)));
+            unsigned r0[4]{}, r1[4]{}, r7[4]{};
+            cpuid(0, 0, r0);
+            const unsigned max_leaf = r0[0];
+            if (max_leaf >= 1) cpuid(1, 0, r1);
+            if (max_leaf >= 7) cpuid(7, 0, r7);
 
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
+            const auto bit = [](unsigned reg, int n) { return (reg >> n & 1) != 0; };
+            const unsigned ecx1 = r1[2], ebx7 = r7[1];
 
-            src += 16;
-            dst += 16;
-        }
-        count %= 16;
+            // the OS must save the wider registers on context switches.
+            unsigned long long xcr0 = 0;
+            if (bit(ecx1, 27)) // OSXSAVE
+            {
+#if defined(_MSC_VER)
+                xcr0 = _xgetbv(0);
+#else
+                unsigned lo{}, hi{};
+                __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+                xcr0 = static_cast<unsigned long long>(hi) << 32 | lo;
 #endif
+            }
+            const bool os_ymm = (xcr0 & 0x06) == 0x06;
+            const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
 
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<S16>(static_cast<S32>(src[i]) >> 8);
+            CpuFeatures f{};
+            f.sse41 = bit(ecx1, 0) && bit(ecx1, 9) && bit(ecx1, 19);                                          // SSE3, SSSE3, SSE4.1
+            f.avx2 = f.sse41 && os_ymm && bit(ecx1, 28) && bit(ecx1, 12) && bit(ebx7, 5) && bit(ebx7, 3) && bit(ebx7, 8); // AVX, FMA, AVX2, BMI1, BMI2 (/arch:AVX2)
+            f.avx512 = f.avx2 && os_zmm && bit(ebx7, 16) && bit(ebx7, 17) && bit(ebx7, 28) && bit(ebx7, 30) && bit(ebx7, 31); // F, DQ, CD, BW, VL (/arch:AVX512)
+            return f;
         }
-    }
 
-    void ConvertCopy(S16* __restrict dst, const F32* __restrict src, size_t count) noexcept
-    {
-        const float scale = 0x1p+15f; // = 1 << 15
-        const float maxi = std::nextafter(+scale, -1.0f);
-        const float mini = std::nextafter(-scale, -1.0f);
-
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x4(scale);
-        const auto maxiv = xmm::f32x4(maxi);
-        const auto miniv = xmm::f32x4(mini);
-        for (size_t i = 0; i < count / 8; i++)
+        const CpuFeatures& GetCpuFeatures() noexcept
         {
-            auto x0 = xmm::load_u<xmm::vf32x4>(src + 0);
-            auto x1 = xmm::load_u<xmm::vf32x4>(src + 4);
-            auto w0 = xmm::clamp(x0 * scalev, miniv, maxiv);
-            auto w1 = xmm::clamp(x1 * scalev, miniv, maxiv);
-            auto y0 = xmm::convert_cast<xmm::vi32x4>(w0);
-            auto y1 = xmm::convert_cast<xmm::vi32x4>(w1);
-            xmm::store_u<xmm::vi16x8>(dst, pack_sat_i(y0, y1));
-
-            src += 8;
-            dst += 8;
+            static const CpuFeatures features = DetectCpuFeatures();
+            return features;
         }
-        count %= 8;
-#endif
 
-        for (size_t i = 0; i < count; i++)
+        const kernels::KernelTable* SelectKernelTable(KernelTarget target, KernelTarget* selected) noexcept
         {
-            dst[i] = static_cast<S16>(std::clamp(src[i] * scale, mini, maxi));
+            const CpuFeatures& cpu = GetCpuFeatures();
+            if (target == KernelTarget::Auto) target = KernelTarget::Avx512;
+
+            // falls back to the best supported one below the requested target.
+            if (target >= KernelTarget::Avx512 && cpu.avx512) return *selected = KernelTarget::Avx512, &kernels::KernelTableAvx512;
+            if (target >= KernelTarget::Avx2 && cpu.avx2) return *selected = KernelTarget::Avx2, &kernels::KernelTableAvx2;
+            if (target >= KernelTarget::Sse41 && cpu.sse41) return *selected = KernelTarget::Sse41, &kernels::KernelTableSse41;
+            return *selected = KernelTarget::Sse2, &kernels::KernelTableSse2;
         }
-    }
 
-    void ConvertCopy(S24* __restrict dst, const S16* __restrict src, size_t count) noexcept
-    {
-#ifdef __AVX2__
-        for (size_t i = 0; i < count / 16; i++)
+        struct KernelDispatch
         {
-            auto x0 = xmm::load_u<xmm::vu8x16>(src + 0);
-            auto x1 = xmm::load_u<xmm::vu8x16>(src + 8);
+            std::atomic<const kernels::KernelTable*> table{};
+            std::atomic<KernelTarget> target{};
 
-            auto y0 = xmm::byte_shuffle_128(x0, xmm::i8x16(-1, 0, 1, -1, 2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1));
-            auto y1 = xmm::byte_shuffle_128(xmm::byte_align_r_128<8>(x0, x1), xmm::i8x16(2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1, 10, 11, -1, 12));
-            auto y2 = xmm::byte_shuffle_128(x1, xmm::i8x16(5, -1, 6, 7, -1, 8, 9, -1, 10, 11, -1, 12, 13, -1, 14, 15));
+            KernelDispatch() noexcept { Select(KernelTarget::Auto); }
 
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 32, y2);
+            KernelTarget Select(KernelTarget requested) noexcept
+            {
+                KernelTarget selected{};
+                auto t = SelectKernelTable(requested, &selected);
+                table.store(t, std::memory_order_release);
+                target.store(selected, std::memory_order_release);
+                return selected;
+            }
+        };
 
-            src += 16;
-            dst += 16;
+        KernelDispatch& GetKernelDispatch() noexcept
+        {
+            static KernelDispatch dispatch;
+            return dispatch;
         }
-        count %= 16;
-#endif
 
-        for (size_t i = 0; i < count; i++)
+        const kernels::KernelTable& Kernels() noexcept
         {
-            dst[i] = S24(src[i] << 8);
+            return *GetKernelDispatch().table.load(std::memory_order_acquire);
         }
     }
 
-    void ConvertCopy(S24* __restrict dst, const S32* __restrict src, size_t count) noexcept
+    KernelTarget GetKernelTarget() noexcept { return GetKernelDispatch().target.load(std::memory_order_acquire); }
+    KernelTarget SetKernelTarget(KernelTarget target) noexcept { return GetKernelDispatch().Select(target); }
+    const char* GetKernelTargetName() noexcept { return Kernels().name; }
+
+    void ConvertCopy(S16* __restrict dst, const S24* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S16_S24(dst, src, count); }
+    void ConvertCopy(S16* __restrict dst, const S32* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S16_S32(dst, src, count); }
+    void ConvertCopy(S16* __restrict dst, const F32* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S16_F32(dst, src, count); }
+    void ConvertCopy(S24* __restrict dst, const S16* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S24_S16(dst, src, count); }
+    void ConvertCopy(S24* __restrict dst, const S32* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S24_S32(dst, src, count); }
+    void ConvertCopy(S24* __restrict dst, const F32* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S24_F32(dst, src, count); }
+    void ConvertCopy(S32* __restrict dst, const S16* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S32_S16(dst, src, count); }
+    void ConvertCopy(S32* __restrict dst, const S24* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_S32_S24(dst, src, count); }
+    void ConvertCopy(S32* dst, const F32* src, size_t count) noexcept { return Kernels().ConvertCopy_S32_F32(dst, src, count); }
+    void ConvertCopy(F32* __restrict dst, const S16* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_F32_S16(dst, src, count); }
+    void ConvertCopy(F32* __restrict dst, const S24* __restrict src, size_t count) noexcept { return Kernels().ConvertCopy_F32_S24(dst, src, count); }
+    void ConvertCopy(F32* dst, const S32* src, size_t count) noexcept { return Kernels().ConvertCopy_F32_S32(dst, src, count); }
+    void ConvertCopyDithered(S16* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept { return Kernels().ConvertCopyDithered_S16_F32(dst, src, count, channels, state); }
+    void ConvertCopyDithered(S24* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept { return Kernels().ConvertCopyDithered_S24_F32(dst, src, count, channels, state); }
+
+    void InterleaveCopy(F32* __restrict dst, const F32* const* __restrict src, size_t channels, size_t count) noexcept
     {
-#ifdef __AVX2__
-        for (size_t i = 0; i < count / 16; i++)
-        {
-            auto x0 = xmm::load_u<xmm::vu8x16>(src + 0);
-            auto x1 = xmm::load_u<xmm::vu8x16>(src + 4);
-            auto x2 = xmm::load_u<xmm::vu8x16>(src + 8);
-            auto x3 = xmm::load_u<xmm::vu8x16>(src + 12);
-
-            auto t0 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x0), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
-            auto t1 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x1), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
-            auto t2 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x2), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
-            auto t3 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x3), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
-
-            auto y0 = xmm::byte_align_r_128<4>(t0, t1);
-            auto y1 = xmm::byte_align_r_128<8>(t1, t2);
-            auto y2 = xmm::byte_align_r_128<12>(t2, t3);
-
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 32, y2);
-
-            src += 16;
-            dst += 16;
-        }
-        count %= 16;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = S24(src[i] >> 8);
-        }
+        return Kernels().InterleaveCopy(dst, src, channels, count);
     }
 
-    void ConvertCopy(S24* __restrict dst, const F32* __restrict src, size_t count) noexcept
+    void DeinterleaveCopy(F32* const* __restrict dst, const F32* __restrict src, size_t channels, size_t count) noexcept
     {
-        const float scale = 0x1p23f; // = 1 << 23
-        const float maxi = std::nextafter(+scale, -1.0f);
-        const float mini = std::nextafter(-scale, +1.0f);
-
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x4(0x1p31f);
-        const auto maxiv = xmm::f32x4(std::nextafter(+0x1p31f, -1.0f));
-        const auto miniv = xmm::f32x4(std::nextafter(-0x1p31f, +1.0f));
-
-        for (size_t i = 0; i < count / 16; i++)
-        {
-            auto x0 = xmm::load_u<xmm::vf32x4>(src + 0);
-            auto x1 = xmm::load_u<xmm::vf32x4>(src + 4);
-            auto x2 = xmm::load_u<xmm::vf32x4>(src + 8);
-            auto x3 = xmm::load_u<xmm::vf32x4>(src + 12);
-
-            auto t0 = xmm::clamp(x0 * scalev, miniv, maxiv);
-            auto t1 = xmm::clamp(x1 * scalev, miniv, maxiv);
-            auto t2 = xmm::clamp(x2 * scalev, miniv, maxiv);
-            auto t3 = xmm::clamp(x3 * scalev, miniv, maxiv);
-
-            auto u0 = xmm::convert_cast<xmm::vi32x4>(t0);
-            auto u1 = xmm::convert_cast<xmm::vi32x4>(t1);
-            auto u2 = xmm::convert_cast<xmm::vi32x4>(t2);
-            auto u3 = xmm::convert_cast<xmm::vi32x4>(t3);
-
-            auto w0 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u0), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
-            auto w1 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u1), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
-            auto w2 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u2), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
-            auto w3 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u3), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
-
-            auto y0 = xmm::byte_align_r_128<4>(w0, w1);
-            auto y1 = xmm::byte_align_r_128<8>(w1, w2);
-            auto y2 = xmm::byte_align_r_128<12>(w2, w3);
-
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
-            xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 32, y2);
-
-            src += 16;
-            dst += 16;
-        }
-        count %= 16;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = S24(static_cast<S32>(std::clamp<float>(src[i] * scale, mini, maxi)));
-        }
+        return Kernels().DeinterleaveCopy(dst, src, channels, count);
     }
 
-    void ConvertCopy(S32* __restrict dst, const S16* __restrict src, size_t count) noexcept
+    void Mix(F32* __restrict dst, const F32* __restrict src, size_t count, float mix) noexcept
     {
-#ifdef __AVX2__
-        const auto zerov = xmm::zero<xmm::vi16x8>();
-        for (size_t i = 0; i < count / 8; i++)
-        {
-            auto x = xmm::load_u<xmm::vi16x8>(src);
-            auto y0 = xmm::reinterpret<xmm::vi32x4>(xmm::unpack_lo(zerov, x));
-            auto y1 = xmm::reinterpret<xmm::vi32x4>(xmm::unpack_hi(zerov, x));
-            xmm::store_u<xmm::vi32x4>(dst + 0, y0);
-            xmm::store_u<xmm::vi32x4>(dst + 4, y1);
-            src += 8;
-            dst += 8;
-        }
-        count %= 8;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<S32>(src[i]) << 16;
-        }
+        return Kernels().Mix(dst, src, count, mix);
     }
 
-    void ConvertCopy(S32* __restrict dst, const S24* __restrict src, size_t count) noexcept
+    void MixStereo(F32Stereo* __restrict dst, const F32Stereo* __restrict src, size_t count, float lch_mix, float rch_mix) noexcept
     {
-#ifdef __AVX2__
-        for (size_t i = 0; i < count / 16; i++)
-        {
-            auto x0 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 0);
-            auto x1 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 16);
-            auto x2 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 32);
-
-            auto y0 = xmm::byte_shuffle_128(x0, xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-            auto y1 = xmm::byte_shuffle_128(xmm::byte_align_r_128<12>(x0, x1), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-            auto y2 = xmm::byte_shuffle_128(xmm::byte_align_r_128<8>(x1, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-            auto y3 = xmm::byte_shuffle_128(xmm::byte_align_r_128<4>(x2, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-
-            xmm::store_u<xmm::vu8x16>(dst + 0, y0);
-            xmm::store_u<xmm::vu8x16>(dst + 4, y1);
-            xmm::store_u<xmm::vu8x16>(dst + 8, y2);
-            xmm::store_u<xmm::vu8x16>(dst + 12, y3);
-
-            src += 16;
-            dst += 16;
-        }
-        count %= 16;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<S32>(src[i]) << 8;
-        }
+        return Kernels().MixStereo(dst, src, count, lch_mix, rch_mix);
     }
 
-    void ConvertCopy(S32* __restrict dst, const F32* __restrict src, size_t count) noexcept
+    void MixChannels(F32* __restrict dst, size_t dst_channels, const F32* __restrict src, size_t src_channels, const float* __restrict matrix, size_t count) noexcept
     {
-        const float scale = 0x1p31f; // = 1 << 31
-        const float maxi = std::nextafter(+scale, -1.0f);
-        const float mini = std::nextafter(-scale, +1.0f);
-
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x4(scale);
-        const auto maxiv = xmm::f32x4(maxi);
-        const auto miniv = xmm::f32x4(mini);
-        for (size_t i = 0; i < count / 4; i++)
-        {
-            auto x = xmm::load_u<xmm::vf32x4>(src);
-            auto w = xmm::clamp(x * scalev, miniv, maxiv);
-            auto y = xmm::convert_cast<xmm::vi32x4>(w);
-            xmm::store_u<xmm::vi32x4>(dst, y);
-            src += 4;
-            dst += 4;
-        }
-        count %= 4;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<S32>(std::clamp<float>(src[i] * scale, mini, maxi));
-        }
+        return Kernels().MixChannels(dst, dst_channels, src, src_channels, matrix, count);
     }
 
-    void ConvertCopy(F32* __restrict dst, const S16* __restrict src, size_t count) noexcept
+    void ProcessHardLimit(F32* dst, const F32* src, size_t count, float multiplier, float limit) noexcept
     {
-        const float scale = 0x1p-15f; // = 1 / (1 << 15)
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x4(scale);
-        for (size_t i = 0; i < count / 8; i++)
-        {
-            auto x = xmm::load_u<xmm::vi16x8>(src);
-            auto w0 = xmm::convert_cast<xmm::vi32x4>(x);
-            auto w1 = xmm::convert_cast<xmm::vi32x4>(xmm::byte_shift_r_128<8>(x));
-            auto y0 = xmm::convert_cast<xmm::vf32x4>(w0);
-            auto y1 = xmm::convert_cast<xmm::vf32x4>(w1);
-            y0 *= scalev;
-            y1 *= scalev;
-            xmm::store_u<xmm::vf32x4>(dst + 0, y0);
-            xmm::store_u<xmm::vf32x4>(dst + 4, y1);
-            src += 8;
-            dst += 8;
-        }
-        count %= 8;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<float>(src[i]) * scale;
-        }
+        return Kernels().ProcessHardLimit(dst, src, count, multiplier, limit);
     }
 
-    void ConvertCopy(F32* __restrict dst, const S24* __restrict src, size_t count) noexcept
+    void ComputeFramePeaks(float* __restrict peaks, const F32* __restrict src, size_t channels, size_t frames) noexcept
     {
-        const float scale = 0x1p-23f; // = 1 / (1 << 23)
-
-#ifdef __AVX2__
-        for (size_t i = 0; i < count / 16; i++)
-        {
-            const auto scalev = xmm::f32x4(0x1p-31f);
-            auto x0 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 0);
-            auto x1 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 16);
-            auto x2 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 32);
-
-            auto t0 = xmm::byte_shuffle_128(x0, xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-            auto t1 = xmm::byte_shuffle_128(xmm::byte_align_r_128<12>(x0, x1), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-            auto t2 = xmm::byte_shuffle_128(xmm::byte_align_r_128<8>(x1, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-            auto t3 = xmm::byte_shuffle_128(xmm::byte_align_r_128<4>(x2, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
-
-            auto y0 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t0)) * scalev;
-            auto y1 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t1)) * scalev;
-            auto y2 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t2)) * scalev;
-            auto y3 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t3)) * scalev;
-
-            xmm::store_u<xmm::vf32x4>(dst + 0, y0);
-            xmm::store_u<xmm::vf32x4>(dst + 4, y1);
-            xmm::store_u<xmm::vf32x4>(dst + 8, y2);
-            xmm::store_u<xmm::vf32x4>(dst + 12, y3);
-
-            src += 16;
-            dst += 16;
-        }
-        count %= 16;
-#endif
-
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<float>(static_cast<S32>(src[i])) * scale;
-        }
+        return Kernels().ComputeFramePeaks(peaks, src, channels, frames);
     }
 
-    void ConvertCopy(F32* __restrict dst, const S32* __restrict src, size_t count) noexcept
+    void ComputeChannelStatistics(float* __restrict peaks, float* __restrict sums_of_squares, const F32* __restrict src, size_t channels, size_t frames) noexcept
     {
-        const float scale = 0x1p-31f; // = 1 / (1 << 31)
-
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x4(scale);
-        for (size_t i = 0; i < count / 4; i++)
-        {
-            auto x = xmm::load_u<xmm::vi32x4>(src);
-            auto t = xmm::convert_cast<xmm::vf32x4>(x);
-            auto y = t * scalev;
-            xmm::store_u<xmm::vf32x4>(dst, y);
-            src += 4;
-            dst += 4;
-        }
-        count %= 4;
-#endif
+        return Kernels().ComputeChannelStatistics(peaks, sums_of_squares, src, channels, frames);
+    }
 
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = static_cast<float>(src[i]) * scale;
-        }
+    void ApplyFrameGain(F32* dst, const F32* src, const float* __restrict gains, size_t channels, size_t frames, float limit) noexcept
+    {
+        return Kernels().ApplyFrameGain(dst, src, gains, channels, frames, limit);
     }
 
-    void Mix(F32* __restrict dst, const F32* __restrict src, size_t count, float mix) noexcept
+    void ProcessBiquadCascade(F32* dst, const F32* src, size_t channels, size_t frames, const float (*coefficients)[5], BiquadState* states, size_t stages) noexcept
     {
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x8(mix);
-        for (size_t i = 0; i < count / 8; i++)
-        {
-            auto s = xmm::load_u<xmm::vf32x8>(src);
-            auto d = xmm::load_u<xmm::vf32x8>(dst);
-            d = d + s * scalev;
-            xmm::store_u<xmm::vf32x8>(dst, d);
-            src += 8;
-            dst += 8;
-        }
-        count %= 8;
-#endif
+        return Kernels().ProcessBiquadCascade(dst, src, channels, frames, coefficients, states, stages);
+    }
 
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] += src[i] * mix;
-        }
+    void ResamplePolyphase(F32* __restrict dst, size_t dst_stride, const F32* __restrict src, const F32* __restrict coefficients, size_t taps, size_t phase_count, size_t phase_step, size_t& index, size_t& phase, size_t count) noexcept
+    {
+        return Kernels().ResamplePolyphase(dst, dst_stride, src, coefficients, taps, phase_count, phase_step, index, phase, count);
     }
 
-    void MixStereo(F32Stereo* __restrict dst, const F32Stereo* __restrict src, size_t count, float lch_mix, float rch_mix) noexcept
+    void MultiplyAccumulateComplex(float* __restrict acc_re, float* __restrict acc_im, const float* __restrict a_re, const float* __restrict a_im, const float* __restrict b_re, const float* __restrict b_im, size_t count) noexcept
     {
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x8(lch_mix, rch_mix, lch_mix, rch_mix, lch_mix, rch_mix, lch_mix, rch_mix);
-        for (size_t i = 0; i < count / 4; i++)
-        {
-            auto s = xmm::load_u<xmm::vf32x8>(src);
-            auto d = xmm::load_u<xmm::vf32x8>(dst);
-            d = d + s * scalev;
-            xmm::store_u<xmm::vf32x8>(dst, d);
-            src += 4;
-            dst += 4;
-        }
-        count %= 4;
-#endif
+        return Kernels().MultiplyAccumulateComplex(acc_re, acc_im, a_re, a_im, b_re, b_im, count);
+    }
 
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i].l += src[i].l * lch_mix;
-            dst[i].r += src[i].r * rch_mix;
-        }
+    void FastLog2(float* __restrict dst, const float* __restrict src, size_t count) noexcept
+    {
+        return Kernels().FastLog2(dst, src, count);
     }
 
-    void ProcessHardLimit(F32* dst, const F32* src, size_t count, float multiplier, float limit) noexcept
+    void FastExp2(float* __restrict dst, const float* __restrict src, size_t count) noexcept
     {
-#ifdef __AVX2__
-        const auto scalev = xmm::f32x8(multiplier);
-        const auto maxv = xmm::f32x8(+limit);
-        const auto minv = xmm::f32x8(-limit);
-        for (size_t i = 0; i < count / 8; i++)
-        {
-            xmm::store_u<xmm::vf32x8>(dst, xmm::clamp(xmm::load_u<xmm::vf32x8>(src) * scalev, minv, maxv));
-            src += 8;
-            dst += 8;
-        }
-        count %= 8;
-#endif
+        return Kernels().FastExp2(dst, src, count);
+    }
 
-        for (size_t i = 0; i < count; i++)
-        {
-            dst[i] = std::clamp<float>(src[i] * multiplier, -limit, limit);
-        }
+    void InterpolateDelayTaps(F32* __restrict dst, const F32* __restrict src, const float* __restrict delays, size_t count) noexcept
+    {
+        return Kernels().InterpolateDelayTaps(dst, src, delays, count);
     }
 }
@@ -8,6 +8,28 @@
 
 namespace vse::processing
 {
+    /// Instruction set of the waveform kernels.
+    enum struct KernelTarget
+    {
+        Auto = 0,
+        Sse2 = 1,
+        Sse41 = 2,
+        Avx2 = 3,
+        Avx512 = 4,
+    };
+
+    /// Gets the instruction set the kernels run on. Selected by CPUID at startup.
+    [[nodiscard]] KernelTarget GetKernelTarget() noexcept;
+
+    /// Gets the name of the instruction set the kernels run on.
+    [[nodiscard]] const char* GetKernelTargetName() noexcept;
+
+    /// Overrides the kernel instruction set (e.g. for testing the fallbacks).
+    /// If the CPU doesn't support the target, the best supported one below it is selected. Auto selects the best supported.
+    /// Not synchronized with kernels running on other threads; those finish on the previous target.
+    /// @returns the selected target.
+    KernelTarget SetKernelTarget(KernelTarget target) noexcept;
+
     template <class T>
     static inline void Copy(void* __restrict dst, const void* __restrict src, const size_t count) noexcept
     {
@@ -44,14 +66,97 @@ namespace vse::processing
     void ConvertCopy(S24* __restrict dst, const F32* __restrict src, size_t count) noexcept;
     void ConvertCopy(S32* __restrict dst, const S16* __restrict src, size_t count) noexcept;
     void ConvertCopy(S32* __restrict dst, const S24* __restrict src, size_t count) noexcept;
-    void ConvertCopy(S32* __restrict dst, const F32* __restrict src, size_t count) noexcept;
+    void ConvertCopy(S32* dst, const F32* src, size_t count) noexcept; ///< dst may be src (in place).
     void ConvertCopy(F32* __restrict dst, const S16* __restrict src, size_t count) noexcept;
     void ConvertCopy(F32* __restrict dst, const S24* __restrict src, size_t count) noexcept;
-    void ConvertCopy(F32* __restrict dst, const S32* __restrict src, size_t count) noexcept;
+    void ConvertCopy(F32* dst, const S32* src, size_t count) noexcept; ///< dst may be src (in place).
+
+    /// State of the dithered float to integer conversion, kept across calls.
+    struct DitherState
+    {
+        static constexpr size_t MaxChannels = 32;
 
+        /// Error feedback coefficients: {0, 0} for flat TPDF dither, {1, 0} for first-order, {2, -1} for second-order noise shaping.
+        float shaping[2]{};
+
+        /// xorshift32 states, one per SIMD lane. must be non-zero.
+        uint32_t random[8]{0x9E3779B9, 0x7F4A7C15, 0x85EBCA6B, 0xC2B2AE35, 0x27D4EB2F, 0x165667B1, 0xD3A2646C, 0xFD7046C5};
+
+        /// Last two quantization errors of each channel (in LSB), for noise shaping.
+        float error[MaxChannels][2]{};
+
+        /// Channel index of the next sample.
+        size_t channel{};
+    };
+
+    /// Converts with TPDF dither of +-1 LSB and optional noise shaping (see DitherState::shaping).
+    /// @param channels interleaved channel count. must be 1..DitherState::MaxChannels if noise shaping is enabled.
+    void ConvertCopyDithered(S16* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept;
+    void ConvertCopyDithered(S24* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept;
+
+    /// Interleaves planar channels into dst. (dst[i * channels + c] = src[c][i])
+    void InterleaveCopy(F32* __restrict dst, const F32* const* __restrict src, size_t channels, size_t count) noexcept;
+
+    /// Deinterleaves src into planar channels. (dst[c][i] = src[i * channels + c])
+    void DeinterleaveCopy(F32* const* __restrict dst, const F32* __restrict src, size_t channels, size_t count) noexcept;
 
     void Mix(F32* __restrict dst, const F32* __restrict src, size_t count, float mix) noexcept;
     void MixStereo(F32Stereo* __restrict dst, const F32Stereo* __restrict src, size_t count, float lch_mix, float rch_mix) noexcept;
 
+    /// Mixes channels by matrix. (dst[i * dst_channels + o] = sum(matrix[o * src_channels + c] * src[i * src_channels + c]))
+    void MixChannels(F32* __restrict dst, size_t dst_channels, const F32* __restrict src, size_t src_channels, const float* __restrict matrix, size_t count) noexcept;
+
     void ProcessHardLimit(F32* dst, const F32* src, size_t count, float multiplier, float limit) noexcept;
+
+    /// Gets the peak of each interleaved frame. (peaks[i] = max(abs(src[i * channels + c])))
+    void ComputeFramePeaks(float* __restrict peaks, const F32* __restrict src, size_t channels, size_t frames) noexcept;
+
+    /// Gets the peak and the sum of squares of each interleaved channel. (peaks[c] = max(abs(src[i * channels + c])), sums_of_squares[c] = sum(src[i * channels + c]^2))
+    void ComputeChannelStatistics(float* __restrict peaks, float* __restrict sums_of_squares, const F32* __restrict src, size_t channels, size_t frames) noexcept;
+
+    /// Applies the gain of each interleaved frame. (dst[i * channels + c] = clamp(src[i * channels + c] * gains[i], -limit, +limit))
+    void ApplyFrameGain(F32* dst, const F32* src, const float* __restrict gains, size_t channels, size_t frames, float limit) noexcept;
+
+    /// State of biquad filter on interleaved channels, kept across calls.
+    struct BiquadState
+    {
+        static constexpr size_t MaxChannels = 8;
+        float x1[MaxChannels]{};
+        float x2[MaxChannels]{};
+        float y1[MaxChannels]{};
+        float y2[MaxChannels]{};
+    };
+
+    /// Cascade of biquad IIR filters (direct form I) on each interleaved channel: y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2, stage by stage.
+    /// All stages run on each frame in one pass over the buffer; channels of a frame are processed together in SIMD lanes (2, 4 and 8 channels).
+    /// @param channels 1..BiquadState::MaxChannels
+    /// @param coefficients {b0, b1, b2, a1, a2} of each stage, normalized by a0.
+    /// @param states state of each stage.
+    void ProcessBiquadCascade(F32* dst, const F32* src, size_t channels, size_t frames, const float (*coefficients)[5], BiquadState* states, size_t stages) noexcept;
+
+    /// Biquad IIR filter on each interleaved channel (a cascade of one stage).
+    inline void ProcessBiquad(F32* dst, const F32* src, size_t channels, size_t frames, const float (&coefficients)[5], BiquadState& state) noexcept
+    {
+        return ProcessBiquadCascade(dst, src, channels, frames, &coefficients, &state, 1);
+    }
+
+    /// Polyphase FIR resampling of a single planar channel.
+    /// For each output sample i: dst[i * dst_stride] = sum(src[index + k] * coefficients[phase * taps + k]) (k = 0..taps-1),
+    /// then phase advances by phase_step and carries into index, per phase_count phases per input sample.
+    /// @param index,phase current source position. updated to the position after the last output.
+    void ResamplePolyphase(F32* __restrict dst, size_t dst_stride, const F32* __restrict src, const F32* __restrict coefficients, size_t taps, size_t phase_count, size_t phase_step, size_t& index, size_t& phase, size_t count) noexcept;
+
+    /// Approximate log2(x) (absolute error < 1e-5). x <= FLT_MIN is treated as FLT_MIN.
+    void FastLog2(float* __restrict dst, const float* __restrict src, size_t count) noexcept;
+
+    /// Approximate 2^x (relative error < 1e-6). x is clamped into [-126, +126].
+    void FastExp2(float* __restrict dst, const float* __restrict src, size_t count) noexcept;
+
+    /// Complex multiply-accumulate on split (real/imaginary) arrays. (acc[i] += a[i] * b[i])
+    void MultiplyAccumulateComplex(float* __restrict acc_re, float* __restrict acc_im, const float* __restrict a_re, const float* __restrict a_im, const float* __restrict b_re, const float* __restrict b_im, size_t count) noexcept;
+
+    /// Reads a delay line with fractional delays, linearly interpolated.
+    /// dst[i] = src[i - d] + (src[i - d - 1] - src[i - d]) * f, where d and f are the integer and fractional parts of delays[i] (>= 0).
+    /// @param src points just after the newest sample: src[-1] is the newest one.
+    void InterpolateDelayTaps(F32* __restrict dst, const F32* __restrict src, const float* __restrict delays, size_t count) noexcept;
 }
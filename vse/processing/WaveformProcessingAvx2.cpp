@@ -0,0 +1,15 @@
+/// @file
+/// @brief  Vse - Waveform processing kernels for AVX2 (Implementation helper)
+/// @author (C) 2022 ttsuki
+
+// 256-bit kernels. Compiled with /arch:AVX2 (see Vse.vcxproj).
+
+#if !defined(__AVX2__) && !defined(__RESHARPER__)
+#error This file must be compiled with /arch:AVX2.
+#endif
+
+#define VSE_PROCESSING_KERNEL_TABLE KernelTableAvx2
+#define VSE_PROCESSING_KERNEL_NAME "AVX2"
+#define VSE_PROCESSING_KERNEL_SSE41
+#define VSE_PROCESSING_KERNEL_AVX2
+#include "WaveformProcessingKernelsImpl.h"
@@ -0,0 +1,17 @@
+/// @file
+/// @brief  Vse - Waveform processing kernels for AVX-512 (Implementation helper)
+/// @author (C) 2022 ttsuki
+
+// The AVX2 kernels compiled with /arch:AVX512 (see Vse.vcxproj): EVEX encoding, 32 vector registers,
+// and 512-bit auto-vectorization of the scalar loops; sample format conversions have explicit 512-bit paths.
+
+#if !defined(__AVX512F__) && !defined(__RESHARPER__)
+#error This file must be compiled with /arch:AVX512.
+#endif
+
+#define VSE_PROCESSING_KERNEL_TABLE KernelTableAvx512
+#define VSE_PROCESSING_KERNEL_NAME "AVX-512"
+#define VSE_PROCESSING_KERNEL_SSE41
+#define VSE_PROCESSING_KERNEL_AVX2
+#define VSE_PROCESSING_KERNEL_AVX512
+#include "WaveformProcessingKernelsImpl.h"
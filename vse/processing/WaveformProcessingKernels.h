@@ -0,0 +1,62 @@
+/// @file
+/// @brief  Vse - Waveform processing kernel table (Implementation helper)
+/// @author (C) 2022 ttsuki
+
+#pragma once
+
+#include "../base/CommonTypes.h"
+
+namespace vse::processing
+{
+    struct DitherState;
+    struct BiquadState;
+}
+
+namespace vse::processing::kernels
+{
+    template <class TDst, class TSrc>
+    using ConvertCopyFunction = void (*)(TDst* __restrict dst, const TSrc* __restrict src, size_t count) noexcept;
+
+    /// Kernel entry points compiled for one instruction set.
+    struct KernelTable
+    {
+        const char* name;
+
+        ConvertCopyFunction<S16, S24> ConvertCopy_S16_S24;
+        ConvertCopyFunction<S16, S32> ConvertCopy_S16_S32;
+        ConvertCopyFunction<S16, F32> ConvertCopy_S16_F32;
+        ConvertCopyFunction<S24, S16> ConvertCopy_S24_S16;
+        ConvertCopyFunction<S24, S32> ConvertCopy_S24_S32;
+        ConvertCopyFunction<S24, F32> ConvertCopy_S24_F32;
+        ConvertCopyFunction<S32, S16> ConvertCopy_S32_S16;
+        ConvertCopyFunction<S32, S24> ConvertCopy_S32_S24;
+        ConvertCopyFunction<S32, F32> ConvertCopy_S32_F32;
+        ConvertCopyFunction<F32, S16> ConvertCopy_F32_S16;
+        ConvertCopyFunction<F32, S24> ConvertCopy_F32_S24;
+        ConvertCopyFunction<F32, S32> ConvertCopy_F32_S32;
+        void (*ConvertCopyDithered_S16_F32)(S16* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept;
+        void (*ConvertCopyDithered_S24_F32)(S24* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept;
+
+        void (*InterleaveCopy)(F32* __restrict dst, const F32* const* __restrict src, size_t channels, size_t count) noexcept;
+        void (*DeinterleaveCopy)(F32* const* __restrict dst, const F32* __restrict src, size_t channels, size_t count) noexcept;
+        void (*Mix)(F32* __restrict dst, const F32* __restrict src, size_t count, float mix) noexcept;
+        void (*MixStereo)(F32Stereo* __restrict dst, const F32Stereo* __restrict src, size_t count, float lch_mix, float rch_mix) noexcept;
+        void (*MixChannels)(F32* __restrict dst, size_t dst_channels, const F32* __restrict src, size_t src_channels, const float* __restrict matrix, size_t count) noexcept;
+        void (*ProcessHardLimit)(F32* dst, const F32* src, size_t count, float multiplier, float limit) noexcept;
+        void (*ComputeFramePeaks)(float* __restrict peaks, const F32* __restrict src, size_t channels, size_t frames) noexcept;
+        void (*ComputeChannelStatistics)(float* __restrict peaks, float* __restrict sums_of_squares, const F32* __restrict src, size_t channels, size_t frames) noexcept;
+        void (*ApplyFrameGain)(F32* dst, const F32* src, const float* __restrict gains, size_t channels, size_t frames, float limit) noexcept;
+        void (*ProcessBiquadCascade)(F32* dst, const F32* src, size_t channels, size_t frames, const float (*coefficients)[5], BiquadState* states, size_t stages) noexcept;
+        void (*ResamplePolyphase)(F32* __restrict dst, size_t dst_stride, const F32* __restrict src, const F32* __restrict coefficients, size_t taps, size_t phase_count, size_t phase_step, size_t& index, size_t& phase, size_t count) noexcept;
+        void (*MultiplyAccumulateComplex)(float* __restrict acc_re, float* __restrict acc_im, const float* __restrict a_re, const float* __restrict a_im, const float* __restrict b_re, const float* __restrict b_im, size_t count) noexcept;
+        void (*FastLog2)(float* __restrict dst, const float* __restrict src, size_t count) noexcept;
+        void (*FastExp2)(float* __restrict dst, const float* __restrict src, size_t count) noexcept;
+        void (*InterpolateDelayTaps)(F32* __restrict dst, const F32* __restrict src, const float* __restrict delays, size_t count) noexcept;
+    };
+
+    // Defined in WaveformProcessing{Sse2,Sse41,Avx2,Avx512}.cpp, each compiled for its instruction set.
+    extern const KernelTable KernelTableSse2;
+    extern const KernelTable KernelTableSse41;
+    extern const KernelTable KernelTableAvx2;
+    extern const KernelTable KernelTableAvx512;
+}
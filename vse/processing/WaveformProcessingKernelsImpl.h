@@ -0,0 +1,1692 @@
+/// @file
+/// @brief  Vse - Waveform processing kernels (Implementation helper)
+/// @author (C) 2022 ttsuki
+
+// This file is included once by each of WaveformProcessing{Sse2,Sse41,Avx2,Avx512}.cpp,
+// which define the following macros and are compiled with the corresponding instruction set:
+//   VSE_PROCESSING_KERNEL_TABLE  name of the KernelTable to define.
+//   VSE_PROCESSING_KERNEL_NAME   instruction set name string.
+//   VSE_PROCESSING_KERNEL_SSE41  enables 128-bit SIMD paths (SSE4.1 and below).
+//   VSE_PROCESSING_KERNEL_AVX2   enables 256-bit SIMD paths.
+//   VSE_PROCESSING_KERNEL_AVX512 enables 512-bit SIMD paths (AVX-512 F/BW).
+//
+// Everything here has internal linkage: an inline function shared between those translation units
+// could be merged by the linker into the copy compiled for a wider instruction set,
+// so kernels avoid calling std:: inline functions (e.g. std::clamp) too.
+
+#include <cstring>
+
+#include "WaveformProcessingKernels.h"
+#include "WaveformProcessing.h"
+
+#if !defined(VSE_PROCESSING_KERNEL_TABLE) || !defined(VSE_PROCESSING_KERNEL_NAME)
+#error VSE_PROCESSING_KERNEL_TABLE and VSE_PROCESSING_KERNEL_NAME must be defined.
+#endif
+
+#ifdef __RESHARPER__
+#define VSE_PROCESSING_KERNEL_SSE41
+#define VSE_PROCESSING_KERNEL_AVX2
+#define VSE_PROCESSING_KERNEL_AVX512
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+#include "../base/arkxmm.h"
+using namespace arkana;
+#endif
+
+namespace vse::processing::kernels
+{
+    namespace
+    {
+        inline float Clamp(float v, float lo, float hi) noexcept { return v < lo ? lo : hi < v ? hi : v; }
+
+#if defined(VSE_PROCESSING_KERNEL_AVX2)
+        using vf32 = xmm::vf32x8;
+        using vi32 = xmm::vi32x8;
+        inline vf32 BroadcastF32(float v) noexcept { return xmm::f32x8(v); }
+        inline vi32 BitCastToI32(vf32 v) noexcept { return {_mm256_castps_si256(v.v)}; }
+        inline vf32 BitCastToF32(vi32 v) noexcept { return {_mm256_castsi256_ps(v.v)}; }
+        inline float Sum(vf32 v) noexcept
+        {
+            v = xmm::horizontal_add(v, v);
+            v = xmm::horizontal_add(v, v);
+            return xmm::extract_element<0>(v) + xmm::extract_element<4>(v);
+        }
+#elif defined(VSE_PROCESSING_KERNEL_SSE41)
+        using vf32 = xmm::vf32x4;
+        using vi32 = xmm::vi32x4;
+        inline vf32 BroadcastF32(float v) noexcept { return xmm::f32x4(v); }
+        inline vi32 BitCastToI32(vf32 v) noexcept { return {_mm_castps_si128(v.v)}; }
+        inline vf32 BitCastToF32(vi32 v) noexcept { return {_mm_castsi128_ps(v.v)}; }
+        inline float Sum(vf32 v) noexcept
+        {
+            v = xmm::horizontal_add(v, v);
+            v = xmm::horizontal_add(v, v);
+            return xmm::extract_element<0>(v);
+        }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+        constexpr size_t F32Lanes = sizeof(vf32) / sizeof(float);
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+        // Loads 16 S24 samples (48 bytes) into the upper 24 bits of each element (= S32 layout).
+        inline xmm::vi32x16 LoadS24x16(const S24* src) noexcept
+        {
+            auto x = xmm::load_u_masked<xmm::vu8x64>(src, 0x0000FFFFFFFFFFFF);
+            x = xmm::permute32(x, xmm::i32x16(0, 1, 2, 3, 3, 4, 5, 6, 6, 7, 8, 9, 9, 10, 11, 12));
+            x = xmm::byte_shuffle_128(x, xmm::i8x64(xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11)));
+            return xmm::reinterpret<xmm::vi32x16>(x);
+        }
+
+        // Stores the upper 24 bits of each element as 16 S24 samples (48 bytes).
+        inline void StoreS24x16(S24* dst, xmm::vi32x16 v) noexcept
+        {
+            auto x = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x64>(v), xmm::i8x64(xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1)));
+            x = xmm::permute32(x, xmm::i32x16(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0, 0, 0, 0));
+            xmm::store_u_masked<xmm::vu8x64>(dst, x, 0x0000FFFFFFFFFFFF);
+        }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+        // Loads 32 S24 samples (96 bytes) into the upper 24 bits of each element (= S32 layout).
+        inline void LoadS24x32(const S24* src, xmm::vi32x8 (&y)[4]) noexcept
+        {
+            const auto* p = reinterpret_cast<const std::byte*>(src);
+            const auto shuffle = xmm::i8x32(xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+            y[0] = xmm::reinterpret<xmm::vi32x8>(xmm::byte_shuffle_128(xmm::permute32<0, 1, 2, 3, 3, 4, 5, 6>(xmm::load_u<xmm::vu8x32>(p + 0)), shuffle));
+            y[1] = xmm::reinterpret<xmm::vi32x8>(xmm::byte_shuffle_128(xmm::permute32<0, 1, 2, 3, 3, 4, 5, 6>(xmm::load_u<xmm::vu8x32>(p + 24)), shuffle));
+            y[2] = xmm::reinterpret<xmm::vi32x8>(xmm::byte_shuffle_128(xmm::permute32<0, 1, 2, 3, 3, 4, 5, 6>(xmm::load_u<xmm::vu8x32>(p + 48)), shuffle));
+            y[3] = xmm::reinterpret<xmm::vi32x8>(xmm::byte_shuffle_128(xmm::permute32<2, 3, 4, 5, 5, 6, 7, 0>(xmm::load_u<xmm::vu8x32>(p + 64)), shuffle)); // the last 24 bytes without over-reading
+        }
+
+        // Stores the upper 24 bits of each element as 32 S24 samples (96 bytes).
+        inline void StoreS24x32(S24* dst, const xmm::vi32x8 (&x)[4]) noexcept
+        {
+            auto* p = reinterpret_cast<std::byte*>(dst);
+            const auto shuffle = xmm::i8x32(xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1));
+            auto s0 = xmm::byte_shuffle_128(x[0], shuffle); // 24 bytes in dwords {0,1,2|4,5,6}
+            auto s1 = xmm::byte_shuffle_128(x[1], shuffle);
+            auto s2 = xmm::byte_shuffle_128(x[2], shuffle);
+            auto s3 = xmm::byte_shuffle_128(x[3], shuffle);
+
+            auto y0 = xmm::blend<0xC0>(xmm::permute32<0, 1, 2, 4, 5, 6, 0, 0>(s0), xmm::permute32<0, 0, 0, 0, 0, 0, 0, 1>(s1));
+            auto y1 = xmm::blend<0xF0>(xmm::permute32<2, 4, 5, 6, 0, 0, 0, 0>(s1), xmm::permute32<0, 0, 0, 0, 0, 1, 2, 4>(s2));
+            auto y2 = xmm::blend<0xFC>(xmm::permute32<5, 6, 0, 0, 0, 0, 0, 0>(s2), xmm::permute32<0, 0, 0, 1, 2, 4, 5, 6>(s3));
+
+            xmm::store_u<xmm::vi32x8>(p + 0, y0);
+            xmm::store_u<xmm::vi32x8>(p + 32, y1);
+            xmm::store_u<xmm::vi32x8>(p + 64, y2);
+        }
+
+        // Packs 16 elements to S16 in element order.
+        inline xmm::vi16x16 PackS16x16(xmm::vi32x8 a, xmm::vi32x8 b) noexcept
+        {
+            auto packed = xmm::reinterpret<xmm::vi32x8>(xmm::pack_sat_i(a, b)); // {a0-3,b0-3|a4-7,b4-7}
+            return xmm::reinterpret<xmm::vi16x16>(xmm::permute32<0, 1, 4, 5, 2, 3, 6, 7>(packed));
+        }
+#endif
+
+        void ConvertCopy(S16* __restrict dst, const S32* __restrict src, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                xmm::store_u<xmm::vi16x16>(dst, xmm::convert_cast<xmm::vi16x16>(xmm::load_u<xmm::vi32x16>(src) >> 16));
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                xmm::store_u<xmm::vi16x16>(
+                    dst, PackS16x16(
+                        xmm::load_u<xmm::vi32x8>(src + 0) >> 16,
+                        xmm::load_u<xmm::vi32x8>(src + 8) >> 16));
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (size_t i = 0; i < count / 8; i++)
+            {
+                xmm::store_u<xmm::vi16x8>(
+                    dst, xmm::pack_sat_i(
+                        xmm::load_u<xmm::vi32x4>(src + 0) >> 16,
+                        xmm::load_u<xmm::vi32x4>(src + 4) >> 16));
+
+                src += 8;
+                dst += 8;
+            }
+            count %= 8;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<S16>(src[i] >> 16);
+            }
+        }
+
+        void ConvertCopy(S16* __restrict dst, const S24* __restrict src, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                xmm::store_u<xmm::vi16x16>(dst, xmm::convert_cast<xmm::vi16x16>(LoadS24x16(src) >> 16));
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            for (size_t i = 0; i < count / 32; i++)
+            {
+                xmm::vi32x8 x[4];
+                LoadS24x32(src, x);
+                xmm::store_u<xmm::vi16x16>(dst + 0, PackS16x16(x[0] >> 16, x[1] >> 16));
+                xmm::store_u<xmm::vi16x16>(dst + 16, PackS16x16(x[2] >> 16, x[3] >> 16));
+
+                src += 32;
+                dst += 32;
+            }
+            count %= 32;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                auto x0 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 0);
+                auto x1 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 16);
+                auto x2 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 32);
+
+                auto y0 = xmm::byte_align_r_128<6>(
+                    xmm::byte_shuffle_128(x0, xmm::i8x16(-1, -1, -1, -1, -1, -1, 1, 2, 4, 5, 7, 8, 10, 11, 13, 14)),
+                    xmm::byte_shuffle_128(x1, xmm::i8x16(0, 1, 3, 4, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+
+                auto y1 = xmm::byte_align_r_128<11>(
+                    xmm::byte_shuffle_128(x1, xmm::i8x16(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 10, 12, 13, 15)),
+                    xmm::byte_shuffle_128(x2, xmm::i8x16(0, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, -1, -1, -1, -1, -1)));
+
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<S16>(static_cast<S32>(src[i]) >> 8);
+            }
+        }
+
+        void ConvertCopy(S16* __restrict dst, const F32* __restrict src, size_t count) noexcept
+        {
+            constexpr float scale = 0x1p+15f;          // = 1 << 15
+            constexpr float maxi = +0x1.fffffep+14f;   // = nextafter(+scale, -1.0f)
+            constexpr float mini = -0x1.000002p+15f;   // = nextafter(-scale, -1.0f)
+
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            {
+                const auto scalev = xmm::f32x16(scale);
+                const auto maxiv = xmm::f32x16(maxi);
+                const auto miniv = xmm::f32x16(mini);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    auto w = xmm::clamp(xmm::load_u<xmm::vf32x16>(src) * scalev, miniv, maxiv);
+                    xmm::store_u<xmm::vi16x16>(dst, xmm::convert_cast<xmm::vi16x16>(xmm::convert_cast<xmm::vi32x16>(w)));
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            {
+                const auto scalev = xmm::f32x8(scale);
+                const auto maxiv = xmm::f32x8(maxi);
+                const auto miniv = xmm::f32x8(mini);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    auto w0 = xmm::clamp(xmm::load_u<xmm::vf32x8>(src + 0) * scalev, miniv, maxiv);
+                    auto w1 = xmm::clamp(xmm::load_u<xmm::vf32x8>(src + 8) * scalev, miniv, maxiv);
+                    xmm::store_u<xmm::vi16x16>(dst, PackS16x16(xmm::convert_cast<xmm::vi32x8>(w0), xmm::convert_cast<xmm::vi32x8>(w1)));
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = xmm::f32x4(scale);
+            const auto maxiv = xmm::f32x4(maxi);
+            const auto miniv = xmm::f32x4(mini);
+            for (size_t i = 0; i < count / 8; i++)
+            {
+                auto x0 = xmm::load_u<xmm::vf32x4>(src + 0);
+                auto x1 = xmm::load_u<xmm::vf32x4>(src + 4);
+                auto w0 = xmm::clamp(x0 * scalev, miniv, maxiv);
+                auto w1 = xmm::clamp(x1 * scalev, miniv, maxiv);
+                auto y0 = xmm::convert_cast<xmm::vi32x4>(w0);
+                auto y1 = xmm::convert_cast<xmm::vi32x4>(w1);
+                xmm::store_u<xmm::vi16x8>(dst, pack_sat_i(y0, y1));
+
+                src += 8;
+                dst += 8;
+            }
+            count %= 8;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<S16>(Clamp(src[i] * scale, mini, maxi));
+            }
+        }
+
+        void ConvertCopy(S24* __restrict dst, const S16* __restrict src, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                StoreS24x16(dst, xmm::convert_cast<xmm::vi32x16>(xmm::load_u<xmm::vi16x16>(src)) << 16);
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            for (size_t i = 0; i < count / 32; i++)
+            {
+                const xmm::vi32x8 x[4] = {
+                    xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src + 0)) << 16,
+                    xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src + 8)) << 16,
+                    xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src + 16)) << 16,
+                    xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src + 24)) << 16,
+                };
+                StoreS24x32(dst, x);
+
+                src += 32;
+                dst += 32;
+            }
+            count %= 32;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                auto x0 = xmm::load_u<xmm::vu8x16>(src + 0);
+                auto x1 = xmm::load_u<xmm::vu8x16>(src + 8);
+
+                auto y0 = xmm::byte_shuffle_128(x0, xmm::i8x16(-1, 0, 1, -1, 2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1));
+                auto y1 = xmm::byte_shuffle_128(xmm::byte_align_r_128<8>(x0, x1), xmm::i8x16(2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1, 10, 11, -1, 12));
+                auto y2 = xmm::byte_shuffle_128(x1, xmm::i8x16(5, -1, 6, 7, -1, 8, 9, -1, 10, 11, -1, 12, 13, -1, 14, 15));
+
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 32, y2);
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = S24(src[i] << 8);
+            }
+        }
+
+        void ConvertCopy(S24* __restrict dst, const S32* __restrict src, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                StoreS24x16(dst, xmm::load_u<xmm::vi32x16>(src));
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            for (size_t i = 0; i < count / 32; i++)
+            {
+                const xmm::vi32x8 x[4] = {
+                    xmm::load_u<xmm::vi32x8>(src + 0),
+                    xmm::load_u<xmm::vi32x8>(src + 8),
+                    xmm::load_u<xmm::vi32x8>(src + 16),
+                    xmm::load_u<xmm::vi32x8>(src + 24),
+                };
+                StoreS24x32(dst, x);
+
+                src += 32;
+                dst += 32;
+            }
+            count %= 32;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                auto x0 = xmm::load_u<xmm::vu8x16>(src + 0);
+                auto x1 = xmm::load_u<xmm::vu8x16>(src + 4);
+                auto x2 = xmm::load_u<xmm::vu8x16>(src + 8);
+                auto x3 = xmm::load_u<xmm::vu8x16>(src + 12);
+
+                auto t0 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x0), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
+                auto t1 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x1), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
+                auto t2 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x2), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
+                auto t3 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(x3), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
+
+                auto y0 = xmm::byte_align_r_128<4>(t0, t1);
+                auto y1 = xmm::byte_align_r_128<8>(t1, t2);
+                auto y2 = xmm::byte_align_r_128<12>(t2, t3);
+
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 32, y2);
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = S24(src[i] >> 8);
+            }
+        }
+
+        void ConvertCopy(S24* __restrict dst, const F32* __restrict src, size_t count) noexcept
+        {
+            constexpr float scale = 0x1p23f;           // = 1 << 23
+            constexpr float maxi = +0x1.fffffep+22f;   // = nextafter(+scale, -1.0f)
+            constexpr float mini = -0x1.fffffep+22f;   // = nextafter(-scale, +1.0f)
+
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            {
+                const auto scalev = xmm::f32x16(0x1p31f);
+                const auto maxiv = xmm::f32x16(+0x1.fffffep+30f);
+                const auto miniv = xmm::f32x16(-0x1.fffffep+30f);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    auto w = xmm::clamp(xmm::load_u<xmm::vf32x16>(src) * scalev, miniv, maxiv);
+                    StoreS24x16(dst, xmm::convert_cast<xmm::vi32x16>(w));
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            {
+                const auto scalev = xmm::f32x8(0x1p31f);
+                const auto maxiv = xmm::f32x8(+0x1.fffffep+30f); // = nextafter(+0x1p31f, -1.0f)
+                const auto miniv = xmm::f32x8(-0x1.fffffep+30f); // = nextafter(-0x1p31f, +1.0f)
+                for (size_t i = 0; i < count / 32; i++)
+                {
+                    const xmm::vi32x8 x[4] = {
+                        xmm::convert_cast<xmm::vi32x8>(xmm::clamp(xmm::load_u<xmm::vf32x8>(src + 0) * scalev, miniv, maxiv)),
+                        xmm::convert_cast<xmm::vi32x8>(xmm::clamp(xmm::load_u<xmm::vf32x8>(src + 8) * scalev, miniv, maxiv)),
+                        xmm::convert_cast<xmm::vi32x8>(xmm::clamp(xmm::load_u<xmm::vf32x8>(src + 16) * scalev, miniv, maxiv)),
+                        xmm::convert_cast<xmm::vi32x8>(xmm::clamp(xmm::load_u<xmm::vf32x8>(src + 24) * scalev, miniv, maxiv)),
+                    };
+                    StoreS24x32(dst, x);
+
+                    src += 32;
+                    dst += 32;
+                }
+                count %= 32;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = xmm::f32x4(0x1p31f);
+            const auto maxiv = xmm::f32x4(+0x1.fffffep+30f); // = nextafter(+0x1p31f, -1.0f)
+            const auto miniv = xmm::f32x4(-0x1.fffffep+30f); // = nextafter(-0x1p31f, +1.0f)
+
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                auto x0 = xmm::load_u<xmm::vf32x4>(src + 0);
+                auto x1 = xmm::load_u<xmm::vf32x4>(src + 4);
+                auto x2 = xmm::load_u<xmm::vf32x4>(src + 8);
+                auto x3 = xmm::load_u<xmm::vf32x4>(src + 12);
+
+                auto t0 = xmm::clamp(x0 * scalev, miniv, maxiv);
+                auto t1 = xmm::clamp(x1 * scalev, miniv, maxiv);
+                auto t2 = xmm::clamp(x2 * scalev, miniv, maxiv);
+                auto t3 = xmm::clamp(x3 * scalev, miniv, maxiv);
+
+                auto u0 = xmm::convert_cast<xmm::vi32x4>(t0);
+                auto u1 = xmm::convert_cast<xmm::vi32x4>(t1);
+                auto u2 = xmm::convert_cast<xmm::vi32x4>(t2);
+                auto u3 = xmm::convert_cast<xmm::vi32x4>(t3);
+
+                auto w0 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u0), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
+                auto w1 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u1), xmm::i8x16(1, 2, 3, 5, 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15));
+                auto w2 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u2), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
+                auto w3 = xmm::byte_shuffle_128(xmm::reinterpret<xmm::vu8x16>(u3), xmm::i8x16(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, 11, 13, 14, 15));
+
+                auto y0 = xmm::byte_align_r_128<4>(w0, w1);
+                auto y1 = xmm::byte_align_r_128<8>(w1, w2);
+                auto y2 = xmm::byte_align_r_128<12>(w2, w3);
+
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 0, y0);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 16, y1);
+                xmm::store_u<xmm::vu8x16>(reinterpret_cast<std::byte*>(dst) + 32, y2);
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = S24(static_cast<S32>(Clamp(src[i] * scale, mini, maxi)));
+            }
+        }
+
+        void ConvertCopy(S32* __restrict dst, const S16* __restrict src, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                xmm::store_u<xmm::vi32x16>(dst, xmm::convert_cast<xmm::vi32x16>(xmm::load_u<xmm::vi16x16>(src)) << 16);
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                xmm::store_u<xmm::vi32x8>(dst + 0, xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src + 0)) << 16);
+                xmm::store_u<xmm::vi32x8>(dst + 8, xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src + 8)) << 16);
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto zerov = xmm::zero<xmm::vi16x8>();
+            for (size_t i = 0; i < count / 8; i++)
+            {
+                auto x = xmm::load_u<xmm::vi16x8>(src);
+                auto y0 = xmm::reinterpret<xmm::vi32x4>(xmm::unpack_lo(zerov, x));
+                auto y1 = xmm::reinterpret<xmm::vi32x4>(xmm::unpack_hi(zerov, x));
+                xmm::store_u<xmm::vi32x4>(dst + 0, y0);
+                xmm::store_u<xmm::vi32x4>(dst + 4, y1);
+                src += 8;
+                dst += 8;
+            }
+            count %= 8;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<S32>(src[i]) << 16;
+            }
+        }
+
+        void ConvertCopy(S32* __restrict dst, const S24* __restrict src, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                xmm::store_u<xmm::vi32x16>(dst, LoadS24x16(src));
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            for (size_t i = 0; i < count / 32; i++)
+            {
+                xmm::vi32x8 x[4];
+                LoadS24x32(src, x);
+                xmm::store_u<xmm::vi32x8>(dst + 0, x[0]);
+                xmm::store_u<xmm::vi32x8>(dst + 8, x[1]);
+                xmm::store_u<xmm::vi32x8>(dst + 16, x[2]);
+                xmm::store_u<xmm::vi32x8>(dst + 24, x[3]);
+
+                src += 32;
+                dst += 32;
+            }
+            count %= 32;
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                auto x0 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 0);
+                auto x1 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 16);
+                auto x2 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 32);
+
+                auto y0 = xmm::byte_shuffle_128(x0, xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+                auto y1 = xmm::byte_shuffle_128(xmm::byte_align_r_128<12>(x0, x1), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+                auto y2 = xmm::byte_shuffle_128(xmm::byte_align_r_128<8>(x1, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+                auto y3 = xmm::byte_shuffle_128(xmm::byte_align_r_128<4>(x2, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+
+                xmm::store_u<xmm::vu8x16>(dst + 0, y0);
+                xmm::store_u<xmm::vu8x16>(dst + 4, y1);
+                xmm::store_u<xmm::vu8x16>(dst + 8, y2);
+                xmm::store_u<xmm::vu8x16>(dst + 12, y3);
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<S32>(src[i]) << 8;
+            }
+        }
+
+        void ConvertCopy(S32* dst, const F32* src, size_t count) noexcept
+        {
+            constexpr float scale = 0x1p31f;           // = 1 << 31
+            constexpr float maxi = +0x1.fffffep+30f;   // = nextafter(+scale, -1.0f)
+            constexpr float mini = -0x1.fffffep+30f;   // = nextafter(-scale, +1.0f)
+
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            {
+                const auto scalev = xmm::f32x16(scale);
+                const auto maxiv = xmm::f32x16(maxi);
+                const auto miniv = xmm::f32x16(mini);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    auto w = xmm::clamp(xmm::load_u<xmm::vf32x16>(src) * scalev, miniv, maxiv);
+                    xmm::store_u<xmm::vi32x16>(dst, xmm::convert_cast<xmm::vi32x16>(w));
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            {
+                const auto scalev = xmm::f32x8(scale);
+                const auto maxiv = xmm::f32x8(maxi);
+                const auto miniv = xmm::f32x8(mini);
+                for (size_t i = 0; i < count / 8; i++)
+                {
+                    auto w = xmm::clamp(xmm::load_u<xmm::vf32x8>(src) * scalev, miniv, maxiv);
+                    xmm::store_u<xmm::vi32x8>(dst, xmm::convert_cast<xmm::vi32x8>(w));
+                    src += 8;
+                    dst += 8;
+                }
+                count %= 8;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = xmm::f32x4(scale);
+            const auto maxiv = xmm::f32x4(maxi);
+            const auto miniv = xmm::f32x4(mini);
+            for (size_t i = 0; i < count / 4; i++)
+            {
+                auto x = xmm::load_u<xmm::vf32x4>(src);
+                auto w = xmm::clamp(x * scalev, miniv, maxiv);
+                auto y = xmm::convert_cast<xmm::vi32x4>(w);
+                xmm::store_u<xmm::vi32x4>(dst, y);
+                src += 4;
+                dst += 4;
+            }
+            count %= 4;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<S32>(Clamp(src[i] * scale, mini, maxi));
+            }
+        }
+
+        void ConvertCopy(F32* __restrict dst, const S16* __restrict src, size_t count) noexcept
+        {
+            const float scale = 0x1p-15f; // = 1 / (1 << 15)
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            {
+                const auto scalev = xmm::f32x16(scale);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    auto x = xmm::convert_cast<xmm::vi32x16>(xmm::load_u<xmm::vi16x16>(src));
+                    xmm::store_u<xmm::vf32x16>(dst, xmm::convert_cast<xmm::vf32x16>(x) * scalev);
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            {
+                const auto scalev = xmm::f32x8(scale);
+                for (size_t i = 0; i < count / 8; i++)
+                {
+                    auto x = xmm::convert_cast<xmm::vi32x8>(xmm::load_u<xmm::vi16x8>(src));
+                    xmm::store_u<xmm::vf32x8>(dst, xmm::convert_cast<xmm::vf32x8>(x) * scalev);
+                    src += 8;
+                    dst += 8;
+                }
+                count %= 8;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = xmm::f32x4(scale);
+            for (size_t i = 0; i < count / 8; i++)
+            {
+                auto x = xmm::load_u<xmm::vi16x8>(src);
+                auto w0 = xmm::convert_cast<xmm::vi32x4>(x);
+                auto w1 = xmm::convert_cast<xmm::vi32x4>(xmm::byte_shift_r_128<8>(x));
+                auto y0 = xmm::convert_cast<xmm::vf32x4>(w0);
+                auto y1 = xmm::convert_cast<xmm::vf32x4>(w1);
+                y0 *= scalev;
+                y1 *= scalev;
+                xmm::store_u<xmm::vf32x4>(dst + 0, y0);
+                xmm::store_u<xmm::vf32x4>(dst + 4, y1);
+                src += 8;
+                dst += 8;
+            }
+            count %= 8;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<float>(src[i]) * scale;
+            }
+        }
+
+        void ConvertCopy(F32* __restrict dst, const S24* __restrict src, size_t count) noexcept
+        {
+            const float scale = 0x1p-23f; // = 1 / (1 << 23)
+
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            {
+                const auto scalev = xmm::f32x16(0x1p-31f);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    xmm::store_u<xmm::vf32x16>(dst, xmm::convert_cast<xmm::vf32x16>(LoadS24x16(src)) * scalev);
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            {
+                const auto scalev = xmm::f32x8(0x1p-31f);
+                for (size_t i = 0; i < count / 32; i++)
+                {
+                    xmm::vi32x8 x[4];
+                    LoadS24x32(src, x);
+                    xmm::store_u<xmm::vf32x8>(dst + 0, xmm::convert_cast<xmm::vf32x8>(x[0]) * scalev);
+                    xmm::store_u<xmm::vf32x8>(dst + 8, xmm::convert_cast<xmm::vf32x8>(x[1]) * scalev);
+                    xmm::store_u<xmm::vf32x8>(dst + 16, xmm::convert_cast<xmm::vf32x8>(x[2]) * scalev);
+                    xmm::store_u<xmm::vf32x8>(dst + 24, xmm::convert_cast<xmm::vf32x8>(x[3]) * scalev);
+
+                    src += 32;
+                    dst += 32;
+                }
+                count %= 32;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (size_t i = 0; i < count / 16; i++)
+            {
+                const auto scalev = xmm::f32x4(0x1p-31f);
+                auto x0 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 0);
+                auto x1 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 16);
+                auto x2 = xmm::load_u<xmm::vu8x16>(reinterpret_cast<const std::byte*>(src) + 32);
+
+                auto t0 = xmm::byte_shuffle_128(x0, xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+                auto t1 = xmm::byte_shuffle_128(xmm::byte_align_r_128<12>(x0, x1), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+                auto t2 = xmm::byte_shuffle_128(xmm::byte_align_r_128<8>(x1, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+                auto t3 = xmm::byte_shuffle_128(xmm::byte_align_r_128<4>(x2, x2), xmm::i8x16(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11));
+
+                auto y0 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t0)) * scalev;
+                auto y1 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t1)) * scalev;
+                auto y2 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t2)) * scalev;
+                auto y3 = xmm::convert_cast<xmm::vf32x4>(xmm::reinterpret<xmm::vi32x4>(t3)) * scalev;
+
+                xmm::store_u<xmm::vf32x4>(dst + 0, y0);
+                xmm::store_u<xmm::vf32x4>(dst + 4, y1);
+                xmm::store_u<xmm::vf32x4>(dst + 8, y2);
+                xmm::store_u<xmm::vf32x4>(dst + 12, y3);
+
+                src += 16;
+                dst += 16;
+            }
+            count %= 16;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<float>(static_cast<S32>(src[i])) * scale;
+            }
+        }
+
+        void ConvertCopy(F32* dst, const S32* src, size_t count) noexcept
+        {
+            const float scale = 0x1p-31f; // = 1 / (1 << 31)
+
+#ifdef VSE_PROCESSING_KERNEL_AVX512
+            {
+                const auto scalev = xmm::f32x16(scale);
+                for (size_t i = 0; i < count / 16; i++)
+                {
+                    xmm::store_u<xmm::vf32x16>(dst, xmm::convert_cast<xmm::vf32x16>(xmm::load_u<xmm::vi32x16>(src)) * scalev);
+                    src += 16;
+                    dst += 16;
+                }
+                count %= 16;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            {
+                const auto scalev = xmm::f32x8(scale);
+                for (size_t i = 0; i < count / 8; i++)
+                {
+                    xmm::store_u<xmm::vf32x8>(dst, xmm::convert_cast<xmm::vf32x8>(xmm::load_u<xmm::vi32x8>(src)) * scalev);
+                    src += 8;
+                    dst += 8;
+                }
+                count %= 8;
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = xmm::f32x4(scale);
+            for (size_t i = 0; i < count / 4; i++)
+            {
+                auto x = xmm::load_u<xmm::vi32x4>(src);
+                auto t = xmm::convert_cast<xmm::vf32x4>(x);
+                auto y = t * scalev;
+                xmm::store_u<xmm::vf32x4>(dst, y);
+                src += 4;
+                dst += 4;
+            }
+            count %= 4;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = static_cast<float>(src[i]) * scale;
+            }
+        }
+
+        inline uint32_t XorShift32(uint32_t x) noexcept
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return x;
+        }
+
+        // Generates TPDF dither in (-1, +1) LSB: the difference of two 16-bit uniform randoms.
+        void GenerateTpdf(float* __restrict dst, size_t count, uint32_t (&random)[8]) noexcept
+        {
+#if defined(VSE_PROCESSING_KERNEL_AVX2)
+            {
+                const auto scalev = xmm::f32x8(0x1p-16f);
+                auto r = xmm::load_u<xmm::vu32x8>(random);
+                for (size_t i = 0; i < count / 8; i++)
+                {
+                    r ^= r << 13;
+                    r ^= r >> 17;
+                    r ^= r << 5;
+                    auto d = xmm::reinterpret<xmm::vi32x8>(r & 0xFFFF) - xmm::reinterpret<xmm::vi32x8>(r >> 16);
+                    xmm::store_u<xmm::vf32x8>(dst, xmm::convert_cast<xmm::vf32x8>(d) * scalev);
+                    dst += 8;
+                }
+                xmm::store_u<xmm::vu32x8>(random, r);
+                count %= 8;
+            }
+#elif defined(VSE_PROCESSING_KERNEL_SSE41)
+            {
+                const auto scalev = xmm::f32x4(0x1p-16f);
+                auto r = xmm::load_u<xmm::vu32x4>(random);
+                for (size_t i = 0; i < count / 4; i++)
+                {
+                    r ^= r << 13;
+                    r ^= r >> 17;
+                    r ^= r << 5;
+                    auto d = xmm::reinterpret<xmm::vi32x4>(r & 0xFFFF) - xmm::reinterpret<xmm::vi32x4>(r >> 16);
+                    xmm::store_u<xmm::vf32x4>(dst, xmm::convert_cast<xmm::vf32x4>(d) * scalev);
+                    dst += 4;
+                }
+                xmm::store_u<xmm::vu32x4>(random, r);
+                count %= 4;
+            }
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                random[0] = XorShift32(random[0]);
+                dst[i] = static_cast<float>(static_cast<int32_t>(random[0] & 0xFFFF) - static_cast<int32_t>(random[0] >> 16)) * 0x1p-16f;
+            }
+        }
+
+        // Quantizes src to `bits`-bit integers with dither, into the upper bits of S32.
+        void QuantizeDithered(S32* __restrict dst, const F32* __restrict src, const float* __restrict dither, size_t count, int bits, size_t channels, DitherState& state) noexcept
+        {
+            const float scale = static_cast<float>(1 << (bits - 1));
+            const float maxi = scale - 1.0f;
+            const float mini = -scale;
+            const int shift = 32 - bits;
+
+            if (state.shaping[0] == 0.0f && state.shaping[1] == 0.0f)
+            {
+                state.channel = (state.channel + count) % channels;
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+                const vf32 scalev = BroadcastF32(scale);
+                const vf32 maxiv = BroadcastF32(maxi);
+                const vf32 miniv = BroadcastF32(mini);
+                for (size_t i = 0; i < count / F32Lanes; i++)
+                {
+                    auto v = xmm::load_u<vf32>(src) * scalev + xmm::load_u<vf32>(dither);
+                    auto q = xmm::round(xmm::clamp(v, miniv, maxiv));
+                    xmm::store_u<vi32>(dst, xmm::convert_cast<vi32>(q) << shift);
+                    src += F32Lanes;
+                    dither += F32Lanes;
+                    dst += F32Lanes;
+                }
+                count %= F32Lanes;
+#endif
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    float v = Clamp(src[i] * scale + dither[i], mini, maxi);
+                    dst[i] = static_cast<S32>(v < 0.0f ? v - 0.5f : v + 0.5f) << shift;
+                }
+                return;
+            }
+
+            // noise shaping: the error feedback runs serially in each channel.
+            const float c0 = state.shaping[0];
+            const float c1 = state.shaping[1];
+            size_t channel = state.channel;
+            for (size_t i = 0; i < count; i++)
+            {
+                float* e = state.error[channel];
+                float w = src[i] * scale - c0 * e[0] - c1 * e[1];
+                float v = Clamp(w + dither[i], mini, maxi);
+                S32 q = static_cast<S32>(v < 0.0f ? v - 0.5f : v + 0.5f);
+                e[1] = e[0];
+                e[0] = Clamp(static_cast<float>(q) - w, -2.0f, +2.0f); // bounds the feedback while clipping.
+                dst[i] = q << shift;
+                if (++channel == channels) channel = 0;
+            }
+            state.channel = channel;
+        }
+
+        template <class TDst>
+        void ConvertCopyDithered(TDst* __restrict dst, const F32* __restrict src, size_t count, size_t channels, DitherState& state) noexcept
+        {
+            constexpr int bits = sizeof(TDst) * 8;
+            constexpr size_t block = 256;
+            float dither[block];
+            S32 quantized[block];
+
+            while (count)
+            {
+                const size_t n = count < block ? count : block;
+                GenerateTpdf(dither, n, state.random);
+                QuantizeDithered(quantized, src, dither, n, bits, channels, state);
+                ConvertCopy(dst, quantized, n);
+                src += n;
+                dst += n;
+                count -= n;
+            }
+        }
+
+        void InterleaveCopy(F32* __restrict dst, const F32* const* __restrict src, size_t channels, size_t count) noexcept
+        {
+            if (channels == 1)
+            {
+                return Copy<F32>(dst, src[0], count);
+            }
+
+            if (channels == 2)
+            {
+                const F32* l = src[0];
+                const F32* r = src[1];
+
+#if defined(VSE_PROCESSING_KERNEL_AVX2)
+                for (size_t i = 0; i < count / 8; i++)
+                {
+                    auto x0 = xmm::load_u<xmm::vf32x8>(l);
+                    auto x1 = xmm::load_u<xmm::vf32x8>(r);
+                    auto t0 = xmm::unpack_lo(x0, x1); // l0 r0 l1 r1 | l4 r4 l5 r5
+                    auto t1 = xmm::unpack_hi(x0, x1); // l2 r2 l3 r3 | l6 r6 l7 r7
+                    xmm::store_u<xmm::vf32x8>(dst + 0, xmm::permute128<0, 2>(t0, t1));
+                    xmm::store_u<xmm::vf32x8>(dst + 8, xmm::permute128<1, 3>(t0, t1));
+                    l += 8;
+                    r += 8;
+                    dst += 16;
+                }
+                count %= 8;
+#elif defined(VSE_PROCESSING_KERNEL_SSE41)
+                for (size_t i = 0; i < count / 4; i++)
+                {
+                    auto x0 = xmm::load_u<xmm::vf32x4>(l);
+                    auto x1 = xmm::load_u<xmm::vf32x4>(r);
+                    xmm::store_u<xmm::vf32x4>(dst + 0, xmm::unpack_lo(x0, x1)); // l0 r0 l1 r1
+                    xmm::store_u<xmm::vf32x4>(dst + 4, xmm::unpack_hi(x0, x1)); // l2 r2 l3 r3
+                    l += 4;
+                    r += 4;
+                    dst += 8;
+                }
+                count %= 4;
+#endif
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    dst[i * 2 + 0] = l[i];
+                    dst[i * 2 + 1] = r[i];
+                }
+                return;
+            }
+
+            for (size_t i = 0; i < count; i++)
+                for (size_t c = 0; c < channels; c++)
+                    dst[i * channels + c] = src[c][i];
+        }
+
+        void DeinterleaveCopy(F32* const* __restrict dst, const F32* __restrict src, size_t channels, size_t count) noexcept
+        {
+            if (channels == 1)
+            {
+                return Copy<F32>(dst[0], src, count);
+            }
+
+            if (channels == 2)
+            {
+                F32* l = dst[0];
+                F32* r = dst[1];
+
+#if defined(VSE_PROCESSING_KERNEL_AVX2)
+                for (size_t i = 0; i < count / 8; i++)
+                {
+                    auto x0 = xmm::load_u<xmm::vf32x8>(src + 0); // l0 r0 l1 r1 | l2 r2 l3 r3
+                    auto x1 = xmm::load_u<xmm::vf32x8>(src + 8); // l4 r4 l5 r5 | l6 r6 l7 r7
+                    auto t0 = _mm256_shuffle_ps(x0.v, x1.v, _MM_SHUFFLE(2, 0, 2, 0)); // l0 l1 l4 l5 | l2 l3 l6 l7
+                    auto t1 = _mm256_shuffle_ps(x0.v, x1.v, _MM_SHUFFLE(3, 1, 3, 1)); // r0 r1 r4 r5 | r2 r3 r6 r7
+                    xmm::store_u<xmm::vf32x8>(l, {_mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(t0), _MM_SHUFFLE(3, 1, 2, 0)))});
+                    xmm::store_u<xmm::vf32x8>(r, {_mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(t1), _MM_SHUFFLE(3, 1, 2, 0)))});
+                    src += 16;
+                    l += 8;
+                    r += 8;
+                }
+                count %= 8;
+#elif defined(VSE_PROCESSING_KERNEL_SSE41)
+                for (size_t i = 0; i < count / 4; i++)
+                {
+                    auto x0 = xmm::load_u<xmm::vf32x4>(src + 0); // l0 r0 l1 r1
+                    auto x1 = xmm::load_u<xmm::vf32x4>(src + 4); // l2 r2 l3 r3
+                    xmm::store_u<xmm::vf32x4>(l, {_mm_shuffle_ps(x0.v, x1.v, _MM_SHUFFLE(2, 0, 2, 0))});
+                    xmm::store_u<xmm::vf32x4>(r, {_mm_shuffle_ps(x0.v, x1.v, _MM_SHUFFLE(3, 1, 3, 1))});
+                    src += 8;
+                    l += 4;
+                    r += 4;
+                }
+                count %= 4;
+#endif
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    l[i] = src[i * 2 + 0];
+                    r[i] = src[i * 2 + 1];
+                }
+                return;
+            }
+
+            for (size_t c = 0; c < channels; c++)
+                for (size_t i = 0; i < count; i++)
+                    dst[c][i] = src[i * channels + c];
+        }
+
+        void Mix(F32* __restrict dst, const F32* __restrict src, size_t count, float mix) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = BroadcastF32(mix);
+            for (size_t i = 0; i < count / F32Lanes; i++)
+            {
+                auto s = xmm::load_u<vf32>(src);
+                auto d = xmm::load_u<vf32>(dst);
+                d = d + s * scalev;
+                xmm::store_u<vf32>(dst, d);
+                src += F32Lanes;
+                dst += F32Lanes;
+            }
+            count %= F32Lanes;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] += src[i] * mix;
+            }
+        }
+
+        void MixStereo(F32Stereo* __restrict dst, const F32Stereo* __restrict src, size_t count, float lch_mix, float rch_mix) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const float scale[8] = {lch_mix, rch_mix, lch_mix, rch_mix, lch_mix, rch_mix, lch_mix, rch_mix};
+            const auto scalev = xmm::load_u<vf32>(scale);
+            for (size_t i = 0; i < count / (F32Lanes / 2); i++)
+            {
+                auto s = xmm::load_u<vf32>(src);
+                auto d = xmm::load_u<vf32>(dst);
+                d = d + s * scalev;
+                xmm::store_u<vf32>(dst, d);
+                src += F32Lanes / 2;
+                dst += F32Lanes / 2;
+            }
+            count %= F32Lanes / 2;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i].l += src[i].l * lch_mix;
+                dst[i].r += src[i].r * rch_mix;
+            }
+        }
+
+        void MixChannels(F32* __restrict dst, size_t dst_channels, const F32* __restrict src, size_t src_channels, const float* __restrict matrix, size_t count) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            if (dst_channels <= F32Lanes && src_channels <= 8)
+            {
+                // all output channels of a frame in one vector: out = sum(broadcast(in[c]) * column[c])
+                // the store writes F32Lanes floats, beyond the frame, then the next frame overwrites them.
+                vf32 column[8];
+                for (size_t c = 0; c < src_channels; c++)
+                {
+                    float col[F32Lanes]{};
+                    for (size_t o = 0; o < dst_channels; o++) col[o] = matrix[o * src_channels + c];
+                    column[c] = xmm::load_u<vf32>(col);
+                }
+
+                const size_t vector_count = count * dst_channels >= F32Lanes ? (count * dst_channels - F32Lanes) / dst_channels + 1 : 0;
+                for (size_t i = 0; i < vector_count; i++)
+                {
+                    auto acc = BroadcastF32(0.0f);
+                    for (size_t c = 0; c < src_channels; c++)
+                        acc = acc + BroadcastF32(src[c]) * column[c];
+                    xmm::store_u<vf32>(dst, acc);
+
+                    src += src_channels;
+                    dst += dst_channels;
+                }
+                count -= vector_count;
+            }
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                for (size_t o = 0; o < dst_channels; o++)
+                {
+                    float acc = 0.0f;
+                    for (size_t c = 0; c < src_channels; c++)
+                        acc += matrix[o * src_channels + c] * src[c];
+                    dst[o] = acc;
+                }
+
+                src += src_channels;
+                dst += dst_channels;
+            }
+        }
+
+        void ProcessHardLimit(F32* dst, const F32* src, size_t count, float multiplier, float limit) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto scalev = BroadcastF32(multiplier);
+            const auto maxv = BroadcastF32(+limit);
+            const auto minv = BroadcastF32(-limit);
+            for (size_t i = 0; i < count / F32Lanes; i++)
+            {
+                xmm::store_u<vf32>(dst, xmm::clamp(xmm::load_u<vf32>(src) * scalev, minv, maxv));
+                src += F32Lanes;
+                dst += F32Lanes;
+            }
+            count %= F32Lanes;
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[i] = Clamp(src[i] * multiplier, -limit, limit);
+            }
+        }
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+        // {m0, m2, m4, ...} ++ {n0, n2, n4, ...}
+        inline vf32 PackEvenLanes(vf32 m, vf32 n) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            return xmm::permute32<0, 1, 4, 5, 2, 3, 6, 7>(xmm::blend<0b11001100>(xmm::shuffle32<0, 2, 0, 2>(m), xmm::shuffle32<0, 2, 0, 2>(n)));
+#else
+            return xmm::blend<0b1100>(xmm::shuffle32<0, 2, 0, 2>(m), xmm::shuffle32<0, 2, 0, 2>(n));
+#endif
+        }
+
+        // {g0, g0, g1, g1, ...}, {..., gN-1, gN-1}
+        inline void DuplicateLanes(vf32 g, vf32* lo, vf32* hi) noexcept
+        {
+            const vf32 l = xmm::unpack_lo(g, g);
+            const vf32 h = xmm::unpack_hi(g, g);
+#ifdef VSE_PROCESSING_KERNEL_AVX2
+            *lo = xmm::permute128<0, 2>(l, h);
+            *hi = xmm::permute128<1, 3>(l, h);
+#else
+            *lo = l;
+            *hi = h;
+#endif
+        }
+#endif
+
+        void ComputeFramePeaks(float* __restrict peaks, const F32* __restrict src, size_t channels, size_t frames) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            if (channels == 1)
+            {
+                for (size_t i = 0; i < frames / F32Lanes; i++)
+                {
+                    xmm::store_u<vf32>(peaks, xmm::abs(xmm::load_u<vf32>(src)));
+                    src += F32Lanes;
+                    peaks += F32Lanes;
+                }
+                frames %= F32Lanes;
+            }
+            else if (channels == 2)
+            {
+                // F32Lanes frames in two vectors: max(l, r) of each pair, packed into one.
+                for (size_t i = 0; i < frames / F32Lanes; i++)
+                {
+                    const vf32 a = xmm::abs(xmm::load_u<vf32>(src));
+                    const vf32 b = xmm::abs(xmm::load_u<vf32>(src + F32Lanes));
+                    const vf32 m = xmm::max(a, xmm::shuffle32<1, 0, 3, 2>(a));
+                    const vf32 n = xmm::max(b, xmm::shuffle32<1, 0, 3, 2>(b));
+                    xmm::store_u<vf32>(peaks, PackEvenLanes(m, n));
+                    src += F32Lanes * 2;
+                    peaks += F32Lanes;
+                }
+                frames %= F32Lanes;
+            }
+#endif
+
+            for (size_t i = 0; i < frames; i++)
+            {
+                float peak = 0.0f;
+                for (size_t c = 0; c < channels; c++)
+                {
+                    const float v = src[c] < 0.0f ? -src[c] : src[c];
+                    peak = peak < v ? v : peak;
+                }
+                peaks[i] = peak;
+                src += channels;
+            }
+        }
+
+        void ComputeChannelStatistics(float* __restrict peaks, float* __restrict sums_of_squares, const F32* __restrict src, size_t channels, size_t frames) noexcept
+        {
+            for (size_t c = 0; c < channels; c++)
+            {
+                peaks[c] = 0.0f;
+                sums_of_squares[c] = 0.0f;
+            }
+
+            size_t count = channels * frames;
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            if (channels <= F32Lanes && F32Lanes % channels == 0)
+            {
+                // lane l accumulates the channel l % channels.
+                vf32 peak = BroadcastF32(0.0f);
+                vf32 sum = BroadcastF32(0.0f);
+                for (size_t i = 0; i < count / F32Lanes; i++)
+                {
+                    const vf32 v = xmm::load_u<vf32>(src);
+                    peak = xmm::max(peak, xmm::abs(v));
+                    sum = sum + v * v;
+                    src += F32Lanes;
+                }
+                count %= F32Lanes;
+
+                float p[F32Lanes], s[F32Lanes];
+                xmm::store_u<vf32>(p, peak);
+                xmm::store_u<vf32>(s, sum);
+                for (size_t l = 0; l < F32Lanes; l++)
+                {
+                    peaks[l % channels] = peaks[l % channels] < p[l] ? p[l] : peaks[l % channels];
+                    sums_of_squares[l % channels] += s[l];
+                }
+            }
+#endif
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const size_t c = i % channels;
+                const float v = src[i] < 0.0f ? -src[i] : src[i];
+                peaks[c] = peaks[c] < v ? v : peaks[c];
+                sums_of_squares[c] += src[i] * src[i];
+            }
+        }
+
+        void ApplyFrameGain(F32* dst, const F32* src, const float* __restrict gains, size_t channels, size_t frames, float limit) noexcept
+        {
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const auto maxv = BroadcastF32(+limit);
+            const auto minv = BroadcastF32(-limit);
+            if (channels == 1)
+            {
+                for (size_t i = 0; i < frames / F32Lanes; i++)
+                {
+                    xmm::store_u<vf32>(dst, xmm::clamp(xmm::load_u<vf32>(src) * xmm::load_u<vf32>(gains), minv, maxv));
+                    src += F32Lanes;
+                    dst += F32Lanes;
+                    gains += F32Lanes;
+                }
+                frames %= F32Lanes;
+            }
+            else if (channels == 2)
+            {
+                for (size_t i = 0; i < frames / F32Lanes; i++)
+                {
+                    vf32 lo, hi;
+                    DuplicateLanes(xmm::load_u<vf32>(gains), &lo, &hi);
+                    xmm::store_u<vf32>(dst, xmm::clamp(xmm::load_u<vf32>(src) * lo, minv, maxv));
+                    xmm::store_u<vf32>(dst + F32Lanes, xmm::clamp(xmm::load_u<vf32>(src + F32Lanes) * hi, minv, maxv));
+                    src += F32Lanes * 2;
+                    dst += F32Lanes * 2;
+                    gains += F32Lanes;
+                }
+                frames %= F32Lanes;
+            }
+#endif
+
+            for (size_t i = 0; i < frames; i++)
+            {
+                for (size_t c = 0; c < channels; c++)
+                    dst[c] = Clamp(src[c] * gains[i], -limit, limit);
+                src += channels;
+                dst += channels;
+            }
+        }
+
+        // Stages of ProcessBiquadCascade run in one pass. longer cascades take a pass per this many stages.
+        constexpr size_t BiquadPassStages = 16;
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+        // Biquad cascade on the channels packed in V, from `channel`. Load/Store move the channels of one frame.
+        template <class V, class Load, class Store>
+        void ProcessBiquadLanes(F32* dst, const F32* src, size_t stride, size_t frames, const float (*coefficients)[5], BiquadState* states, size_t stages, size_t channel, Load load, Store store) noexcept
+        {
+            V c[BiquadPassStages][5]; // b0, b1, b2, a1, a2
+            V s[BiquadPassStages][4]; // x1, x2, y1, y2
+            for (size_t k = 0; k < stages; k++)
+            {
+                for (size_t j = 0; j < 5; j++) c[k][j] = xmm::broadcast<V>(coefficients[k][j]);
+                s[k][0] = load(states[k].x1 + channel);
+                s[k][1] = load(states[k].x2 + channel);
+                s[k][2] = load(states[k].y1 + channel);
+                s[k][3] = load(states[k].y2 + channel);
+            }
+
+            src += channel;
+            dst += channel;
+            for (size_t i = 0; i < frames; i++)
+            {
+                V x = load(src);
+                for (size_t k = 0; k < stages; k++)
+                {
+                    V y = c[k][0] * x + c[k][1] * s[k][0] + c[k][2] * s[k][1] - c[k][3] * s[k][2] - c[k][4] * s[k][3];
+                    s[k][1] = s[k][0];
+                    s[k][0] = x;
+                    s[k][3] = s[k][2];
+                    s[k][2] = y;
+                    x = y;
+                }
+                store(dst, x);
+                src += stride;
+                dst += stride;
+            }
+
+            for (size_t k = 0; k < stages; k++)
+            {
+                store(states[k].x1 + channel, s[k][0]);
+                store(states[k].x2 + channel, s[k][1]);
+                store(states[k].y1 + channel, s[k][2]);
+                store(states[k].y2 + channel, s[k][3]);
+            }
+        }
+#endif
+
+        void ProcessBiquadPass(F32* dst, const F32* src, size_t channels, size_t frames, const float (*coefficients)[5], BiquadState* states, size_t stages) noexcept
+        {
+#if defined(VSE_PROCESSING_KERNEL_AVX2)
+            if (channels == 8)
+            {
+                return ProcessBiquadLanes<xmm::vf32x8>(
+                    dst, src, channels, frames, coefficients, states, stages, 0,
+                    [](const float* p) { return xmm::load_u<xmm::vf32x8>(p); },
+                    [](float* p, xmm::vf32x8 v) { xmm::store_u<xmm::vf32x8>(p, v); });
+            }
+#endif
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            if (channels == 4 || channels == 8)
+            {
+                for (size_t c = 0; c < channels; c += 4)
+                {
+                    ProcessBiquadLanes<xmm::vf32x4>(
+                        dst, src, channels, frames, coefficients, states, stages, c,
+                        [](const float* p) { return xmm::load_u<xmm::vf32x4>(p); },
+                        [](float* p, xmm::vf32x4 v) { xmm::store_u<xmm::vf32x4>(p, v); });
+                }
+                return;
+            }
+
+            if (channels == 2)
+            {
+                return ProcessBiquadLanes<xmm::vf32x4>(
+                    dst, src, channels, frames, coefficients, states, stages, 0,
+                    [](const float* p) { return xmm::load_lo64<xmm::vf32x4>(p); },
+                    [](float* p, xmm::vf32x4 v) { xmm::store_lo64<xmm::vf32x4>(p, v); });
+            }
+#endif
+
+            // other channel counts: one pass over the frames, channel by channel in each frame.
+            for (size_t i = 0; i < frames; i++)
+            {
+                for (size_t c = 0; c < channels; c++)
+                {
+                    float x = src[c];
+                    for (size_t k = 0; k < stages; k++)
+                    {
+                        const float* h = coefficients[k];
+                        BiquadState& r = states[k];
+                        float y = h[0] * x + h[1] * r.x1[c] + h[2] * r.x2[c] - h[3] * r.y1[c] - h[4] * r.y2[c];
+                        r.x2[c] = r.x1[c];
+                        r.x1[c] = x;
+                        r.y2[c] = r.y1[c];
+                        r.y1[c] = y;
+                        x = y;
+                    }
+                    dst[c] = x;
+                }
+                src += channels;
+                dst += channels;
+            }
+        }
+
+        void ProcessBiquadCascade(F32* dst, const F32* src, size_t channels, size_t frames, const float (*coefficients)[5], BiquadState* states, size_t stages) noexcept
+        {
+            if (stages == 0)
+            {
+                if (dst != src)
+                    for (size_t i = 0; i < frames * channels; i++) dst[i] = src[i];
+                return;
+            }
+
+            for (size_t k = 0; k < stages; k += BiquadPassStages)
+            {
+                const size_t n = stages - k < BiquadPassStages ? stages - k : BiquadPassStages;
+                ProcessBiquadPass(dst, src, channels, frames, coefficients + k, states + k, n);
+                src = dst; // the following passes run in place.
+            }
+        }
+
+        void ResamplePolyphase(F32* __restrict dst, size_t dst_stride, const F32* __restrict src, const F32* __restrict coefficients, size_t taps, size_t phase_count, size_t phase_step, size_t& index, size_t& phase, size_t count) noexcept
+        {
+            const size_t index_step = phase_step / phase_count;
+            const size_t phase_frac = phase_step % phase_count;
+
+            size_t idx = index;
+            size_t ph = phase;
+            for (size_t i = 0; i < count; i++)
+            {
+                const F32* x = src + idx;
+                const F32* h = coefficients + ph * taps;
+                size_t n = taps;
+                float acc = 0.0f;
+
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+                auto acc0 = BroadcastF32(0.0f);
+                auto acc1 = BroadcastF32(0.0f);
+                for (; n >= F32Lanes * 2; n -= F32Lanes * 2, x += F32Lanes * 2, h += F32Lanes * 2)
+                {
+                    acc0 = acc0 + xmm::load_u<vf32>(x + 0) * xmm::load_u<vf32>(h + 0);
+                    acc1 = acc1 + xmm::load_u<vf32>(x + F32Lanes) * xmm::load_u<vf32>(h + F32Lanes);
+                }
+                for (; n >= F32Lanes; n -= F32Lanes, x += F32Lanes, h += F32Lanes)
+                {
+                    acc0 = acc0 + xmm::load_u<vf32>(x) * xmm::load_u<vf32>(h);
+                }
+                acc = Sum(acc0 + acc1);
+#endif
+
+                for (size_t k = 0; k < n; k++)
+                {
+                    acc += x[k] * h[k];
+                }
+
+                dst[i * dst_stride] = acc;
+
+                idx += index_step;
+                ph += phase_frac;
+                if (ph >= phase_count)
+                {
+                    ph -= phase_count;
+                    idx++;
+                }
+            }
+
+            index = idx;
+            phase = ph;
+        }
+
+        // log2(x) = e + log2(m), m in [1, 2): log2(m) = 2 / ln(2) * atanh(t), t = (m - 1) / (m + 1) in [0, 1/3).
+        void FastLog2(float* __restrict dst, const float* __restrict src, size_t count) noexcept
+        {
+            constexpr float c1 = 2.8853900817779268f; // 2 / ln(2)
+            constexpr float c3 = c1 / 3.0f;
+            constexpr float c5 = c1 / 5.0f;
+            constexpr float c7 = c1 / 7.0f;
+            constexpr float c9 = c1 / 9.0f;
+            constexpr float min = 1.17549435e-38f; // FLT_MIN
+
+            size_t i = 0;
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const vf32 minv = BroadcastF32(min);
+            const vf32 onev = BroadcastF32(1.0f);
+            const vi32 mantissa_mask = xmm::broadcast<vi32>(0x007FFFFF);
+            const vi32 one_bits = xmm::broadcast<vi32>(0x3F800000);
+            const vi32 bias = xmm::broadcast<vi32>(127);
+            for (; i + F32Lanes <= count; i += F32Lanes)
+            {
+                const vi32 bits = BitCastToI32(xmm::max(xmm::load_u<vf32>(src + i), minv));
+                const vf32 e = xmm::convert_cast<vf32>((bits >> 23) - bias);
+                const vf32 m = BitCastToF32((bits & mantissa_mask) | one_bits);
+                const vf32 t = (m - onev) / (m + onev);
+                const vf32 t2 = t * t;
+                const vf32 p = (((BroadcastF32(c9) * t2 + BroadcastF32(c7)) * t2 + BroadcastF32(c5)) * t2 + BroadcastF32(c3)) * t2 + BroadcastF32(c1);
+                xmm::store_u<vf32>(dst + i, e + t * p);
+            }
+#endif
+
+            for (; i < count; i++)
+            {
+                const float x = src[i] < min ? min : src[i];
+                uint32_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                const float e = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+                const uint32_t m_bits = (bits & 0x007FFFFF) | 0x3F800000;
+                float m;
+                std::memcpy(&m, &m_bits, sizeof(m));
+                const float t = (m - 1.0f) / (m + 1.0f);
+                const float t2 = t * t;
+                const float p = (((c9 * t2 + c7) * t2 + c5) * t2 + c3) * t2 + c1;
+                dst[i] = e + t * p;
+            }
+        }
+
+        // 2^x = 2^n * 2^f, n = round(x), f in [-0.5, 0.5]: 2^f by the Taylor series of exp(f * ln(2)) up to 6th order.
+        void FastExp2(float* __restrict dst, const float* __restrict src, size_t count) noexcept
+        {
+            constexpr float k1 = 0.69314718055994531f; // ln(2)
+            constexpr float k2 = k1 * k1 / 2.0f;
+            constexpr float k3 = k2 * k1 / 3.0f;
+            constexpr float k4 = k3 * k1 / 4.0f;
+            constexpr float k5 = k4 * k1 / 5.0f;
+            constexpr float k6 = k5 * k1 / 6.0f;
+
+            size_t i = 0;
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            const vf32 lo = BroadcastF32(-126.0f);
+            const vf32 hi = BroadcastF32(+126.0f);
+            const vi32 bias = xmm::broadcast<vi32>(127);
+            for (; i + F32Lanes <= count; i += F32Lanes)
+            {
+                const vf32 x = xmm::clamp(xmm::load_u<vf32>(src + i), lo, hi);
+                const vf32 n = xmm::round(x);
+                const vf32 f = x - n;
+                const vf32 p = (((((BroadcastF32(k6) * f + BroadcastF32(k5)) * f + BroadcastF32(k4)) * f + BroadcastF32(k3)) * f + BroadcastF32(k2)) * f + BroadcastF32(k1)) * f + BroadcastF32(1.0f);
+                const vf32 scale = BitCastToF32((xmm::convert_cast<vi32>(n) + bias) << 23);
+                xmm::store_u<vf32>(dst + i, p * scale);
+            }
+#endif
+
+            for (; i < count; i++)
+            {
+                const float x = Clamp(src[i], -126.0f, +126.0f);
+                const float n = static_cast<float>(static_cast<int32_t>(x < 0.0f ? x - 0.5f : x + 0.5f));
+                const float f = x - n;
+                const float p = (((((k6 * f + k5) * f + k4) * f + k3) * f + k2) * f + k1) * f + 1.0f;
+                const uint32_t scale_bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+                float scale;
+                std::memcpy(&scale, &scale_bits, sizeof(scale));
+                dst[i] = p * scale;
+            }
+        }
+
+        void MultiplyAccumulateComplex(float* __restrict acc_re, float* __restrict acc_im, const float* __restrict a_re, const float* __restrict a_im, const float* __restrict b_re, const float* __restrict b_im, size_t count) noexcept
+        {
+            size_t i = 0;
+#ifdef VSE_PROCESSING_KERNEL_SSE41
+            for (; i + F32Lanes <= count; i += F32Lanes)
+            {
+                const auto ar = xmm::load_u<vf32>(a_re + i);
+                const auto ai = xmm::load_u<vf32>(a_im + i);
+                const auto br = xmm::load_u<vf32>(b_re + i);
+                const auto bi = xmm::load_u<vf32>(b_im + i);
+                xmm::store_u<vf32>(acc_re + i, xmm::load_u<vf32>(acc_re + i) + ar * br - ai * bi);
+                xmm::store_u<vf32>(acc_im + i, xmm::load_u<vf32>(acc_im + i) + ar * bi + ai * br);
+            }
+#endif
+
+            for (; i < count; i++)
+            {
+                acc_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+                acc_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+            }
+        }
+
+        // taps are gathered by the delays computed in vector, then interpolated in vector.
+        void InterpolateDelayTaps(F32* __restrict dst, const F32* __restrict src, const float* __restrict delays, size_t count) noexcept
+        {
+            size_t i = 0;
+#if defined(VSE_PROCESSING_KERNEL_AVX2)
+            const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256 delay = _mm256_loadu_ps(delays + i);
+                const __m256 whole = _mm256_floor_ps(delay);
+                const __m256i index = _mm256_sub_epi32(_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), lane), _mm256_cvttps_epi32(whole)); // i - d
+                const xmm::vf32x8 a = {_mm256_i32gather_ps(src, index, sizeof(F32))};
+                const xmm::vf32x8 b = {_mm256_i32gather_ps(src - 1, index, sizeof(F32))};
+                xmm::store_u<xmm::vf32x8>(dst + i, a + (b - a) * xmm::vf32x8{_mm256_sub_ps(delay, whole)});
+            }
+#elif defined(VSE_PROCESSING_KERNEL_SSE41)
+            const __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 delay = _mm_loadu_ps(delays + i);
+                const __m128 whole = _mm_floor_ps(delay);
+                alignas(16) int32_t index[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_sub_epi32(_mm_add_epi32(_mm_set1_epi32(static_cast<int>(i)), lane), _mm_cvttps_epi32(whole))); // i - d
+                const xmm::vf32x4 a = {_mm_setr_ps(src[index[0]], src[index[1]], src[index[2]], src[index[3]])};
+                const xmm::vf32x4 b = {_mm_setr_ps(src[index[0] - 1], src[index[1] - 1], src[index[2] - 1], src[index[3] - 1])};
+                xmm::store_u<xmm::vf32x4>(dst + i, a + (b - a) * xmm::vf32x4{_mm_sub_ps(delay, whole)});
+            }
+#endif
+
+            for (; i < count; i++)
+            {
+                const auto d = static_cast<ptrdiff_t>(delays[i]);
+                const float f = delays[i] - static_cast<float>(d);
+                const F32 a = src[static_cast<ptrdiff_t>(i) - d];
+                const F32 b = src[static_cast<ptrdiff_t>(i) - d - 1];
+                dst[i] = a + (b - a) * f;
+            }
+        }
+    }
+
+    extern const KernelTable VSE_PROCESSING_KERNEL_TABLE = {
+        VSE_PROCESSING_KERNEL_NAME,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopy,
+        ConvertCopyDithered<S16>,
+        ConvertCopyDithered<S24>,
+        InterleaveCopy,
+        DeinterleaveCopy,
+        Mix,
+        MixStereo,
+        MixChannels,
+        ProcessHardLimit,
+        ComputeFramePeaks,
+        ComputeChannelStatistics,
+        ApplyFrameGain,
+        ProcessBiquadCascade,
+        ResamplePolyphase,
+        MultiplyAccumulateComplex,
+        FastLog2,
+        FastExp2,
+        InterpolateDelayTaps,
+    };
+}
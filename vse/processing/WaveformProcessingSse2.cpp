@@ -0,0 +1,9 @@
+/// @file
+/// @brief  Vse - Waveform processing kernels for SSE2 (Implementation helper)
+/// @author (C) 2022 ttsuki
+
+// Baseline: scalar loops, auto-vectorized by the compiler for the default instruction set.
+
+#define VSE_PROCESSING_KERNEL_TABLE KernelTableSse2
+#define VSE_PROCESSING_KERNEL_NAME "SSE2"
+#include "WaveformProcessingKernelsImpl.h"
@@ -0,0 +1,10 @@
+/// @file
+/// @brief  Vse - Waveform processing kernels for SSE4.1 (Implementation helper)
+/// @author (C) 2022 ttsuki
+
+// 128-bit kernels. MSVC has no /arch for SSE4.1; intrinsics are available without it.
+
+#define VSE_PROCESSING_KERNEL_TABLE KernelTableSse41
+#define VSE_PROCESSING_KERNEL_NAME "SSE4.1"
+#define VSE_PROCESSING_KERNEL_SSE41
+#include "WaveformProcessingKernelsImpl.h"